@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Compiles and times the Ode programs in this directory.
+
+Every benchmark is compiled by the given ode at each optimization level and
+run --runs times, pinned to one CPU where taskset is available. The median
+run time and the executable size go to stdout as JSON. Each result is
+compared against a stored run, and the script fails when one is slower by
+more than --threshold. Run times only compare on the same machine, so no
+baseline is committed: --save writes one, by default to
+benchmarks/baseline.json, which later runs read unless --baseline names
+another. --runtime=tiny links the benchmarks with the tiny runtime, which
+shows its effect on startup time and executable size.
+
+    benchmarks/run.py --ode build/ode --save    # before a change
+    benchmarks/run.py --ode build/ode           # after it
+"""
+
+import argparse
+import json
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+LEVELS = ["O0", "O1", "O2", "O3"]
+BASELINE = HERE / "baseline.json"
+
+
+def build(ode, source, level, runtime, workdir):
+    # ode writes its object files next to where it runs, so every build gets
+    # a directory of its own.
+    outdir = Path(workdir) / f"{source.stem}{level}"
+    outdir.mkdir()
+    executable = outdir / source.stem
+    subprocess.run([ode, f"-{level}", f"--runtime={runtime}", "-o",
+                    str(executable), str(source)],
+                   cwd=outdir, check=True)
+    return executable
+
+
+def measure(executable, runs, cpu):
+    command = [str(executable)]
+    if cpu is not None and shutil.which("taskset"):
+        command = ["taskset", "-c", str(cpu)] + command
+
+    times = []
+    output = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run(command, capture_output=True, text=True,
+                                check=True)
+        times.append(time.perf_counter() - start)
+        output = result.stdout
+    return statistics.median(times), output
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ode", default="build/ode")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--cpu", type=int, default=0,
+                        help="CPU to pin the benchmarks to; -1 to not pin")
+    parser.add_argument("--level", choices=LEVELS, action="append",
+                        help="only this optimization level, such as O2 (repeatable)")
+    parser.add_argument("--filter", default="",
+                        help="only benchmarks whose name contains this")
+    parser.add_argument("--runtime", choices=["default", "tiny"],
+                        default="default",
+                        help="runtime to link the benchmarks with")
+    parser.add_argument("--baseline", type=Path,
+                        help=f"results to compare against; {BASELINE.name} "
+                             "next to this script if it exists")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed slowdown against the baseline")
+    parser.add_argument("--save", type=Path, nargs="?", const=BASELINE,
+                        help="write the results as the new baseline, to "
+                             f"{BASELINE.name} next to this script by default")
+    args = parser.parse_args()
+    if not args.baseline and not args.save and BASELINE.exists():
+        args.baseline = BASELINE
+
+    ode = str(Path(args.ode).resolve())
+    cpu = None if args.cpu < 0 else args.cpu
+    sources = sorted(p for p in HERE.glob("*.ode") if args.filter in p.stem)
+
+    results = {}
+    failures = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for source in sources:
+            outputs = {}
+            for level in args.level or LEVELS:
+                executable = build(ode, source, level, args.runtime,
+                                   workdir)
+                seconds, output = measure(executable, args.runs, cpu)
+                results.setdefault(source.stem, {})[level] = {
+                    "median_seconds": round(seconds, 6),
+                    "binary_bytes": executable.stat().st_size,
+                }
+                outputs[level] = output
+                print(f"{source.stem:>12} {level}: {seconds:.4f} s",
+                      file=sys.stderr)
+
+            # Optimizations must not change what a program prints.
+            if len(set(outputs.values())) > 1:
+                failures.append(f"{source.stem}: output differs between "
+                                f"levels: {outputs}")
+
+    if args.baseline:
+        baseline = json.loads(args.baseline.read_text())
+        for name, levels in results.items():
+            for level, result in levels.items():
+                before = baseline.get(name, {}).get(level)
+                if not before:
+                    continue
+                ratio = result["median_seconds"] / before["median_seconds"]
+                result["vs_baseline"] = round(ratio, 3)
+                if ratio > 1 + args.threshold:
+                    failures.append(f"{name} {level}: {ratio:.2f}x slower "
+                                    "than the baseline")
+
+    print(json.dumps(results, indent=2))
+    if args.save:
+        args.save.write_text(json.dumps(results, indent=2) + "\n")
+
+    for failure in failures:
+        print(f"FAIL {failure}", file=sys.stderr)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Compares the time to first output of ode --interp and of a native build.
+
+For every program, the native path compiles with the given ode at -O0, links
+and starts the executable; the interpreted path runs ode --interp on the
+source. Each is timed from launch until the first byte reaches stdout,
+--runs times, and the medians go to stdout as JSON. Without sources, a
+program that only prints is used, which measures the fixed cost of each
+path; the kernels in this directory show where the interpreter stops paying
+off.
+
+    benchmarks/startup.py --ode build/ode
+    benchmarks/startup.py --ode build/ode benchmarks/primes.ode
+"""
+
+import argparse
+import json
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+HELLO = """fn main(): i32 {
+  print(42);
+  return 0;
+}
+"""
+
+
+def first_output(commands, cwd):
+    """Seconds from starting the first command until the last one prints."""
+    start = time.perf_counter()
+    for command in commands[:-1]:
+        subprocess.run(command, cwd=cwd, check=True)
+    process = subprocess.Popen(commands[-1], cwd=cwd,
+                               stdout=subprocess.PIPE)
+    first = process.stdout.read(1)
+    elapsed = time.perf_counter() - start
+    process.stdout.read()
+    if process.wait() != 0 or not first:
+        raise RuntimeError(f"{commands[-1]} failed or printed nothing")
+    return elapsed
+
+
+def measure(commands, cwd, runs):
+    return statistics.median(first_output(commands, cwd)
+                             for _ in range(runs))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ode", default="build/ode")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("sources", nargs="*", type=Path)
+    args = parser.parse_args()
+
+    ode = str(Path(args.ode).resolve())
+    results = {}
+    with tempfile.TemporaryDirectory() as workdir:
+        sources = [source.resolve() for source in args.sources]
+        if not sources:
+            hello = Path(workdir) / "hello.ode"
+            hello.write_text(HELLO)
+            sources = [hello]
+
+        for source in sources:
+            # ode writes its object files next to where it runs.
+            outdir = Path(workdir) / f"{source.stem}.out"
+            outdir.mkdir()
+            native = measure([[ode, "-O0", str(source)],
+                              [str(outdir / source.stem)]], outdir, args.runs)
+            interp = measure([[ode, "--interp", str(source)]], outdir,
+                             args.runs)
+            results[source.stem] = {
+                "native_seconds": round(native, 6),
+                "interp_seconds": round(interp, 6),
+                "speedup": round(native / interp, 3),
+            }
+            print(f"{source.stem:>12}: native {native:.4f} s, "
+                  f"interp {interp:.4f} s", file=sys.stderr)
+
+    print(json.dumps(results, indent=2))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
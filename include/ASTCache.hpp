@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "Parser/AST.hpp"
+#include "SemanticAnalyzer.hpp"
+
+// Saves the checked AST of a source file so that later compiles of the same
+// text can map it back in instead of lexing and parsing again. Files are
+// named after the hash of the source they were built from, so a changed
+// file simply misses.
+//
+// A cache file is a fixed header followed by flat, 4-byte aligned tables
+// that can be used in place from a read-only mapping:
+//
+//   nodes     kind, flags, location, checked type, and ranges of the
+//             token and child tables
+//   tokens    token type, location and an index into the string table
+//   children  node indices, with ~0 for an absent child
+//   strings   offsets, then the interned text of every token
+//
+// Children always come before their parent, and the root is the last node.
+// Which tokens and children a node has depends on its kind, in the order
+// the AST node's constructor takes them.
+class ASTCache {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  struct Key {
+    uint64_t hash = 0;
+    uint64_t size = 0;
+  };
+
+  static Key key(std::string_view source);
+  static std::filesystem::path path(const std::filesystem::path &directory,
+                                    const Key &key);
+
+  // Returns nullptr when there is no usable cache file for key. A file that
+  // is truncated, damaged or from another format version counts as missing.
+  static AST::NodePtr load(const std::filesystem::path &path, const Key &key);
+
+  // With analysis, expression nodes keep the types it recorded; see
+  // SemanticAnalyzer::recordExpressionTypes.
+  static void store(const std::filesystem::path &path, const Key &key,
+                    const AST::Node &root,
+                    const SemanticAnalyzer *analysis = nullptr);
+};
@@ -1,12 +1,63 @@
 #pragma once
 
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "ASTCache.hpp"
+#include "MemoryReport.hpp"
+#include "Options.hpp"
+#include "TimeReport.hpp"
+#include "Parser/AST.hpp"
+#include "SemanticAnalyzer.hpp"
 
 class Compiler {
 public:
-  explicit Compiler(const char *filePath);
-  void run();
+  explicit Compiler(Options options);
+  // Returns the exit status: nonzero only when an interpreted program's
+  // main returns it.
+  int run();
 
 private:
-  const char *filePath;
+  struct SourceModule {
+    std::string name;
+    std::filesystem::path path;
+    AST::NodePtr root;
+    std::vector<FunctionSignature> signatures;
+    ASTCache::Key cacheKey;
+    // Where to save the checked AST, when --ast-cache missed.
+    std::filesystem::path cachePath;
+  };
+
+  Options options;
+  std::unique_ptr<MemoryReport> memoryReport;
+  std::unique_ptr<TimeReport> timeReport;
+
+  // Attributes the time and heap traffic from here on to name in
+  // --time-report and --mem-report.
+  void startPhase(const std::string &name);
+
+  std::filesystem::path outputPath(const SourceModule &module,
+                                   const char *extension) const;
+  std::vector<std::filesystem::path>
+  importSearchPath(const SourceModule &module) const;
+  std::vector<FunctionSignature>
+  importedSignatures(const SourceModule &module, const Token &import,
+                     const std::vector<SourceModule> &program) const;
+  std::filesystem::path interfacePath(const SourceModule &module) const;
+  void printDependencies(const std::vector<SourceModule> &modules);
+  SourceModule parseModule(const std::string &filePath);
+  AST::NodePtr parseSource(const std::string &name, const std::string &text);
+  std::vector<FunctionSignature>
+  externalSignatures(const SourceModule &module,
+                     const std::vector<SourceModule> &program) const;
+  // Checks module and runs the AST passes over it.
+  std::unique_ptr<SemanticAnalyzer>
+  analyzeModule(SourceModule &module,
+                const std::vector<FunctionSignature> &externals);
+  void build(std::vector<SourceModule> &modules);
+  int interpret(std::vector<SourceModule> &modules);
+  std::vector<std::filesystem::path>
+  compileModule(SourceModule &module, const std::vector<SourceModule> &program);
 };
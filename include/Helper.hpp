@@ -45,6 +45,22 @@ constexpr std::string getTokenType(Token::Type tokenType) {
     return "FN";
   case Token::Type::While:
     return "WHILE";
+  case Token::Type::Parallel:
+    return "PARALLEL";
+  case Token::Type::For:
+    return "FOR";
+  case Token::Type::In:
+    return "IN";
+  case Token::Type::Reduce:
+    return "REDUCE";
+  case Token::Type::Async:
+    return "ASYNC";
+  case Token::Type::Await:
+    return "AWAIT";
+  case Token::Type::Spawn:
+    return "SPAWN";
+  case Token::Type::Struct:
+    return "STRUCT";
   case Token::Type::Equal:
     return "EQUAL";
   case Token::Type::Semicolon:
@@ -71,8 +87,16 @@ constexpr std::string getTokenType(Token::Type tokenType) {
     return "COMMA";
   case Token::Type::Return:
     return "RETURN";
+  case Token::Type::Tail:
+    return "TAIL";
   case Token::Type::Colon:
     return "COLON";
+  case Token::Type::DotDot:
+    return "DOTDOT";
+  case Token::Type::Dot:
+    return "DOT";
+  case Token::Type::At:
+    return "AT";
   case Token::Type::Type:
     return "TYPE";
   }
@@ -1,16 +1,26 @@
 #pragma once
+#include "Options.hpp"
 #include "Parser/AST.hpp"
 #include "SemanticAnalyzer.hpp"
 
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/ValueHandle.h>
+#include <llvm/Target/TargetMachine.h>
 
+#include <filesystem>
 #include <format>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 class IRGenerator : public AST::Visitor {
 public:
@@ -28,14 +38,78 @@ public:
               std::format("TODO: {} not yet implemented", feature)) {}
   };
 
-  explicit IRGenerator(const std::string &moduleName);
+  explicit IRGenerator(const std::string &moduleName, unsigned optLevel = 0);
 
-  void generate(const AST::Node &root);
-  void emitToFile(const std::string &filename);
-  void emitObjectFile(const std::string &filename);
+  // Emits DWARF describing source. With lineTablesOnly, only functions and
+  // line numbers are described, which is all profilers and backtraces need.
+  void enableDebugInfo(const std::filesystem::path &source,
+                       bool lineTablesOnly);
+  // Attaches source locations to the IR without emitting any debug info, so
+  // that optimization remarks can point at Ode code. Does nothing when debug
+  // info is already enabled.
+  void trackLocations(const std::filesystem::path &source);
+  // Frame pointers are kept by default so that sampling profilers can walk
+  // the stack without unwind tables.
+  void keepFramePointers(bool keep) { framePointers_ = keep; }
+  // Calls the runtime's profiling hooks on entry to and exit from every
+  // function, for the built-in profile written at exit.
+  void instrumentFunctions() { instrumentFunctions_ = true; }
+  // Generates position-dependent code with a section per function and
+  // global, for static executables linked with the tiny runtime. Features
+  // that need the default runtime, such as parallel loops and async
+  // functions, are rejected when generated.
+  void useTinyRuntime() { tinyRuntime_ = true; }
+  // Generates machine code at LLVM's default level instead of the one
+  // matching optLevel, as when no -O flag is given.
+  void useDefaultCodeGenLevel() { defaultCodeGenLevel_ = true; }
+  // Sets how arithmetic is compiled in functions without attributes of
+  // their own, and in the functions nested in those.
+  void setArithmetic(const Options::Arithmetic &arithmetic) {
+    useArithmetic(arithmetic);
+  }
+  void declareExternal(const FunctionSignature &signature);
+  void generate(const AST::Node &root, const SemanticAnalyzer &analysis);
+  // Gives every function except main internal linkage. Only valid when no
+  // other module needs to call into this one.
+  void internalizeFunctions();
+  void optimize(bool prepareForThinLTO = false);
+  // Output paths may be "-" for standard output.
+  void emitToFile(const std::filesystem::path &filename);
+  // Writes object code, or assembly, to outputs. With more than one output
+  // the module is split into that many partitions, compiled concurrently.
+  void emitMachineCode(const std::vector<std::filesystem::path> &outputs,
+                       bool assembly = false);
+  void emitBitcodeFile(const std::filesystem::path &filename,
+                       bool withSummary = false);
   void printIR();
 
   llvm::Module *getModule() { return module_.get(); }
+  // Hands the module over together with the context owning it, as the JIT
+  // wants them. Nothing else may be called afterwards.
+  std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>>
+  release();
+
+  // Entry points for --tiered, which keeps values in the interpreter's
+  // 32-bit cells: one per scalar or vector lane, struct fields in
+  // declaration order. Both take (ptr args, ptr result) and must be
+  // generated after the module itself.
+  struct CellVariable {
+    std::string name;
+    Type type;
+    unsigned cell;
+  };
+  // Calls function with its arguments read from cells.
+  void generateCellEntry(const std::string &name,
+                         const AST::FuncDeclNode &function,
+                         const SemanticAnalyzer &analysis);
+  // Finishes a call of function from the header of loop on: the variables
+  // in scope there are read from cells, by scope as the interpreter keeps
+  // them, parameters first and then one scope per enclosing block.
+  void generateLoopEntry(const std::string &name,
+                         const AST::FuncDeclNode &function,
+                         const AST::WhileStmtNode &loop,
+                         const std::vector<std::vector<CellVariable>> &scopes,
+                         const SemanticAnalyzer &analysis);
 
   void visit(const AST::ProgramNode &node) override;
   void visit(const AST::BlockNode &node) override;
@@ -43,13 +117,18 @@ public:
   void visit(const AST::AssignNode &node) override;
   void visit(const AST::IfStmtNode &node) override;
   void visit(const AST::WhileStmtNode &node) override;
+  void visit(const AST::ParallelForNode &node) override;
   void visit(const AST::FuncDeclNode &node) override;
+  void visit(const AST::StructDeclNode &node) override;
   void visit(const AST::FuncCallNode &node) override;
   void visit(const AST::ReturnStmtNode &node) override;
   void visit(const AST::PrintStmtNode &node) override;
+  void visit(const AST::SpawnStmtNode &node) override;
   void visit(const AST::ExprStmtNode &node) override;
   void visit(const AST::BinaryOpNode &node) override;
   void visit(const AST::UnaryOpNode &node) override;
+  void visit(const AST::AwaitNode &node) override;
+  void visit(const AST::FieldAccessNode &node) override;
   void visit(const AST::NumberNode &node) override;
   void visit(const AST::BooleanNode &node) override;
   void visit(const AST::IdentifierNode &node) override;
@@ -58,20 +137,138 @@ public:
   void visit(const AST::ArgListNode &node) override;
 
 private:
-  llvm::LLVMContext context_;
+  // Variables live directly in SSA registers. Definitions are tracked per
+  // block and PHIs are built on demand while the structured if/while code is
+  // emitted (Braun et al., "Simple and Efficient Construction of Static
+  // Single Assignment Form").
+  struct Variable {
+    std::string name;
+    llvm::Type *type;
+    std::unordered_map<llvm::BasicBlock *, llvm::WeakTrackingVH> definitions;
+    // Set with -g: every new definition is reported to the debugger.
+    llvm::DILocalVariable *debugVariable = nullptr;
+  };
+
+  struct SSAState {
+    std::vector<std::unordered_map<std::string, unsigned>> scopes;
+    std::vector<Variable> variables;
+    std::unordered_set<llvm::BasicBlock *> sealedBlocks;
+    std::unordered_map<llvm::BasicBlock *,
+                       std::vector<std::pair<unsigned, llvm::PHINode *>>>
+        incompletePhis;
+    std::unordered_set<llvm::PHINode *> phisUnderConstruction;
+  };
+
+  // The async function being generated. Async functions are lowered with
+  // LLVM's switch-resumed coroutine intrinsics: the ramp returns the frame
+  // handle, and the promise holds the awaiting coroutine followed by the
+  // result.
+  struct CoroutineState {
+    llvm::Value *id;
+    llvm::Value *handle;
+    llvm::Value *promise;
+    llvm::StructType *promiseType;
+    llvm::BasicBlock *finalBB;
+    llvm::BasicBlock *cleanupBB;
+    llvm::BasicBlock *suspendBB;
+  };
+
+  std::unique_ptr<llvm::LLVMContext> ownedContext_;
+  llvm::LLVMContext &context_;
   std::unique_ptr<llvm::Module> module_;
   llvm::IRBuilder<> builder_;
-  std::unordered_map<std::string, llvm::AllocaInst *> allocaMap_;
+  unsigned optLevel_;
+  std::unique_ptr<llvm::TargetMachine> targetMachine_;
+  SSAState ssa_;
+  const SemanticAnalyzer *analysis_ = nullptr;
   llvm::Function *currentFunc_ = nullptr;
   llvm::Value *exprValue_ = nullptr;
+  std::optional<CoroutineState> coroutine_;
+  std::unordered_map<std::string, llvm::Type *> asyncResultTypes_;
+  std::unordered_map<Type, llvm::StructType *> structTypes_;
+  std::unordered_map<llvm::Type *, Type> structOrigins_;
+  bool framePointers_ = true;
+  bool instrumentFunctions_ = false;
+  bool tinyRuntime_ = false;
+  bool defaultCodeGenLevel_ = false;
+  // That of the function being generated.
+  Options::Arithmetic arithmetic_;
 
+  // Debug info is only emitted when debugBuilder_ is set. debugScope_ is the
+  // innermost function or block being generated.
+  std::unique_ptr<llvm::DIBuilder> debugBuilder_;
+  llvm::DICompileUnit *debugUnit_ = nullptr;
+  llvm::DIScope *debugScope_ = nullptr;
+  bool lineTablesOnly_ = false;
+  std::unordered_map<Type, llvm::DIType *> debugTypes_;
+
+  void createDebugUnit(const std::filesystem::path &source,
+                       llvm::DICompileUnit::DebugEmissionKind emissionKind);
+  std::unique_ptr<llvm::TargetMachine> createTargetMachine() const;
+  llvm::TargetMachine *targetMachine();
   llvm::Type *getLLVMType(Type type);
-  llvm::AllocaInst *createEntryBlockAlloca(llvm::Function *func,
-                                           const std::string &name,
-                                           llvm::Type *type);
+  llvm::StructType *getStructType(Type type);
+  unsigned fieldSlot(llvm::Type *structType, const std::string &field) const;
+  void applyFunctionAttributes(llvm::Function *func, const FunctionInfo &info);
+
+  void enterScope();
+  void exitScope();
+  void declareVariable(const std::string &name, llvm::Type *type,
+                       llvm::Value *val);
+  std::optional<unsigned> findVariable(const std::string &name) const;
+  unsigned lookupVariable(const std::string &name) const;
   void storeVariable(const std::string &name, llvm::Value *val);
   llvm::Value *loadVariable(const std::string &name);
 
+  void writeVariable(unsigned var, llvm::BasicBlock *block, llvm::Value *val);
+  llvm::Value *readVariable(unsigned var, llvm::BasicBlock *block);
+  llvm::Value *readVariableRecursive(unsigned var, llvm::BasicBlock *block);
+  llvm::PHINode *createPhi(unsigned var, llvm::BasicBlock *block);
+  llvm::Value *addPhiOperands(unsigned var, llvm::PHINode *phi);
+  llvm::Value *tryRemoveTrivialPhi(llvm::PHINode *phi);
+  void sealBlock(llvm::BasicBlock *block);
+
+  void beginDebugFunction(llvm::Function *func, SourceLocation location,
+                          Type returnType, const std::vector<Type> &params);
+  llvm::DIScope *enterDebugBlock(const AST::Node &node);
+  void setDebugLocation(const AST::Node &node);
+  llvm::DIType *debugType(Type type);
+  void describeVariable(const std::string &name, SourceLocation location,
+                        Type type, unsigned argNo = 0);
+  void emitDebugValue(unsigned var, llvm::Value *val,
+                      llvm::BasicBlock::iterator position);
+  void finalizeDebugInfo();
+
   llvm::Value *generateExpr(const AST::Node *node);
-  llvm::Function *getPrintfFunction();
+  llvm::Value *lowerExpr(const AST::Node *node);
+  llvm::Value *generateBinaryOp(Token::Type op, llvm::Value *left,
+                                llvm::Value *right);
+  llvm::Value *generateMulAdd(const AST::BinaryOpNode &node);
+  llvm::Value *generateLogicalOp(const AST::BinaryOpNode &node);
+  Options::Arithmetic functionArithmetic(const AST::FuncDeclNode &node) const;
+  void useArithmetic(const Options::Arithmetic &arithmetic);
+  bool isBuiltinCall(const AST::FuncCallNode &node) const;
+  llvm::Value *generateBuiltinCall(const AST::FuncCallNode &node);
+  llvm::Value *generateStructConstruction(const AST::FuncCallNode &node,
+                                          Type type);
+  llvm::Function *getRuntimeFunction(const std::string &name,
+                                     llvm::FunctionType *type,
+                                     bool ownStateOnly = true);
+  void emitProfileEnter();
+  void emitProfileExit(llvm::Instruction *before = nullptr);
+
+  llvm::StructType *promiseType(llvm::Type *resultType);
+  void beginCoroutine(llvm::Function *func, llvm::Type *resultType);
+  void endCoroutine();
+  void suspendCoroutine();
+  llvm::Value *generateAwait(const AST::AwaitNode &node);
+
+  llvm::Value *loadCells(Type type, llvm::Value *cells, unsigned &cell);
+  void storeCells(Type type, llvm::Value *value, llvm::Value *cells,
+                  unsigned &cell);
+
+  llvm::Function *
+  outlineParallelBody(const AST::ParallelForNode &node,
+                      llvm::StructType *contextType,
+                      const std::vector<std::string> &captures);
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SemanticAnalyzer.hpp"
+
+// The .odei file written for every module compiled on its own. It lists the
+// signatures of the functions other modules can import, in Ode syntax:
+//
+//   fn sum(i32, i32): i32;
+//   async fn fetch(i32): i32;
+//
+// Importers declare these and nothing else, so they never read or check the
+// source of the module they import.
+class Interface {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  static void write(const std::filesystem::path &path,
+                    const std::string &module,
+                    const std::vector<FunctionSignature> &signatures);
+  static std::vector<FunctionSignature>
+  read(const std::filesystem::path &path);
+
+  // The first directory in searchPath holding module's interface.
+  static std::optional<std::filesystem::path>
+  find(const std::string &module,
+       const std::vector<std::filesystem::path> &searchPath);
+};
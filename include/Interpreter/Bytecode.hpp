@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Parser/AST.hpp"
+#include "SemanticAnalyzer.hpp"
+
+// Every opcode of the interpreter, for the enum and for the VM's dispatch
+// table. I, F and B suffixes name the operand type; bools are i32 0 or 1.
+#define ODE_OPCODES(X)                                                         \
+  X(Move)                                                                      \
+  X(LoadImm)                                                                   \
+  X(AddI)                                                                      \
+  X(SubI)                                                                      \
+  X(MulI)                                                                      \
+  X(DivI)                                                                      \
+  X(NegI)                                                                      \
+  X(MinI)                                                                      \
+  X(MaxI)                                                                      \
+  X(AddF)                                                                      \
+  X(SubF)                                                                      \
+  X(MulF)                                                                      \
+  X(DivF)                                                                      \
+  X(NegF)                                                                      \
+  X(MinF)                                                                      \
+  X(MaxF)                                                                      \
+  X(EqI)                                                                       \
+  X(NeI)                                                                       \
+  X(LtI)                                                                       \
+  X(LeI)                                                                       \
+  X(GtI)                                                                       \
+  X(GeI)                                                                       \
+  X(EqF)                                                                       \
+  X(NeF)                                                                       \
+  X(LtF)                                                                       \
+  X(LeF)                                                                       \
+  X(GtF)                                                                       \
+  X(GeF)                                                                       \
+  X(Not)                                                                       \
+  X(Jump)                                                                      \
+  X(Loop)                                                                      \
+  X(JumpIfFalse)                                                               \
+  X(JumpIfTrue)                                                                \
+  X(Extract)                                                                   \
+  X(Insert)                                                                    \
+  X(Call)                                                                      \
+  X(TailCall)                                                                  \
+  X(Return)                                                                    \
+  X(PrintI)                                                                    \
+  X(PrintF)                                                                    \
+  X(PrintB)                                                                    \
+  X(Await)                                                                     \
+  X(Spawn)                                                                     \
+  X(Sleep)
+
+// The register bytecode --interp runs. Each function has a window of 32-bit
+// registers; vectors and structs take one register per lane or scalar field,
+// in declaration order. Operands, by opcode:
+//
+//   Move a b               a = b
+//   LoadImm a #imm         a = the bits of imm
+//   binary ops a b c       a = b op c
+//   NegI, NegF, Not a b    a = op b
+//   Jump #target
+//   Loop a #target         the back edge of while loop a
+//   JumpIf* a #target      a is a bool
+//   Extract a b c          a = lane c of the n-lane vector at b
+//   Insert a b c           lane b of the n-lane vector at a = c
+//   Call a b c             the registers from a = function b of the
+//                          arguments starting at c
+//   TailCall b c           as Call, reusing the caller's frame and result
+//   Return a               returns the registers starting at a
+//   Print* a
+//   Await a b c            as Call, running function b as a task that the
+//                          caller waits for; n is set in synchronous code
+//   Spawn b c              starts function b as a task nobody waits for
+//   Sleep a                waits a milliseconds; n as for Await
+//
+// #imm and #target take the 32 bits of b and c, low half first.
+class Bytecode {
+public:
+  enum class Op : uint8_t {
+#define ODE_OPCODE_ENUM(name) name,
+    ODE_OPCODES(ODE_OPCODE_ENUM)
+#undef ODE_OPCODE_ENUM
+  };
+
+  struct Instruction {
+    Op op;
+    uint8_t n = 0;
+    uint16_t a = 0;
+    uint16_t b = 0;
+    uint16_t c = 0;
+
+    uint32_t imm() const { return b | static_cast<uint32_t>(c) << 16; }
+    void setImm(uint32_t value) {
+      b = static_cast<uint16_t>(value);
+      c = static_cast<uint16_t>(value >> 16);
+    }
+  };
+  static_assert(sizeof(Instruction) == 8);
+
+  struct Function {
+    std::string name;
+    unsigned paramCells = 0;
+    unsigned resultCells = 0;
+    unsigned registerCount = 0;
+    bool isAsync = false;
+    // Unset for functions only known by signature so far.
+    bool defined = false;
+    std::vector<Instruction> code;
+    // Where the function was compiled from: the index of its module among
+    // the inputs, and its declaration.
+    unsigned module = 0;
+    const AST::FuncDeclNode *source = nullptr;
+  };
+
+  struct Local {
+    std::string name;
+    Type type;
+    uint16_t reg;
+  };
+
+  // A while loop outside any parallel for, where --tiered can leave the
+  // interpreter for native code that finishes the function.
+  struct Loop {
+    uint16_t function;
+    const AST::WhileStmtNode *source;
+    // The variables in scope at the loop header, by scope: the parameters
+    // first, then one scope per block enclosing the loop.
+    std::vector<std::vector<Local>> scopes;
+  };
+
+  struct Program {
+    std::vector<Function> functions;
+    std::vector<Loop> loops;
+    std::optional<uint16_t> main;
+  };
+};
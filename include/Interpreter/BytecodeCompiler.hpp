@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Interpreter/Bytecode.hpp"
+#include "Parser/AST.hpp"
+#include "SemanticAnalyzer.hpp"
+
+// Lowers checked modules to bytecode for --interp. Registers are allocated
+// like a stack: locals stay live until their block ends, temporaries until
+// the end of their statement.
+class BytecodeCompiler {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  // Makes a function of another module callable before that module is
+  // compiled.
+  void declare(const FunctionSignature &signature);
+
+  // analysis must have checked root with recordExpressionTypes() on.
+  void compile(const AST::Node &root, const SemanticAnalyzer &analysis);
+
+  // Fails if a called function was declared but never compiled.
+  Bytecode::Program finish();
+
+private:
+  struct Variable {
+    uint16_t reg;
+    Type type;
+  };
+
+  Bytecode::Program program_;
+  std::unordered_map<std::string, uint16_t> functionIndex_;
+
+  const SemanticAnalyzer *analysis_ = nullptr;
+  unsigned module_ = 0;
+  Bytecode::Function *function_ = nullptr;
+  std::vector<std::unordered_map<std::string, Variable>> scopes_;
+  unsigned nextRegister_ = 0;
+  unsigned parallelDepth_ = 0;
+
+  uint16_t declareFunction(const std::string &name, unsigned paramCells,
+                           unsigned resultCells, bool isAsync);
+  void compileFunction(const AST::FuncDeclNode &node);
+
+  unsigned cellCount(Type type) const;
+  unsigned fieldOffset(Type type, const Token &field) const;
+  Type typeOf(const AST::Node *node) const;
+  const Variable &lookup(const Token &name) const;
+  std::optional<uint16_t> userFunction(const std::string &name) const;
+
+  uint16_t allocate(unsigned cells);
+  size_t emit(Bytecode::Op op, unsigned a = 0, unsigned b = 0,
+              unsigned c = 0, unsigned n = 0);
+  void emitMove(uint16_t dst, uint16_t src, unsigned cells);
+  void emitLoad(uint16_t dst, uint32_t bits);
+  // Points the jump at index to the next instruction emitted.
+  void patch(size_t index);
+  // Copies the value at reg to dst, if there is one.
+  uint16_t place(uint16_t reg, unsigned cells, std::optional<uint16_t> dst);
+
+  void compileStatement(const AST::Node *node);
+  void compileWhile(const AST::WhileStmtNode &node);
+  void compileParallelFor(const AST::ParallelForNode &node);
+
+  // Returns the first register holding the value. With dst, that is dst;
+  // otherwise it may be a variable's own register, which must not be
+  // written through.
+  uint16_t compileExpr(const AST::Node *node,
+                       std::optional<uint16_t> dst = std::nullopt);
+  uint16_t compileBinaryOp(const AST::BinaryOpNode &node,
+                           std::optional<uint16_t> dst);
+  uint16_t compileCall(const AST::FuncCallNode &node,
+                       std::optional<uint16_t> dst);
+  uint16_t compileBuiltinCall(const AST::FuncCallNode &node,
+                              std::optional<uint16_t> dst);
+  uint16_t compileAwait(const AST::AwaitNode &node,
+                        std::optional<uint16_t> dst);
+  // Evaluates the arguments of a call to function into consecutive
+  // registers and returns the first.
+  uint16_t compileArgs(const AST::FuncCallNode &node, uint16_t function);
+};
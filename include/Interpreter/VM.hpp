@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Interpreter/Bytecode.hpp"
+
+// Runs a bytecode program for --interp. Every task, main included, is a
+// fiber with its own register stack; fibers take turns on the calling
+// thread in the order ode_coro_schedule would queue them, so output
+// interleaves as in the compiled program. Values are printed by the
+// runtime library itself.
+class VM {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  // Native code for --tiered, compiled once something gets hot. Entries
+  // read their arguments from cells laid out as in the callee's frame and
+  // write the result to cells laid out as its return value.
+  class NativeCode {
+  public:
+    using Entry = void (*)(const void *args, void *result);
+
+    virtual ~NativeCode() = default;
+    // Starts compiling in the background; called once.
+    virtual void compile() = 0;
+    virtual bool ready() const = 0;
+    // Once ready: the entry running a whole function, or finishing the
+    // call a loop is part of from its header. Null where the interpreter
+    // has to stay in charge.
+    virtual Entry function(uint16_t index) const = 0;
+    virtual Entry loop(uint16_t index) const = 0;
+  };
+
+  // Nested calls a single fiber may make before it overflows its stack.
+  static constexpr size_t MAX_FRAMES = 100'000;
+  // Calls of a function, or iterations of a loop, that make it hot.
+  static constexpr uint32_t HOT_THRESHOLD = 10'000;
+
+  explicit VM(Bytecode::Program program);
+
+  // Lets hot functions and loops leave the interpreter for native code.
+  void setNativeCode(NativeCode *native);
+
+  // Runs main, then any task it left behind, and returns main's result.
+  int32_t run();
+
+private:
+  union Cell {
+    int32_t i;
+    float f;
+  };
+
+  struct Frame {
+    uint16_t function;
+    // Where the frame's registers start on the fiber's stack.
+    size_t base;
+    // Of the next instruction, while the frame is not running.
+    uint32_t pc;
+    // Register of the caller that receives the result.
+    uint16_t result;
+  };
+
+  struct Fiber {
+    std::vector<Cell> registers;
+    std::vector<Frame> frames;
+    // The fiber waiting for this one to finish, if any, and where its
+    // result goes in the waiter's innermost frame.
+    Fiber *awaiter = nullptr;
+    uint16_t awaitResult = 0;
+    bool blocking = false;
+  };
+
+  struct Timer {
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t sequence;
+    Fiber *fiber;
+
+    bool operator>(const Timer &other) const {
+      return deadline != other.deadline ? deadline > other.deadline
+                                        : sequence > other.sequence;
+    }
+  };
+
+  struct Heat {
+    uint32_t count = 0;
+    // Set once the native entry was asked for, whether there is one or not.
+    bool settled = false;
+    NativeCode::Entry entry = nullptr;
+  };
+
+  Bytecode::Program program_;
+  NativeCode *native_ = nullptr;
+  bool compileRequested_ = false;
+  std::vector<Heat> functionHeat_;
+  std::vector<Heat> loopHeat_;
+  std::unordered_map<Fiber *, std::unique_ptr<Fiber>> fibers_;
+  std::deque<Fiber *> ready_;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+  uint64_t timerSequence_ = 0;
+  Fiber *main_ = nullptr;
+  int32_t status_ = 0;
+
+  Fiber *createFiber(uint16_t function, const Cell *args);
+  // Puts a fiber that was waiting back in line.
+  void wake(Fiber *fiber);
+  void fireTimers();
+  // Runs fiber until it finishes or has to wait.
+  void execute(Fiber &fiber);
+  void finish(Fiber &fiber, const Cell *result);
+  // Counts a call or an iteration and returns the native entry to take
+  // instead, if there is one yet.
+  NativeCode::Entry warm(Heat &heat, bool loop, uint16_t index);
+  [[noreturn]] void fail(const Frame &frame, const std::string &message);
+};
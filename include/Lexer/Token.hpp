@@ -3,6 +3,13 @@
 #include <unordered_map>
 #include <vector>
 
+// 1-based position of the first character of a token. Line 0 means the
+// position is unknown, as for tokens the compiler synthesizes.
+struct SourceLocation {
+  unsigned line = 0;
+  unsigned column = 0;
+};
+
 class Token {
 public:
   enum class Type {
@@ -12,8 +19,19 @@ public:
     Else,
     Fn,
     Return,
+    Tail,
     While,
     Print,
+    Parallel,
+    For,
+    In,
+    Reduce,
+    Async,
+    Await,
+    Spawn,
+    Struct,
+    Import,
+    Const,
     Identifier,
     Number,
     Boolean,
@@ -39,6 +57,9 @@ public:
     Semicolon,
     Comma,
     Colon,
+    DotDot,
+    Dot,
+    At,
     DoubleQuotes,
     Type,
     Skip,
@@ -49,6 +70,7 @@ public:
 
   Type type;
   std::string value;
+  SourceLocation location;
 
   Token(Type t = Type::None, std::string v = "")
       : type(t), value(std::move(v)) {}
@@ -80,6 +102,7 @@ public:
 
     bool isAtEnd() const { return pos_ >= source_.length(); }
     size_t position() const { return pos_; }
+    SourceLocation location() const { return {line_, column_}; }
 
     std::string_view substr(size_t start, size_t length) const {
       return source_.substr(start, length);
@@ -88,6 +111,10 @@ public:
   private:
     std::string_view source_;
     size_t pos_;
+    unsigned line_ = 1;
+    unsigned column_ = 1;
+
+    void advance();
   };
 
   class Builder {
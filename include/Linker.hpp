@@ -1,11 +1,23 @@
 #include <filesystem>
+#include <vector>
 
 class Linker {
 public:
-  explicit Linker(std::filesystem::path op);
+  explicit Linker(std::vector<std::filesystem::path> inputs);
+
+  // Treat the inputs as ThinLTO bitcode and optimize across them at link time.
+  void enableThinLTO(unsigned optLevel);
+
+  // Link against the tiny runtime instead of the default one and the C and
+  // C++ libraries: a static, position-dependent executable that starts in
+  // the runtime's own _start. The inputs must only call into print.
+  void useTinyRuntime() { tinyRuntime = true; }
 
   void link(const std::filesystem::path &executablePath);
 
 private:
-  std::filesystem::path objectPath;
+  std::vector<std::filesystem::path> inputPaths;
+  bool thinLTO = false;
+  unsigned ltoOptLevel = 0;
+  bool tinyRuntime = false;
 };
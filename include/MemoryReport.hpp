@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collects the numbers behind --mem-report. Heap traffic is measured by the
+// replacement operator new and delete in MemoryReport.cpp, which only count
+// while a report exists. Memory that LLVM takes from malloc directly, such as
+// the buffers of its small vectors, is not seen by them.
+class MemoryReport {
+public:
+  MemoryReport();
+  ~MemoryReport();
+
+  MemoryReport(const MemoryReport &) = delete;
+  MemoryReport &operator=(const MemoryReport &) = delete;
+
+  // Ends the current phase, if any, and attributes the heap traffic from
+  // here on to name.
+  void startPhase(const std::string &name);
+
+  void recordTokens(const std::string &module, size_t count, size_t bytes);
+  void recordNodes(const std::string &module, const std::string &kind,
+                   size_t count, size_t bytes);
+  void recordScopes(const std::string &module,
+                    const std::vector<size_t> &peakSizes);
+  void recordInstructions(const std::string &module, const std::string &stage,
+                          size_t count);
+
+  // Ends the last phase and writes the report, finishing with the peak
+  // resident set size of the process.
+  void print(std::ostream &out);
+
+private:
+  struct Phase {
+    std::string name;
+    uint64_t allocated = 0;
+    uint64_t freed = 0;
+    uint64_t allocations = 0;
+    int64_t peakLive = 0;
+  };
+
+  struct Node {
+    size_t count = 0;
+    size_t bytes = 0;
+  };
+
+  struct Module {
+    size_t tokens = 0;
+    size_t tokenBytes = 0;
+    std::map<std::string, Node> nodes;
+    std::vector<size_t> peakScopeSizes;
+    std::vector<std::pair<std::string, size_t>> instructions;
+  };
+
+  std::vector<Phase> phases_;
+  bool inPhase_ = false;
+  Phase start_;
+  std::vector<std::string> moduleOrder_;
+  std::map<std::string, Module> modules_;
+
+  void endPhase();
+  Module &module(const std::string &name);
+};
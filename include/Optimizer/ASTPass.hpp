@@ -0,0 +1,47 @@
+#pragma once
+#include "Parser/AST.hpp"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A rewrite over the checked AST. Passes run between semantic analysis and IR
+// generation, so they can rely on the tree being well-typed and must keep it
+// that way.
+class ASTPass {
+public:
+  virtual ~ASTPass() = default;
+
+  virtual std::string name() const = 0;
+
+  // Returns true if the tree was changed.
+  virtual bool run(AST::ProgramNode &program) = 0;
+
+protected:
+  using SlotCallback = std::function<void(AST::NodePtr &)>;
+
+  static void forEachChild(AST::Node &node, const SlotCallback &callback);
+
+  static bool isLiteral(const AST::Node *node);
+  static AST::NodePtr cloneLiteral(const AST::Node *node);
+  // The text of an f32 literal for value, if it has one.
+  static std::optional<std::string> formatFloat(float value);
+};
+
+class ASTPassManager {
+public:
+  void addPass(std::unique_ptr<ASTPass> pass);
+
+  // Runs every pass in order, repeating the sequence until the tree stops
+  // changing, since one pass often exposes work for another.
+  void run(AST::Node &root);
+
+  static ASTPassManager createDefault();
+
+private:
+  static constexpr int MAX_ITERATIONS = 8;
+
+  std::vector<std::unique_ptr<ASTPass>> passes_;
+};
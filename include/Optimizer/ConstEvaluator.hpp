@@ -0,0 +1,61 @@
+#pragma once
+#include "Parser/AST.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Runs const fn bodies over the checked AST. Values are the scalars a
+// literal can express. A call whose result the evaluator cannot reproduce
+// exactly as the compiled program would, such as one that divides by zero
+// or exceeds the step or depth limit, has no value here and is left for the
+// program to compute at run time.
+class ConstEvaluator {
+public:
+  struct Value {
+    enum class Kind { I32, F32, Bool };
+
+    Kind kind;
+    int32_t i32 = 0;
+    float f32 = 0.0f;
+    bool boolean = false;
+  };
+
+  // Statements and expressions evaluated per outermost call.
+  static constexpr unsigned MAX_STEPS = 1'000'000;
+  static constexpr unsigned MAX_DEPTH = 256;
+
+  using FunctionMap =
+      std::unordered_map<std::string, const AST::FuncDeclNode *>;
+
+  explicit ConstEvaluator(const FunctionMap &functions)
+      : functions_(functions) {}
+
+  std::optional<Value> call(const std::string &name,
+                            const std::vector<Value> &args);
+
+  static std::optional<Value> readLiteral(const AST::Node *node);
+
+private:
+  // Thrown to abandon the outermost call.
+  struct Unevaluable {};
+
+  using Scope = std::unordered_map<std::string, Value>;
+
+  const FunctionMap &functions_;
+  std::vector<Scope> scopes_;
+  std::optional<Value> result_;
+  unsigned steps_ = 0;
+  unsigned depth_ = 0;
+
+  void step();
+  Value invoke(const std::string &name, const std::vector<Value> &args);
+  // Returns true once a return statement has set result_.
+  bool exec(const AST::Node *node);
+  Value eval(const AST::Node *node);
+  Value evalBinaryOp(const AST::BinaryOpNode &node);
+  Value evalUnaryOp(const AST::UnaryOpNode &node);
+  Value *lookup(const std::string &name);
+};
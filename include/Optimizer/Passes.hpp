@@ -0,0 +1,78 @@
+#pragma once
+#include "Optimizer/ASTPass.hpp"
+#include "Optimizer/ConstEvaluator.hpp"
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class ConstantFoldingPass : public ASTPass {
+public:
+  std::string name() const override { return "constant-folding"; }
+  bool run(AST::ProgramNode &program) override;
+
+private:
+  bool changed_ = false;
+
+  void fold(AST::NodePtr &slot);
+  AST::NodePtr foldBinaryOp(AST::BinaryOpNode &node);
+  AST::NodePtr foldUnaryOp(const AST::UnaryOpNode &node);
+};
+
+class ConstantPropagationPass : public ASTPass {
+public:
+  std::string name() const override { return "constant-propagation"; }
+  bool run(AST::ProgramNode &program) override;
+
+private:
+  // nullptr marks a parameter, which is never a propagation candidate.
+  using Scope = std::unordered_map<std::string, const AST::VarDeclNode *>;
+
+  std::vector<Scope> scopes_;
+  std::unordered_set<const AST::VarDeclNode *> reassigned_;
+  bool changed_ = false;
+
+  const AST::VarDeclNode *resolve(const std::string &name) const;
+  bool isPropagatable(const AST::VarDeclNode *decl) const;
+
+  void collectAssignments(AST::Node &node);
+  void rewrite(AST::NodePtr &slot);
+  void rewriteStatements(std::vector<AST::NodePtr> &statements);
+  void rewriteFunction(AST::FuncDeclNode &func);
+};
+
+// Replaces calls to const fn whose arguments are all literals with the
+// literal the call returns.
+class ConstEvaluationPass : public ASTPass {
+public:
+  std::string name() const override { return "const-evaluation"; }
+  bool run(AST::ProgramNode &program) override;
+
+private:
+  ConstEvaluator::FunctionMap functions_;
+  // The result of every call evaluated so far, keyed by the function and its
+  // argument values, with no value for calls that have none. Repeated calls,
+  // including those the pass manager's later iterations see again, are not
+  // run into the step limit twice.
+  std::unordered_map<std::string, std::optional<ConstEvaluator::Value>>
+      results_;
+  bool changed_ = false;
+
+  static std::string callKey(const std::string &name,
+                             const std::vector<ConstEvaluator::Value> &args);
+  void evaluate(AST::NodePtr &slot);
+};
+
+class DeadBranchEliminationPass : public ASTPass {
+public:
+  std::string name() const override { return "dead-branch-elimination"; }
+  bool run(AST::ProgramNode &program) override;
+
+private:
+  bool changed_ = false;
+
+  void visitNode(AST::Node &node);
+  void pruneStatements(std::vector<AST::NodePtr> &statements);
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class Options {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  enum class DebugInfo { None, LineTablesOnly, Full };
+  enum class Emit { Executable, Object, Assembly, LLVMIR, Bitcode };
+  // The runtime executables are linked with. Tiny links no C library: the
+  // executable is static and position-dependent, and only print is
+  // supported.
+  enum class Runtime { Default, Tiny };
+
+  static Options parse(int argc, char *argv[]);
+
+  std::vector<std::string> inputs;
+  // Object files and archives passed through to the linker.
+  std::vector<std::string> objects;
+  // Where imported modules' interface files are looked for, after the
+  // importing file's directory and the working directory.
+  std::vector<std::string> importPaths;
+  // Print make rules for the inputs' imports instead of compiling.
+  bool printDependencies = false;
+  // Run the program on the bytecode interpreter instead of building it.
+  bool interpret = false;
+  // With interpret: compile hot functions and loops to native code.
+  bool tiered = false;
+  unsigned optLevel = 0;
+  // Whether -O was given. Without it the backend runs at LLVM's default
+  // level, whatever optLevel is.
+  bool optLevelGiven = false;
+  Emit emit = Emit::Executable;
+  // Empty for the default name; "-" for standard output.
+  std::string output;
+  bool lto = false;
+  Runtime runtime = Runtime::Default;
+  DebugInfo debugInfo = DebugInfo::None;
+  bool framePointers = true;
+  // How arithmetic is compiled where a function's attributes do not say
+  // otherwise. When signed i32 overflow is undefined rather than wrapping,
+  // adds, subtractions and multiplications get nsw. Fast math allows every
+  // fast-math flag on floating-point operations; contraction fuses a
+  // multiply and an add within one expression (On) or anywhere (Fast).
+  struct Arithmetic {
+    enum class Contract { Off, On, Fast };
+    bool wrap = true;
+    bool fastMath = false;
+    Contract contract = Contract::Off;
+  };
+  Arithmetic arithmetic;
+  bool instrumentFunctions = false;
+  bool memReport = false;
+  bool timeReport = false;
+  // Directory of the cached ASTs; empty when caching is off.
+  std::string astCache;
+  // Optimization remarks printed by --remarks.
+  struct RemarkKinds {
+    bool passed = false;
+    bool missed = false;
+    bool analysis = false;
+  };
+  RemarkKinds remarks;
+  // Write every optimization remark to <name>.opt.yaml.
+  bool saveRemarks = false;
+  // Threads, and module partitions, used to generate object code.
+  unsigned codegenThreads = 1;
+};
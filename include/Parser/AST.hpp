@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "Lexer/Token.hpp"
@@ -12,6 +13,13 @@ public:
   public:
     virtual ~Node() = default;
     virtual void accept(Visitor &visitor) const = 0;
+
+    // Where the node starts in the source, for debug info.
+    SourceLocation location() const { return location_; }
+    void setLocation(SourceLocation location) { location_ = location; }
+
+  private:
+    SourceLocation location_;
   };
 
   using NodePtr = std::unique_ptr<Node>;
@@ -22,9 +30,15 @@ public:
 
     void addStatement(NodePtr stmt) { statements_.push_back(std::move(stmt)); }
     const std::vector<NodePtr> &statements() const { return statements_; }
+    std::vector<NodePtr> &statements() { return statements_; }
+
+    // import name; makes the functions of module name callable.
+    void addImport(Token module) { imports_.push_back(std::move(module)); }
+    const std::vector<Token> &imports() const { return imports_; }
 
   private:
     std::vector<NodePtr> statements_;
+    std::vector<Token> imports_;
   };
 
   class BlockNode : public Node {
@@ -33,6 +47,7 @@ public:
 
     void addStatement(NodePtr stmt) { statements_.push_back(std::move(stmt)); }
     const std::vector<NodePtr> &statements() const { return statements_; }
+    std::vector<NodePtr> &statements() { return statements_; }
 
   private:
     std::vector<NodePtr> statements_;
@@ -49,6 +64,7 @@ public:
     const Token &name() const { return name_; }
     const Node *type() const { return type_.get(); }
     const Node *expr() const { return expr_.get(); }
+    NodePtr &exprSlot() { return expr_; }
 
   private:
     Token name_;
@@ -56,19 +72,24 @@ public:
     NodePtr expr_;
   };
 
+  // name.field.field = expr; writes a single field when fields is not empty.
   class AssignNode : public Node {
   public:
-    AssignNode(Token name, NodePtr expr)
-        : name_(std::move(name)), expr_(std::move(expr)) {}
+    AssignNode(Token name, NodePtr expr, std::vector<Token> fields = {})
+        : name_(std::move(name)), expr_(std::move(expr)),
+          fields_(std::move(fields)) {}
 
     void accept(Visitor &visitor) const override;
 
     const Token &name() const { return name_; }
     const Node *expr() const { return expr_.get(); }
+    const std::vector<Token> &fields() const { return fields_; }
+    NodePtr &exprSlot() { return expr_; }
 
   private:
     Token name_;
     NodePtr expr_;
+    std::vector<Token> fields_;
   };
 
   class IfStmtNode : public Node {
@@ -85,6 +106,10 @@ public:
     const Node *elseBlock() const { return elseBlock_.get(); }
     bool hasElse() const { return elseBlock_ != nullptr; }
 
+    NodePtr &conditionSlot() { return condition_; }
+    NodePtr &thenBlockSlot() { return thenBlock_; }
+    NodePtr &elseBlockSlot() { return elseBlock_; }
+
   private:
     NodePtr condition_;
     NodePtr thenBlock_;
@@ -100,17 +125,62 @@ public:
 
     const Node *condition() const { return condition_.get(); }
     const Node *body() const { return body_.get(); }
+    NodePtr &conditionSlot() { return condition_; }
+    NodePtr &bodySlot() { return body_; }
 
   private:
     NodePtr condition_;
     NodePtr body_;
   };
 
+  // parallel for i in begin..end reduce(op: name, ...) { body }
+  class ParallelForNode : public Node {
+  public:
+    struct Reduction {
+      Token op;
+      Token name;
+    };
+
+    ParallelForNode(Token var, NodePtr begin, NodePtr end,
+                    std::vector<Reduction> reductions, NodePtr body)
+        : var_(std::move(var)), begin_(std::move(begin)),
+          end_(std::move(end)), reductions_(std::move(reductions)),
+          body_(std::move(body)) {}
+
+    void accept(Visitor &visitor) const override;
+
+    const Token &var() const { return var_; }
+    const Node *begin() const { return begin_.get(); }
+    const Node *end() const { return end_.get(); }
+    const std::vector<Reduction> &reductions() const { return reductions_; }
+    const Node *body() const { return body_.get(); }
+    NodePtr &beginSlot() { return begin_; }
+    NodePtr &endSlot() { return end_; }
+    NodePtr &bodySlot() { return body_; }
+
+  private:
+    Token var_;
+    NodePtr begin_;
+    NodePtr end_;
+    std::vector<Reduction> reductions_;
+    NodePtr body_;
+  };
+
+  // @name or @name(argument), before a struct or function declaration.
+  struct Attribute {
+    Token name;
+    std::optional<Token> argument;
+  };
+
+  // @overflow(undefined) @fast_math fn name(params): Type { body }
   class FuncDeclNode : public Node {
   public:
-    FuncDeclNode(Token name, NodePtr returnType, NodePtr params, NodePtr body)
+    FuncDeclNode(Token name, NodePtr returnType, NodePtr params, NodePtr body,
+                 bool async = false, bool constant = false,
+                 std::vector<Attribute> attributes = {})
         : name_(std::move(name)), returnType_(std::move(returnType)),
-          params_(std::move(params)), body_(std::move(body)) {}
+          params_(std::move(params)), body_(std::move(body)), async_(async),
+          const_(constant), attributes_(std::move(attributes)) {}
 
     void accept(Visitor &visitor) const override;
 
@@ -118,12 +188,47 @@ public:
     const Node *returnType() const { return returnType_.get(); }
     const Node *params() const { return params_.get(); }
     const Node *body() const { return body_.get(); }
+    NodePtr &bodySlot() { return body_; }
+    bool isAsync() const { return async_; }
+    // const fn: calls with constant arguments are evaluated at compile time.
+    bool isConst() const { return const_; }
+    const std::vector<Attribute> &attributes() const { return attributes_; }
 
   private:
     Token name_;
     NodePtr returnType_;
     NodePtr params_;
     NodePtr body_;
+    bool async_;
+    bool const_;
+    std::vector<Attribute> attributes_;
+  };
+
+  // @packed @align(64) struct Name { field: Type, ... }
+  class StructDeclNode : public Node {
+  public:
+    struct Field {
+      Token name;
+      NodePtr type;
+    };
+
+    using Attribute = AST::Attribute;
+
+    StructDeclNode(Token name, std::vector<Field> fields,
+                   std::vector<Attribute> attributes)
+        : name_(std::move(name)), fields_(std::move(fields)),
+          attributes_(std::move(attributes)) {}
+
+    void accept(Visitor &visitor) const override;
+
+    const Token &name() const { return name_; }
+    const std::vector<Field> &fields() const { return fields_; }
+    const std::vector<Attribute> &attributes() const { return attributes_; }
+
+  private:
+    Token name_;
+    std::vector<Field> fields_;
+    std::vector<Attribute> attributes_;
   };
 
   class FuncCallNode : public Node {
@@ -135,6 +240,7 @@ public:
 
     const Token &name() const { return name_; }
     const Node *args() const { return args_.get(); }
+    NodePtr &argsSlot() { return args_; }
 
   private:
     Token name_;
@@ -143,14 +249,18 @@ public:
 
   class ReturnStmtNode : public Node {
   public:
-    explicit ReturnStmtNode(NodePtr expr) : expr_(std::move(expr)) {}
+    explicit ReturnStmtNode(NodePtr expr, bool tail = false)
+        : expr_(std::move(expr)), tail_(tail) {}
 
     void accept(Visitor &visitor) const override;
 
     const Node *expr() const { return expr_.get(); }
+    NodePtr &exprSlot() { return expr_; }
+    bool isTail() const { return tail_; }
 
   private:
     NodePtr expr_;
+    bool tail_;
   };
 
   class PrintStmtNode : public Node {
@@ -160,11 +270,26 @@ public:
     void accept(Visitor &visitor) const override;
 
     const Node *expr() const { return expr_.get(); }
+    NodePtr &exprSlot() { return expr_; }
 
   private:
     NodePtr expr_;
   };
 
+  // spawn f(args); starts an async call without waiting for it.
+  class SpawnStmtNode : public Node {
+  public:
+    explicit SpawnStmtNode(NodePtr call) : call_(std::move(call)) {}
+
+    void accept(Visitor &visitor) const override;
+
+    const Node *call() const { return call_.get(); }
+    NodePtr &callSlot() { return call_; }
+
+  private:
+    NodePtr call_;
+  };
+
   class ExprStmtNode : public Node {
   public:
     explicit ExprStmtNode(NodePtr expr) : expr_(std::move(expr)) {}
@@ -172,6 +297,7 @@ public:
     void accept(Visitor &visitor) const override;
 
     const Node *expr() const { return expr_.get(); }
+    NodePtr &exprSlot() { return expr_; }
 
   private:
     NodePtr expr_;
@@ -186,12 +312,42 @@ public:
 
     const Token &op() const { return op_; }
     const Node *operand() const { return operand_.get(); }
+    NodePtr &operandSlot() { return operand_; }
 
   private:
     Token op_;
     NodePtr operand_;
   };
 
+  class AwaitNode : public Node {
+  public:
+    explicit AwaitNode(NodePtr expr) : expr_(std::move(expr)) {}
+
+    void accept(Visitor &visitor) const override;
+
+    const Node *expr() const { return expr_.get(); }
+    NodePtr &exprSlot() { return expr_; }
+
+  private:
+    NodePtr expr_;
+  };
+
+  class FieldAccessNode : public Node {
+  public:
+    FieldAccessNode(NodePtr object, Token field)
+        : object_(std::move(object)), field_(std::move(field)) {}
+
+    void accept(Visitor &visitor) const override;
+
+    const Node *object() const { return object_.get(); }
+    const Token &field() const { return field_; }
+    NodePtr &objectSlot() { return object_; }
+
+  private:
+    NodePtr object_;
+    Token field_;
+  };
+
   class BinaryOpNode : public Node {
   public:
     BinaryOpNode(Token op, NodePtr left, NodePtr right)
@@ -203,6 +359,8 @@ public:
     const Token &op() const { return op_; }
     const Node *left() const { return left_.get(); }
     const Node *right() const { return right_.get(); }
+    NodePtr &leftSlot() { return left_; }
+    NodePtr &rightSlot() { return right_; }
 
   private:
     Token op_;
@@ -283,6 +441,7 @@ public:
 
     void addArg(NodePtr arg) { args_.push_back(std::move(arg)); }
     const std::vector<NodePtr> &args() const { return args_; }
+    std::vector<NodePtr> &args() { return args_; }
 
   private:
     std::vector<NodePtr> args_;
@@ -298,13 +457,18 @@ public:
     virtual void visit(const AssignNode &node) = 0;
     virtual void visit(const IfStmtNode &node) = 0;
     virtual void visit(const WhileStmtNode &node) = 0;
+    virtual void visit(const ParallelForNode &node) = 0;
     virtual void visit(const FuncDeclNode &node) = 0;
+    virtual void visit(const StructDeclNode &node) = 0;
     virtual void visit(const FuncCallNode &node) = 0;
     virtual void visit(const ReturnStmtNode &node) = 0;
     virtual void visit(const PrintStmtNode &node) = 0;
+    virtual void visit(const SpawnStmtNode &node) = 0;
     virtual void visit(const ExprStmtNode &node) = 0;
     virtual void visit(const BinaryOpNode &node) = 0;
     virtual void visit(const UnaryOpNode &node) = 0;
+    virtual void visit(const AwaitNode &node) = 0;
+    virtual void visit(const FieldAccessNode &node) = 0;
     virtual void visit(const NumberNode &node) = 0;
     virtual void visit(const BooleanNode &node) = 0;
     virtual void visit(const IdentifierNode &node) = 0;
@@ -15,13 +15,18 @@ public:
   void visit(const AST::AssignNode &node) override;
   void visit(const AST::IfStmtNode &node) override;
   void visit(const AST::WhileStmtNode &node) override;
+  void visit(const AST::ParallelForNode &node) override;
   void visit(const AST::FuncDeclNode &node) override;
+  void visit(const AST::StructDeclNode &node) override;
   void visit(const AST::FuncCallNode &node) override;
   void visit(const AST::ReturnStmtNode &node) override;
   void visit(const AST::PrintStmtNode &node) override;
+  void visit(const AST::SpawnStmtNode &node) override;
   void visit(const AST::ExprStmtNode &node) override;
   void visit(const AST::BinaryOpNode &node) override;
   void visit(const AST::UnaryOpNode &node) override;
+  void visit(const AST::AwaitNode &node) override;
+  void visit(const AST::FieldAccessNode &node) override;
   void visit(const AST::NumberNode &node) override;
   void visit(const AST::BooleanNode &node) override;
   void visit(const AST::IdentifierNode &node) override;
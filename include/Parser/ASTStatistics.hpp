@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Parser/AST.hpp"
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+// Counts the nodes of a tree by kind, together with the size of the node
+// objects themselves. Vectors and strings the nodes own are not included.
+class ASTStatistics : public AST::Visitor {
+public:
+  struct Kind {
+    size_t count = 0;
+    size_t bytes = 0;
+  };
+
+  const std::map<std::string, Kind> &kinds() const { return kinds_; }
+  size_t nodeCount() const;
+  size_t nodeBytes() const;
+
+  void visit(const AST::ProgramNode &node) override;
+  void visit(const AST::BlockNode &node) override;
+  void visit(const AST::VarDeclNode &node) override;
+  void visit(const AST::AssignNode &node) override;
+  void visit(const AST::IfStmtNode &node) override;
+  void visit(const AST::WhileStmtNode &node) override;
+  void visit(const AST::ParallelForNode &node) override;
+  void visit(const AST::FuncDeclNode &node) override;
+  void visit(const AST::StructDeclNode &node) override;
+  void visit(const AST::FuncCallNode &node) override;
+  void visit(const AST::ReturnStmtNode &node) override;
+  void visit(const AST::PrintStmtNode &node) override;
+  void visit(const AST::SpawnStmtNode &node) override;
+  void visit(const AST::ExprStmtNode &node) override;
+  void visit(const AST::BinaryOpNode &node) override;
+  void visit(const AST::UnaryOpNode &node) override;
+  void visit(const AST::AwaitNode &node) override;
+  void visit(const AST::FieldAccessNode &node) override;
+  void visit(const AST::NumberNode &node) override;
+  void visit(const AST::BooleanNode &node) override;
+  void visit(const AST::IdentifierNode &node) override;
+  void visit(const AST::TypeNode &node) override;
+  void visit(const AST::ParamListNode &node) override;
+  void visit(const AST::ArgListNode &node) override;
+
+private:
+  std::map<std::string, Kind> kinds_;
+
+  void record(const std::string &kind, size_t bytes) {
+    Kind &entry = kinds_[kind];
+    ++entry.count;
+    entry.bytes += bytes;
+  }
+
+  void visitChild(const AST::Node *child) {
+    if (child) {
+      child->accept(*this);
+    }
+  }
+};
@@ -29,6 +29,7 @@ private:
   Token consume(Token::Type type, const std::string &name);
 
   AST::NodePtr parseProgram();
+  Token parseImport();
   AST::NodePtr parseExpr();
   AST::NodePtr parseLogicOr();
   AST::NodePtr parseLogicAnd();
@@ -37,17 +38,23 @@ private:
   AST::NodePtr parseTerm();
   AST::NodePtr parseFactor();
   AST::NodePtr parseUnary();
+  AST::NodePtr parsePostfix();
   AST::NodePtr parsePrimary();
   AST::NodePtr parseStatement();
   AST::NodePtr parseVarDecl();
+  bool isAssignment() const;
   AST::NodePtr parseAssign();
   AST::NodePtr parseExprStmt();
   AST::NodePtr parseBlock();
   AST::NodePtr parseIfStmt();
   AST::NodePtr parseWhileStmt();
+  AST::NodePtr parseParallelFor();
   AST::NodePtr parseReturnStmt();
   AST::NodePtr parsePrintStmt();
-  AST::NodePtr parseFuncDecl();
+  AST::NodePtr parseSpawnStmt();
+  std::vector<AST::Attribute> parseAttributes();
+  AST::NodePtr parseFuncDecl(std::vector<AST::Attribute> attributes = {});
+  AST::NodePtr parseStructDecl(std::vector<AST::Attribute> attributes = {});
   AST::NodePtr parseFuncCall();
   AST::NodePtr parseParamList();
   AST::NodePtr parseArgList();
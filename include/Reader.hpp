@@ -19,4 +19,6 @@ public:
   std::string readAll();
 
   std::string getFileName() const;
+
+  const std::filesystem::path &getFilePath() const;
 };
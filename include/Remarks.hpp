@@ -0,0 +1,67 @@
+#pragma once
+
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Options.hpp"
+
+namespace llvm {
+class DiagnosticInfoOptimizationBase;
+class LLVMContext;
+class ToolOutputFile;
+} // namespace llvm
+
+// Collects the optimization remarks LLVM produces while a module is
+// optimized and compiled, for --remarks and --save-remarks. Remarks only
+// carry Ode source locations when the IR has them; see
+// IRGenerator::trackLocations.
+class Remarks {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  // Routes the remarks of context to this collector, which must outlive it.
+  // Every remark, whatever its kind, is also written to yamlPath unless it
+  // is empty.
+  Remarks(llvm::LLVMContext &context, Options::RemarkKinds kinds,
+          const std::filesystem::path &yamlPath);
+  ~Remarks();
+
+  Remarks(const Remarks &) = delete;
+  Remarks &operator=(const Remarks &) = delete;
+
+  void add(const llvm::DiagnosticInfoOptimizationBase &remark);
+
+  // Writes the remarks collected so far, by source position, and forgets
+  // them.
+  void print(std::ostream &out);
+
+private:
+  enum class Kind { Passed, Missed, Analysis };
+
+  // In the order remarks are printed.
+  struct Remark {
+    std::string file;
+    unsigned line;
+    unsigned column;
+    Kind kind;
+    std::string function;
+    std::string pass;
+    std::string message;
+
+    auto operator<=>(const Remark &) const = default;
+  };
+
+  Options::RemarkKinds kinds_;
+  std::vector<Remark> remarks_;
+  std::unique_ptr<llvm::ToolOutputFile> yaml_;
+};
@@ -1,28 +1,126 @@
 #pragma once
 #include "Parser/AST.hpp"
 #include <format>
+#include <optional>
 #include <print>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-enum class Type { I32, F32, Bool, Void };
+// Struct types are numbered from FirstStruct in declaration order. The
+// analyzer that declared them describes their fields.
+enum class Type {
+  I32,
+  F32,
+  Bool,
+  Void,
+  V4F32,
+  V8F32,
+  V4I32,
+  V8I32,
+  FirstStruct
+};
+
+inline bool isStructType(Type type) { return type >= Type::FirstStruct; }
+
+// Vector types map onto fixed-width LLVM vectors of a scalar numeric type.
+inline bool isVectorType(Type type) {
+  return type == Type::V4F32 || type == Type::V8F32 || type == Type::V4I32 ||
+         type == Type::V8I32;
+}
+
+inline Type elementType(Type type) {
+  switch (type) {
+  case Type::V4F32:
+  case Type::V8F32:
+    return Type::F32;
+  case Type::V4I32:
+  case Type::V8I32:
+    return Type::I32;
+  default:
+    return type;
+  }
+}
+
+inline unsigned laneCount(Type type) {
+  switch (type) {
+  case Type::V4F32:
+  case Type::V4I32:
+    return 4;
+  case Type::V8F32:
+  case Type::V8I32:
+    return 8;
+  default:
+    return 1;
+  }
+}
+
+// Fields are listed in declaration order. slots[i] is the position of field
+// i in memory: unless the struct is @ordered or @packed, fields are sorted by
+// decreasing alignment so that as little padding as possible is needed.
+struct StructInfo {
+  struct Field {
+    std::string name;
+    Type type;
+  };
+
+  std::string name;
+  std::vector<Field> fields;
+  std::vector<unsigned> slots;
+  bool packed = false;
+  // Set by @align(N): the size is padded to a multiple of N bytes.
+  unsigned align = 0;
+
+  std::optional<unsigned> fieldIndex(const std::string &field) const {
+    for (unsigned i = 0; i < fields.size(); ++i) {
+      if (fields[i].name == field) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+struct FunctionSignature {
+  std::string name;
+  Type returnType;
+  std::vector<Type> params;
+  bool isAsync = false;
+};
+
+// Facts about a function body that hold for every call, derived from the call
+// graph once the whole module has been analyzed.
+struct FunctionInfo {
+  std::vector<std::string> callees;
+  bool hasSideEffects = false;
+  bool hasLoops = false;
+
+  bool pure = false;
+  bool recursive = true;
+  bool willReturn = false;
+};
 
 class Symbol {
 public:
   enum class Kind { Variable, Function };
 
-  Symbol(std::string name, Kind kind, Type type);
+  Symbol(std::string name, Kind kind, Type type,
+         std::vector<Type> params = {}, bool isAsync = false);
 
   const std::string &name() const { return name_; }
   Kind kind() const { return kind_; }
   Type type() const { return type_; }
+  const std::vector<Type> &params() const { return params_; }
+  bool isAsync() const { return isAsync_; }
 
 private:
   std::string name_;
   Kind kind_;
   Type type_;
+  std::vector<Type> params_;
+  bool isAsync_;
 };
 
 class SymbolTable {
@@ -31,11 +129,20 @@ public:
 
   void enterScope();
   void exitScope();
-  void declare(const std::string &name, Symbol::Kind kind, Type type);
+  void declare(const std::string &name, Symbol::Kind kind, Type type,
+               std::vector<Type> params = {}, bool isAsync = false);
   const Symbol *lookup(const std::string &name) const;
+  // Index of the innermost scope declaring name, counted from the global
+  // scope.
+  std::optional<size_t> scopeOf(const std::string &name) const;
+  size_t depth() const { return scopes_.size(); }
+  // The most symbols any scope at each depth has held, starting with the
+  // global scope.
+  const std::vector<size_t> &peakScopeSizes() const { return peakSizes_; }
 
 private:
   std::vector<std::unordered_map<std::string, Symbol>> scopes_;
+  std::vector<size_t> peakSizes_;
 };
 
 class SemanticAnalyzer : public AST::Visitor {
@@ -56,19 +163,49 @@ public:
 
   void analyze(AST::Node &root);
 
+  // Makes a function defined in another module of the same program callable
+  // from this one. Must be called before analyze().
+  void declareExternal(const FunctionSignature &signature);
+  // For modules compiled on their own, whose main is defined elsewhere or
+  // which have none because other modules import them.
+  void allowMissingMain() { requireMain_ = false; }
+
+  static std::vector<FunctionSignature>
+  collectSignatures(const AST::Node &root);
+
+  const FunctionInfo *functionInfo(const std::string &name) const;
+  const std::vector<size_t> &peakScopeSizes() const {
+    return symbols_.peakScopeSizes();
+  }
+
+  // Keeps the type of every expression checked from now on, for the AST
+  // cache and the bytecode compiler. Off by default, since generating IR
+  // does not need them.
+  void recordExpressionTypes() { recordTypes_ = true; }
+  std::optional<Type> expressionType(const AST::Node *node) const;
+
+  // Vector constructors and the lane/reduction builtins. User functions with
+  // the same name take precedence over the builtins.
+  static bool isBuiltinName(const std::string &name);
+
   void visit(const AST::ProgramNode &node) override;
   void visit(const AST::BlockNode &node) override;
   void visit(const AST::VarDeclNode &node) override;
   void visit(const AST::AssignNode &node) override;
   void visit(const AST::IfStmtNode &node) override;
   void visit(const AST::WhileStmtNode &node) override;
+  void visit(const AST::ParallelForNode &node) override;
   void visit(const AST::FuncDeclNode &node) override;
+  void visit(const AST::StructDeclNode &node) override;
   void visit(const AST::FuncCallNode &node) override;
   void visit(const AST::ReturnStmtNode &node) override;
   void visit(const AST::PrintStmtNode &node) override;
+  void visit(const AST::SpawnStmtNode &node) override;
   void visit(const AST::ExprStmtNode &node) override;
   void visit(const AST::BinaryOpNode &node) override;
   void visit(const AST::UnaryOpNode &node) override;
+  void visit(const AST::AwaitNode &node) override;
+  void visit(const AST::FieldAccessNode &node) override;
   void visit(const AST::NumberNode &node) override;
   void visit(const AST::BooleanNode &node) override;
   void visit(const AST::IdentifierNode &node) override;
@@ -76,14 +213,62 @@ public:
   void visit(const AST::ParamListNode &node) override;
   void visit(const AST::ArgListNode &node) override;
   static Type parseType(const AST::Node *node);
+  static Type typeFromName(const std::string &name);
+  // The inverse of typeFromName. Struct types have no name outside the
+  // analyzer that declared them.
+  static std::string typeName(Type type);
+  // Like parseType, but also accepts the structs declared so far.
+  Type resolveType(const AST::Node *node) const;
+  std::optional<Type> structType(const std::string &name) const;
+  const StructInfo &structInfo(Type type) const;
 
 private:
+  // Scopes below scopeDepth belong outside the loop body, and the body may
+  // only write to those variables through its reductions.
+  struct ParallelRegion {
+    size_t scopeDepth;
+    std::vector<std::string> reductions;
+  };
+
   SymbolTable symbols_;
+  // By name, which is unique: a function may not shadow another.
+  std::unordered_map<std::string, FunctionInfo> functions_;
+  FunctionSignature currentFunction_;
+  std::vector<ParallelRegion> parallelRegions_;
+  std::vector<StructInfo> structs_;
+  std::unordered_map<std::string, Type> structNames_;
+  std::unordered_set<std::string> constFunctions_;
+  bool recordTypes_ = false;
+  bool requireMain_ = true;
+  std::unordered_map<const AST::Node *, Type> expressionTypes_;
+
+  void recordCall(const std::string &callee);
+  void checkTailCall(const AST::ReturnStmtNode &node);
+  void checkParallelWrite(const std::string &name);
+  void computeFunctionFacts();
 
   Type checkExpr(const AST::Node *node);
+  Type checkExprType(const AST::Node *node);
   Type checkBinaryOp(const AST::BinaryOpNode &node);
   Type checkUnaryOp(const AST::UnaryOpNode &node);
   Type checkNumberLiteral(const AST::NumberNode &node);
+  bool isBuiltinCall(const AST::FuncCallNode &node) const;
+  Type checkBuiltinCall(const AST::FuncCallNode &node);
+  void checkArgs(const AST::FuncCallNode &node);
+  void useExecutor(const char *construct);
+  const Symbol *checkAsyncCall(const AST::Node *node, const char *construct);
+  Type checkAwait(const AST::AwaitNode &node);
+  bool isSleepCall(const AST::FuncCallNode &node) const;
+  unsigned alignmentOf(Type type) const;
+  Type fieldType(Type object, const Token &field) const;
+  Type checkStructConstruction(const AST::FuncCallNode &node, Type type);
+  void checkFunctionAttributes(const AST::FuncDeclNode &node) const;
+  bool inConstFunction() const;
+  void checkConstFunction(const AST::FuncDeclNode &node, Type returnType,
+                          const std::vector<Type> &params);
+  void checkConstContext(const char *construct) const;
+  void checkConstCall(const std::string &callee) const;
+  void checkConstLocal(const std::string &name, Type type) const;
 
-  static std::string typeToString(Type t);
+  std::string typeToString(Type t) const;
 };
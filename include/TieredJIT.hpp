@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Interpreter/Bytecode.hpp"
+#include "Interpreter/VM.hpp"
+#include "Options.hpp"
+#include "Parser/AST.hpp"
+#include "SemanticAnalyzer.hpp"
+
+namespace llvm::orc {
+class LLJIT;
+} // namespace llvm::orc
+
+// The native tier of --tiered. When the VM first finds something hot, the
+// whole program is compiled on a background thread with LLVM's ORC JIT,
+// along with cell entries for every function and loop the VM may hand
+// over. Functions that wait on tasks, directly or through their callees,
+// stay interpreted: their tasks are fibers only the VM can schedule.
+class TieredJIT : public VM::NativeCode {
+public:
+  class Error : public std::runtime_error {
+  public:
+    explicit Error(const std::string &msg) : std::runtime_error(msg) {}
+    Error(const std::string &context, const std::string &detail)
+        : std::runtime_error(std::format("{}: {}", context, detail)) {}
+  };
+
+  // A checked input, which must outlive the JIT.
+  struct Module {
+    std::string name;
+    const AST::Node *root;
+    const SemanticAnalyzer *analysis;
+    std::vector<FunctionSignature> externals;
+  };
+
+  TieredJIT(std::vector<Module> modules, const Bytecode::Program &program,
+            unsigned optLevel, const Options::Arithmetic &arithmetic);
+  // Waits for a compilation still running.
+  ~TieredJIT() override;
+
+  TieredJIT(const TieredJIT &) = delete;
+  TieredJIT &operator=(const TieredJIT &) = delete;
+
+  void compile() override;
+  bool ready() const override;
+  Entry function(uint16_t index) const override;
+  Entry loop(uint16_t index) const override;
+
+private:
+  // Where a bytecode function or loop came from. Only eligible ones get
+  // an entry.
+  struct Site {
+    std::string entry;
+    unsigned module;
+    const AST::FuncDeclNode *function;
+    const AST::WhileStmtNode *loop = nullptr;
+    std::vector<std::vector<Bytecode::Local>> scopes;
+    bool eligible;
+  };
+
+  std::vector<Module> modules_;
+  std::vector<Site> functions_;
+  std::vector<Site> loops_;
+  unsigned optLevel_;
+  Options::Arithmetic arithmetic_;
+
+  std::unique_ptr<llvm::orc::LLJIT> jit_;
+  std::vector<Entry> functionEntries_;
+  std::vector<Entry> loopEntries_;
+  std::thread thread_;
+  std::atomic<bool> ready_ = false;
+
+  // Runs on thread_. Failures are reported and leave every entry null.
+  void build();
+};
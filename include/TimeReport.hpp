@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Wall-clock time of each phase of a compilation, for --time-report.
+class TimeReport {
+public:
+  // Ends the current phase, if any, and starts timing name.
+  void startPhase(const std::string &name);
+
+  // Ends the last phase and writes one line per phase followed by the total.
+  void print(std::ostream &out);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<std::pair<std::string, Clock::duration>> phases_;
+  std::string current_;
+  Clock::time_point start_;
+  bool inPhase_ = false;
+
+  void endPhase();
+};
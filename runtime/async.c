@@ -0,0 +1,218 @@
+#include "ode_runtime.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Synchronous code waits on an int flag instead of a coroutine. Its address
+ * is passed around with the low bit set so it can share the awaiter slot. */
+#define WAITER_TAG ((uintptr_t)1)
+
+typedef struct {
+  uint64_t deadline;
+  uint64_t seq;
+  void *waiter;
+} Timer;
+
+/* The executor is per thread: a task only ever runs on the thread that
+ * created it. */
+typedef struct {
+  void **ready;
+  size_t head;
+  size_t count;
+  size_t capacity;
+  Timer *timers;
+  size_t timer_count;
+  size_t timer_capacity;
+  uint64_t timer_seq;
+} Executor;
+
+static _Thread_local Executor executor;
+
+static void *grow(void *items, size_t *capacity, size_t size) {
+  size_t grown = *capacity ? *capacity * 2 : 16;
+  items = realloc(items, grown * size);
+  if (!items) {
+    fputs("ode: out of memory\n", stderr);
+    abort();
+  }
+  *capacity = grown;
+  return items;
+}
+
+/* Frames from LLVM's switch-resumed lowering start with a pointer to the
+ * resume function, which takes the frame itself. */
+static void resume(void *handle) {
+  void (*resume_fn)(void *) = *(void (**)(void *))handle;
+  resume_fn(handle);
+}
+
+static void push_ready(void *handle) {
+  Executor *ex = &executor;
+  if (ex->count == ex->capacity) {
+    /* Unwrap the ring into the larger buffer. */
+    size_t old = ex->capacity;
+    void **ready = ex->ready;
+    ex->ready = grow(NULL, &ex->capacity, sizeof(void *));
+    for (size_t i = 0; i < ex->count; ++i) {
+      ex->ready[i] = ready[(ex->head + i) % old];
+    }
+    ex->head = 0;
+    free(ready);
+  }
+  ex->ready[(ex->head + ex->count) % ex->capacity] = handle;
+  ++ex->count;
+}
+
+static void *pop_ready(void) {
+  Executor *ex = &executor;
+  void *handle = ex->ready[ex->head];
+  ex->head = (ex->head + 1) % ex->capacity;
+  --ex->count;
+  return handle;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool timer_before(const Timer *a, const Timer *b) {
+  return a->deadline != b->deadline ? a->deadline < b->deadline
+                                    : a->seq < b->seq;
+}
+
+static void push_timer(uint64_t deadline, void *waiter) {
+  Executor *ex = &executor;
+  if (ex->timer_count == ex->timer_capacity) {
+    ex->timers = grow(ex->timers, &ex->timer_capacity, sizeof(Timer));
+  }
+
+  size_t i = ex->timer_count++;
+  Timer timer = {
+      .deadline = deadline, .seq = ex->timer_seq++, .waiter = waiter};
+  while (i > 0 && timer_before(&timer, &ex->timers[(i - 1) / 2])) {
+    ex->timers[i] = ex->timers[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  ex->timers[i] = timer;
+}
+
+static void pop_timer(void) {
+  Executor *ex = &executor;
+  Timer last = ex->timers[--ex->timer_count];
+  size_t i = 0;
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= ex->timer_count) {
+      break;
+    }
+    if (child + 1 < ex->timer_count &&
+        timer_before(&ex->timers[child + 1], &ex->timers[child])) {
+      ++child;
+    }
+    if (!timer_before(&ex->timers[child], &last)) {
+      break;
+    }
+    ex->timers[i] = ex->timers[child];
+    i = child;
+  }
+  if (ex->timer_count > 0) {
+    ex->timers[i] = last;
+  }
+}
+
+static void fire_timers(uint64_t now) {
+  Executor *ex = &executor;
+  while (ex->timer_count > 0 && ex->timers[0].deadline <= now) {
+    void *waiter = ex->timers[0].waiter;
+    pop_timer();
+    ode_coro_schedule(waiter);
+  }
+}
+
+static void sleep_until(uint64_t deadline) {
+  struct timespec ts = {.tv_sec = (time_t)(deadline / 1000000000u),
+                        .tv_nsec = (long)(deadline % 1000000000u)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+  }
+}
+
+/* Runs tasks until *done is set or, with done == NULL, until no task is
+ * left. */
+static void run(const int *done) {
+  Executor *ex = &executor;
+  for (;;) {
+    if (done && *done) {
+      return;
+    }
+    if (ex->timer_count > 0) {
+      fire_timers(now_ns());
+    }
+    if (ex->count > 0) {
+      resume(pop_ready());
+      continue;
+    }
+    if (ex->timer_count == 0) {
+      if (!done) {
+        return;
+      }
+      ode_flush();
+      fputs("ode: deadlock: awaited task can never complete\n", stderr);
+      abort();
+    }
+    sleep_until(ex->timers[0].deadline);
+  }
+}
+
+void *ode_coro_alloc(uint64_t size) {
+  void *frame = malloc(size);
+  if (!frame) {
+    fputs("ode: out of memory\n", stderr);
+    abort();
+  }
+  return frame;
+}
+
+void ode_coro_free(void *frame) { free(frame); }
+
+void ode_coro_schedule(void *handle) {
+  if ((uintptr_t)handle & WAITER_TAG) {
+    *(int *)((uintptr_t)handle & ~WAITER_TAG) = 1;
+    return;
+  }
+  push_ready(handle);
+}
+
+void ode_block_on(void *task, void **awaiter) {
+  int done = 0;
+  *awaiter = (void *)((uintptr_t)&done | WAITER_TAG);
+  ode_coro_schedule(task);
+  run(&done);
+}
+
+void ode_sleep(void *handle, int32_t millis) {
+  uint64_t deadline = now_ns() + (uint64_t)(millis > 0 ? millis : 0) * 1000000u;
+  if (handle) {
+    push_timer(deadline, handle);
+    return;
+  }
+
+  int done = 0;
+  push_timer(deadline, (void *)((uintptr_t)&done | WAITER_TAG));
+  run(&done);
+}
+
+void ode_run_tasks(void) { run(NULL); }
+
+static pthread_once_t exit_once = PTHREAD_ONCE_INIT;
+
+/* Registered after the output flush, so it runs first at exit. */
+static void register_exit_tasks(void) { atexit(ode_run_tasks); }
+
+void ode_spawn(void *task) {
+  pthread_once(&exit_once, register_exit_tasks);
+  ode_coro_schedule(task);
+}
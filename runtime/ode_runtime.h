@@ -0,0 +1,78 @@
+#ifndef ODE_RUNTIME_H
+#define ODE_RUNTIME_H
+
+/*
+ * Support library linked into every Ode executable. The compiler lowers
+ * language constructs to calls into these functions, so their names and
+ * signatures are part of the code generator's ABI.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* print(x): appends the value and a newline to the calling thread's output
+ * buffer. Formatting matches printf's "%d\n" and "%f\n". */
+void ode_print_i32(int32_t value);
+void ode_print_f32(float value);
+void ode_print_bool(bool value);
+
+/* Writes out the calling thread's buffered output. Runs automatically at
+ * exit for the main thread. */
+void ode_flush(void);
+
+/* parallel for: the compiler outlines the loop body into a function that runs
+ * the iterations [begin, end) with the captured variables in ctx. The range
+ * [begin, end) of the whole loop is split into chunks that a pool of worker
+ * threads executes and steals from each other. Returns once every iteration
+ * has run. Calls made from inside a parallel loop run serially. */
+typedef void (*ode_parallel_body)(int32_t begin, int32_t end, void *ctx);
+void ode_parallel_for(ode_parallel_body body, int32_t begin, int32_t end,
+                      void *ctx);
+
+/* Serializes the combination of per-chunk partial reductions. */
+void ode_parallel_lock(void);
+void ode_parallel_unlock(void);
+
+/* async functions: each call allocates a coroutine frame, and the handle
+ * returned by the function refers to it. Tasks run on a single-threaded
+ * executor owned by the thread that created them. */
+void *ode_coro_alloc(uint64_t size);
+void ode_coro_free(void *frame);
+
+/* Queues a task to be resumed. Called by a finishing task to wake the
+ * coroutine awaiting it. */
+void ode_coro_schedule(void *handle);
+
+/* await from synchronous code: starts the task, storing the awaiter the task
+ * wakes into *awaiter, then runs the executor until the task has finished. */
+void ode_block_on(void *task, void **awaiter);
+
+/* await sleep(ms): resumes handle after at least ms milliseconds. With a null
+ * handle the call itself blocks, running other tasks meanwhile. */
+void ode_sleep(void *handle, int32_t millis);
+
+/* spawn: queues a task that nobody awaits. It frees its own frame when done.
+ * Tasks still pending at exit run to completion before output is flushed. */
+void ode_spawn(void *task);
+
+/* Runs the calling thread's tasks until none is left. Parallel loop workers
+ * call it after each loop, so tasks spawned there do not outlive the loop. */
+void ode_run_tasks(void);
+
+/* --instrument=functions: every Ode function calls ode_prof_enter with its
+ * name on entry and ode_prof_exit right before it returns or tail calls.
+ * Call counts and inclusive and exclusive cycles are kept per thread and per
+ * call path. At exit a flat profile is printed to stderr and the collapsed
+ * stacks are written to $ODE_PROFILE_STACKS (default ode-profile.folded). */
+void ode_prof_enter(const char *name);
+void ode_prof_exit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
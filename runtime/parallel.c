@@ -0,0 +1,221 @@
+#include "ode_runtime.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ODE_MAX_WORKERS 256
+
+/* The range is cut into about this many chunks per worker. Small enough that
+ * dispatch overhead disappears next to the loop body, large enough that a
+ * worker finishing early still finds something to steal. */
+#define ODE_CHUNKS_PER_WORKER 8
+
+/* Iterations [next, end) not yet claimed by any worker. The owner claims
+ * chunks from the front, thieves split off the back half. */
+typedef struct {
+  _Alignas(64) pthread_mutex_t lock;
+  int64_t next;
+  int64_t end;
+} WorkRange;
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned generation;
+  unsigned busy;
+  ode_parallel_body body;
+  void *ctx;
+  int64_t grain;
+} Pool;
+
+static Pool pool = {.lock = PTHREAD_MUTEX_INITIALIZER,
+                    .start = PTHREAD_COND_INITIALIZER,
+                    .done = PTHREAD_COND_INITIALIZER};
+static WorkRange ranges[ODE_MAX_WORKERS];
+
+/* Worker 0 is whichever thread calls ode_parallel_for. */
+static unsigned worker_count = 1;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t reduction_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local bool in_parallel;
+
+static bool claim_chunk(WorkRange *range, int64_t grain, int64_t *begin,
+                        int64_t *end) {
+  pthread_mutex_lock(&range->lock);
+  bool claimed = range->next < range->end;
+  if (claimed) {
+    *begin = range->next;
+    *end = range->end - range->next > grain ? range->next + grain : range->end;
+    range->next = *end;
+  }
+  pthread_mutex_unlock(&range->lock);
+  return claimed;
+}
+
+/* Moves half of some other worker's remaining iterations into the range of
+ * worker self. Ranges only ever shrink, so finding every victim empty means
+ * the loop has no unclaimed work left. */
+static bool steal(unsigned self, int64_t grain) {
+  for (unsigned offset = 1; offset < worker_count; ++offset) {
+    WorkRange *victim = &ranges[(self + offset) % worker_count];
+
+    pthread_mutex_lock(&victim->lock);
+    int64_t remaining = victim->end - victim->next;
+    int64_t taken = remaining > grain ? remaining / 2 : remaining;
+    int64_t split = victim->end - taken;
+    victim->end = split;
+    pthread_mutex_unlock(&victim->lock);
+
+    if (taken > 0) {
+      pthread_mutex_lock(&ranges[self].lock);
+      ranges[self].next = split;
+      ranges[self].end = split + taken;
+      pthread_mutex_unlock(&ranges[self].lock);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void run_job(unsigned self) {
+  in_parallel = true;
+
+  int64_t begin;
+  int64_t end;
+  do {
+    while (claim_chunk(&ranges[self], pool.grain, &begin, &end)) {
+      pool.body((int32_t)begin, (int32_t)end, pool.ctx);
+    }
+  } while (steal(self, pool.grain));
+
+  /* ctx does not outlive the loop, so neither may tasks the body spawned. */
+  ode_run_tasks();
+  in_parallel = false;
+}
+
+static void *worker_main(void *arg) {
+  unsigned self = (unsigned)(uintptr_t)arg;
+  unsigned seen = 0;
+
+  for (;;) {
+    pthread_mutex_lock(&pool.lock);
+    while (pool.generation == seen) {
+      pthread_cond_wait(&pool.start, &pool.lock);
+    }
+    seen = pool.generation;
+    pthread_mutex_unlock(&pool.lock);
+
+    run_job(self);
+
+    /* Only the main thread's buffer is flushed at exit. */
+    ode_flush();
+
+    pthread_mutex_lock(&pool.lock);
+    if (--pool.busy == 0) {
+      pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+  }
+  return NULL;
+}
+
+/* One worker per online CPU, or ODE_NUM_THREADS if set. */
+static void start_pool(void) {
+  long requested = 0;
+  const char *env = getenv("ODE_NUM_THREADS");
+  if (env) {
+    requested = strtol(env, NULL, 10);
+  }
+  if (requested <= 0) {
+    requested = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (requested < 1) {
+    requested = 1;
+  }
+  if (requested > ODE_MAX_WORKERS) {
+    requested = ODE_MAX_WORKERS;
+  }
+
+  for (long i = 0; i < requested; ++i) {
+    pthread_mutex_init(&ranges[i].lock, NULL);
+  }
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  unsigned started = 1;
+  while (started < (unsigned)requested) {
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, worker_main,
+                       (void *)(uintptr_t)started) != 0) {
+      break;
+    }
+    ++started;
+  }
+  worker_count = started;
+
+  pthread_attr_destroy(&attr);
+}
+
+void ode_parallel_for(ode_parallel_body body, int32_t begin, int32_t end,
+                      void *ctx) {
+  if (end <= begin) {
+    return;
+  }
+
+  pthread_once(&pool_once, start_pool);
+
+  /* Nested loops, and loops started while another thread owns the pool, run
+   * on the calling thread. */
+  int64_t total = (int64_t)end - begin;
+  if (in_parallel || worker_count == 1 || total == 1 ||
+      pthread_mutex_trylock(&dispatch_lock) != 0) {
+    body(begin, end, ctx);
+    return;
+  }
+
+  /* Workers write their output as each job ends, so whatever the caller
+   * printed before the loop has to reach the file first. */
+  ode_flush();
+
+  int64_t grain = total / ((int64_t)worker_count * ODE_CHUNKS_PER_WORKER);
+  pool.body = body;
+  pool.ctx = ctx;
+  pool.grain = grain > 0 ? grain : 1;
+
+  for (unsigned w = 0; w < worker_count; ++w) {
+    pthread_mutex_lock(&ranges[w].lock);
+    ranges[w].next = begin + total * w / worker_count;
+    ranges[w].end = begin + total * (w + 1) / worker_count;
+    pthread_mutex_unlock(&ranges[w].lock);
+  }
+
+  pthread_mutex_lock(&pool.lock);
+  pool.busy = worker_count - 1;
+  ++pool.generation;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.lock);
+
+  run_job(0);
+  ode_flush();
+
+  /* ctx lives in the caller's frame, so every worker has to be done with it
+   * before returning. */
+  pthread_mutex_lock(&pool.lock);
+  while (pool.busy > 0) {
+    pthread_cond_wait(&pool.done, &pool.lock);
+  }
+  pthread_mutex_unlock(&pool.lock);
+
+  pthread_mutex_unlock(&dispatch_lock);
+}
+
+void ode_parallel_lock(void) { pthread_mutex_lock(&reduction_lock); }
+
+void ode_parallel_unlock(void) { pthread_mutex_unlock(&reduction_lock); }
@@ -0,0 +1,191 @@
+#include "ode_runtime.h"
+
+#include <string.h>
+
+#ifdef ODE_TINY_RUNTIME
+/* Single-threaded and without a C library: the buffer is a plain global,
+ * written with the raw system call and flushed by _start. */
+#include "tiny/syscall.h"
+#define ODE_THREAD_LOCAL
+#else
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#define ODE_THREAD_LOCAL _Thread_local
+#endif
+
+/* Large enough that a loop printing millions of values issues one write per
+ * few thousand lines instead of taking the stdio lock on every call. */
+#define ODE_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+/* Longest formatted value: a sign, 39 integer digits of FLT_MAX, the point,
+ * six decimals and the newline. */
+#define ODE_MAX_FORMATTED_SIZE 64
+
+typedef struct {
+  size_t length;
+  char data[ODE_OUTPUT_BUFFER_SIZE];
+} OutputBuffer;
+
+static ODE_THREAD_LOCAL OutputBuffer output;
+
+static void write_all(const char *data, size_t size) {
+  while (size > 0) {
+#ifdef ODE_TINY_RUNTIME
+    long written = ode_sys_write(1, data, size);
+    if (written < 0) {
+      if (written == -ODE_EINTR) {
+        continue;
+      }
+      return;
+    }
+#else
+    ssize_t written = write(STDOUT_FILENO, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+#endif
+    data += written;
+    size -= (size_t)written;
+  }
+}
+
+void ode_flush(void) {
+  write_all(output.data, output.length);
+  output.length = 0;
+}
+
+#ifndef ODE_TINY_RUNTIME
+__attribute__((constructor)) static void register_exit_flush(void) {
+  atexit(ode_flush);
+}
+#endif
+
+static char *reserve(size_t size) {
+  if (output.length + size > ODE_OUTPUT_BUFFER_SIZE) {
+    ode_flush();
+  }
+  return output.data + output.length;
+}
+
+/* Writes the digits of value so that they end right before end. */
+static char *format_u32(char *end, uint32_t value) {
+  do {
+    *--end = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+
+void ode_print_i32(int32_t value) {
+  char scratch[16];
+  char *end = scratch + sizeof(scratch);
+  *--end = '\n';
+
+  uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+  char *begin = format_u32(end, magnitude);
+  if (value < 0) {
+    *--begin = '-';
+  }
+
+  size_t size = (size_t)(scratch + sizeof(scratch) - begin);
+  memcpy(reserve(size), begin, size);
+  output.length += size;
+}
+
+void ode_print_bool(bool value) {
+  char *dest = reserve(2);
+  dest[0] = value ? '1' : '0';
+  dest[1] = '\n';
+  output.length += 2;
+}
+
+/* Formats value exactly as "%f\n" does under the default rounding mode. A
+ * float is mantissa * 2^exponent with a 24-bit mantissa, which allows exact
+ * arithmetic without a floating-point library: the integer part of a large
+ * value is built by doubling a decimal digit string, and the six decimals of
+ * a small one come from mantissa * 10^6, which fits in 64 bits. */
+void ode_print_f32(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  bool negative = (bits >> 31) != 0;
+  uint32_t biasedExponent = (bits >> 23) & 0xff;
+  uint32_t fraction = bits & 0x7fffff;
+
+  char scratch[ODE_MAX_FORMATTED_SIZE];
+  size_t length = 0;
+  if (negative) {
+    scratch[length++] = '-';
+  }
+
+  if (biasedExponent == 0xff) {
+    const char *text = fraction != 0 ? "nan\n" : "inf\n";
+    memcpy(scratch + length, text, 4);
+    length += 4;
+    memcpy(reserve(length), scratch, length);
+    output.length += length;
+    return;
+  }
+
+  uint32_t mantissa = biasedExponent == 0 ? fraction : fraction | 0x800000;
+  int exponent = biasedExponent == 0 ? -149 : (int)biasedExponent - 150;
+
+  /* Integer digits, least significant first. */
+  char digits[40];
+  size_t digitCount = 0;
+  uint32_t decimals = 0;
+
+  if (exponent >= 0) {
+    for (uint32_t m = mantissa; m != 0; m /= 10) {
+      digits[digitCount++] = (char)(m % 10);
+    }
+    for (int i = 0; i < exponent; ++i) {
+      int carry = 0;
+      for (size_t d = 0; d < digitCount; ++d) {
+        int doubled = digits[d] * 2 + carry;
+        digits[d] = (char)(doubled % 10);
+        carry = doubled / 10;
+      }
+      if (carry != 0) {
+        digits[digitCount++] = (char)carry;
+      }
+    }
+  } else {
+    uint64_t scaled = (uint64_t)mantissa * 1000000u;
+    int shift = -exponent;
+    uint64_t rounded = 0;
+    /* Past 63 bits of shift the value is below 0.5e-6 and rounds to 0. */
+    if (shift < 64) {
+      rounded = scaled >> shift;
+      uint64_t remainder = scaled & ((UINT64_C(1) << shift) - 1);
+      uint64_t half = UINT64_C(1) << (shift - 1);
+      if (remainder > half || (remainder == half && (rounded & 1) != 0)) {
+        ++rounded;
+      }
+    }
+    for (uint64_t whole = rounded / 1000000; whole != 0; whole /= 10) {
+      digits[digitCount++] = (char)(whole % 10);
+    }
+    decimals = (uint32_t)(rounded % 1000000);
+  }
+
+  if (digitCount == 0) {
+    scratch[length++] = '0';
+  }
+  while (digitCount > 0) {
+    scratch[length++] = (char)('0' + digits[--digitCount]);
+  }
+
+  scratch[length++] = '.';
+  for (uint32_t divisor = 100000; divisor != 0; divisor /= 10) {
+    scratch[length++] = (char)('0' + decimals / divisor % 10);
+  }
+  scratch[length++] = '\n';
+
+  memcpy(reserve(length), scratch, length);
+  output.length += length;
+}
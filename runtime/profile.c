@@ -0,0 +1,301 @@
+#include "ode_runtime.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Each thread records a calling context tree: one node per distinct call
+ * path, so that both the flat profile and the collapsed stacks can be built
+ * from it at exit. Children are found by comparing name pointers, which the
+ * compiler emits once per function. */
+typedef struct Node {
+  const char *name;
+  struct Node *parent;
+  struct Node *children;
+  struct Node *sibling;
+  uint64_t calls;
+  uint64_t inclusive;
+  uint64_t exclusive;
+} Node;
+
+typedef struct {
+  Node *node;
+  uint64_t start;
+  uint64_t children;
+} Frame;
+
+typedef struct Profile {
+  Node root;
+  Node *current;
+  Frame *frames;
+  size_t depth;
+  size_t capacity;
+  struct Profile *next;
+} Profile;
+
+typedef struct {
+  const char *name;
+  uint64_t calls;
+  uint64_t inclusive;
+  uint64_t exclusive;
+} FlatEntry;
+
+static _Thread_local Profile *profile;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static Profile *profiles;
+
+/* The time stamp counter where there is one; it ticks at a constant rate on
+ * current x86 parts, so the numbers are reference cycles rather than core
+ * cycles. */
+static inline uint64_t cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void *checked(void *memory) {
+  if (!memory) {
+    fputs("ode: out of memory\n", stderr);
+    abort();
+  }
+  return memory;
+}
+
+static void dump_profiles(void);
+
+/* Registered before main, so the dump runs after every exit handler the
+ * program installs itself, such as the executor draining its tasks. */
+__attribute__((constructor)) static void register_exit_dump(void) {
+  atexit(dump_profiles);
+}
+
+static Profile *create_profile(void) {
+  Profile *created = checked(calloc(1, sizeof(Profile)));
+  created->current = &created->root;
+
+  pthread_mutex_lock(&registry_lock);
+  created->next = profiles;
+  profiles = created;
+  pthread_mutex_unlock(&registry_lock);
+  return created;
+}
+
+static Node *child_of(Node *parent, const char *name) {
+  for (Node *child = parent->children; child; child = child->sibling) {
+    if (child->name == name) {
+      return child;
+    }
+  }
+
+  Node *child = checked(calloc(1, sizeof(Node)));
+  child->name = name;
+  child->parent = parent;
+  child->sibling = parent->children;
+  parent->children = child;
+  return child;
+}
+
+void ode_prof_enter(const char *name) {
+  Profile *p = profile ? profile : (profile = create_profile());
+  if (p->depth == p->capacity) {
+    p->capacity = p->capacity ? p->capacity * 2 : 64;
+    p->frames = checked(realloc(p->frames, p->capacity * sizeof(Frame)));
+  }
+
+  Node *node = child_of(p->current, name);
+  ++node->calls;
+  p->current = node;
+
+  Frame *frame = &p->frames[p->depth++];
+  frame->node = node;
+  frame->children = 0;
+  /* Read last, so the bookkeeping above is charged to the caller. */
+  frame->start = cycles();
+}
+
+void ode_prof_exit(void) {
+  uint64_t now = cycles();
+  Profile *p = profile;
+  if (!p || p->depth == 0) {
+    return;
+  }
+
+  Frame *frame = &p->frames[--p->depth];
+  uint64_t elapsed = now - frame->start;
+  frame->node->inclusive += elapsed;
+  frame->node->exclusive += elapsed - frame->children;
+  p->current = frame->node->parent;
+  if (p->depth > 0) {
+    p->frames[p->depth - 1].children += elapsed;
+  }
+}
+
+/* Pre-order successor of node within the tree below root, or NULL. The tree
+ * is as deep as the profiled program's deepest recursion, so it is walked
+ * through the parent links instead of on the C stack. depth tracks the
+ * distance from root. */
+static const Node *next_node(const Node *node, const Node *root,
+                             size_t *depth) {
+  if (node->children) {
+    ++*depth;
+    return node->children;
+  }
+  for (; node != root; node = node->parent, --*depth) {
+    if (node->sibling) {
+      return node->sibling;
+    }
+  }
+  return NULL;
+}
+
+static bool has_ancestor_named(const Node *node, const char *name) {
+  for (const Node *n = node->parent; n && n->name; n = n->parent) {
+    if (strcmp(n->name, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Recursive activations are already part of the outermost one's inclusive
+ * time, so only the outermost is counted. */
+static void add_flat(FlatEntry **entries, size_t *count, size_t *capacity,
+                     const Node *node) {
+  size_t i = 0;
+  while (i < *count && strcmp((*entries)[i].name, node->name) != 0) {
+    ++i;
+  }
+  if (i == *count) {
+    if (*count == *capacity) {
+      *capacity = *capacity ? *capacity * 2 : 64;
+      *entries = checked(realloc(*entries, *capacity * sizeof(FlatEntry)));
+    }
+    (*entries)[(*count)++] = (FlatEntry){.name = node->name};
+  }
+
+  FlatEntry *entry = &(*entries)[i];
+  entry->calls += node->calls;
+  entry->exclusive += node->exclusive;
+  if (!has_ancestor_named(node, node->name)) {
+    entry->inclusive += node->inclusive;
+  }
+}
+
+static void collect_flat(FlatEntry **entries, size_t *count, size_t *capacity,
+                         const Node *root) {
+  size_t depth = 0;
+  for (const Node *node = next_node(root, root, &depth); node;
+       node = next_node(node, root, &depth)) {
+    add_flat(entries, count, capacity, node);
+  }
+}
+
+static int by_exclusive(const void *a, const void *b) {
+  const FlatEntry *x = a;
+  const FlatEntry *y = b;
+  return x->exclusive < y->exclusive ? 1 : x->exclusive > y->exclusive ? -1 : 0;
+}
+
+static void print_flat(FILE *out) {
+  FlatEntry *entries = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+  for (Profile *p = profiles; p; p = p->next) {
+    collect_flat(&entries, &count, &capacity, &p->root);
+  }
+  qsort(entries, count, sizeof(FlatEntry), by_exclusive);
+
+  uint64_t total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    total += entries[i].exclusive;
+  }
+
+  fputs("ode: flat profile (cycles, all threads)\n", out);
+  fprintf(out, "%7s %16s %16s %12s  %s\n", "self%", "self", "total", "calls",
+          "function");
+  for (size_t i = 0; i < count; ++i) {
+    const FlatEntry *e = &entries[i];
+    double share = total ? 100.0 * (double)e->exclusive / (double)total : 0.0;
+    fprintf(out, "%6.2f%% %16llu %16llu %12llu  %s\n", share,
+            (unsigned long long)e->exclusive,
+            (unsigned long long)e->inclusive, (unsigned long long)e->calls,
+            e->name);
+  }
+  free(entries);
+}
+
+/* One "outer;inner;leaf self-cycles" line per call path, the input format of
+ * flamegraph.pl and speedscope. Identical paths from different threads are
+ * summed by those tools. */
+static void print_stacks(FILE *out, const Node *root, const Node **path) {
+  size_t depth = 0;
+  for (const Node *node = next_node(root, root, &depth); node;
+       node = next_node(node, root, &depth)) {
+    path[depth - 1] = node;
+    if (node->exclusive > 0) {
+      for (size_t i = 0; i < depth; ++i) {
+        fputs(path[i]->name, out);
+        fputc(i + 1 == depth ? ' ' : ';', out);
+      }
+      fprintf(out, "%llu\n", (unsigned long long)node->exclusive);
+    }
+  }
+}
+
+static size_t tree_depth(const Node *root) {
+  size_t deepest = 0;
+  size_t depth = 0;
+  for (const Node *node = next_node(root, root, &depth); node;
+       node = next_node(node, root, &depth)) {
+    deepest = depth > deepest ? depth : deepest;
+  }
+  return deepest;
+}
+
+/* The flat profile goes to stderr. The collapsed stacks are written to
+ * $ODE_PROFILE_STACKS, or ode-profile.folded in the working directory. */
+static void dump_profiles(void) {
+  pthread_mutex_lock(&registry_lock);
+  if (!profiles) {
+    /* Linked in, but nothing was instrumented. */
+    pthread_mutex_unlock(&registry_lock);
+    return;
+  }
+  ode_flush();
+
+  print_flat(stderr);
+
+  const char *path = getenv("ODE_PROFILE_STACKS");
+  if (!path || !*path) {
+    path = "ode-profile.folded";
+  }
+  FILE *stacks = fopen(path, "w");
+  if (!stacks) {
+    fprintf(stderr, "ode: could not write %s\n", path);
+  } else {
+    for (Profile *p = profiles; p; p = p->next) {
+      const Node **frames =
+          checked(malloc((tree_depth(&p->root) + 1) * sizeof(Node *)));
+      print_stacks(stacks, &p->root, frames);
+      free(frames);
+    }
+    fclose(stacks);
+    fprintf(stderr, "ode: collapsed stacks written to %s\n", path);
+  }
+  pthread_mutex_unlock(&registry_lock);
+}
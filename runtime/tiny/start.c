@@ -0,0 +1,62 @@
+#include "ode_runtime.h"
+#include "syscall.h"
+
+/* Startup code of executables linked with --runtime=tiny. There is no
+ * dynamic loader, no C library and no thread-local storage: the kernel
+ * jumps to _start, which runs main, writes out the buffered output and
+ * exits. Ode's main takes no arguments, so argc, argv and the environment
+ * on the initial stack are left alone. */
+
+int main(void);
+
+__attribute__((used, noreturn)) static void start_main(void) {
+  int status = main();
+  ode_flush();
+  ode_sys_exit(status);
+}
+
+/* The kernel leaves the stack 16-byte aligned; the call then pushes the
+ * return address exactly like a call to main from C would. A zero frame
+ * pointer ends the chain for debuggers and profilers. */
+__attribute__((naked, noreturn)) void _start(void) {
+  __asm__("xor %ebp, %ebp\n\t"
+          "and $-16, %rsp\n\t"
+          "call start_main\n\t"
+          "hlt");
+}
+
+/* Code generation may turn struct and vector copies into calls to these,
+ * which every C library provides. Compiled with -ffreestanding so that the
+ * loops are not themselves turned back into such calls. */
+
+void *memcpy(void *restrict dest, const void *restrict src, size_t size) {
+  unsigned char *d = dest;
+  const unsigned char *s = src;
+  while (size-- > 0) {
+    *d++ = *s++;
+  }
+  return dest;
+}
+
+void *memmove(void *dest, const void *src, size_t size) {
+  unsigned char *d = dest;
+  const unsigned char *s = src;
+  if (d < s) {
+    while (size-- > 0) {
+      *d++ = *s++;
+    }
+  } else {
+    while (size-- > 0) {
+      d[size] = s[size];
+    }
+  }
+  return dest;
+}
+
+void *memset(void *dest, int value, size_t size) {
+  unsigned char *d = dest;
+  while (size-- > 0) {
+    *d++ = (unsigned char)value;
+  }
+  return dest;
+}
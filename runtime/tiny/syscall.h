@@ -0,0 +1,48 @@
+#ifndef ODE_TINY_SYSCALL_H
+#define ODE_TINY_SYSCALL_H
+
+/*
+ * Raw Linux system calls for the tiny runtime, which links no C library.
+ * Failures come back as -errno instead of through errno.
+ */
+
+#if !defined(__linux__) || !defined(__x86_64__)
+#error "the tiny runtime supports x86-64 Linux only"
+#endif
+
+#include <stddef.h>
+
+#define ODE_SYS_WRITE 1
+#define ODE_SYS_EXIT_GROUP 231
+
+#define ODE_EINTR 4
+
+static inline long ode_syscall1(long number, long a) {
+  long result;
+  __asm__ volatile("syscall"
+                   : "=a"(result)
+                   : "a"(number), "D"(a)
+                   : "rcx", "r11", "memory");
+  return result;
+}
+
+static inline long ode_syscall3(long number, long a, long b, long c) {
+  long result;
+  __asm__ volatile("syscall"
+                   : "=a"(result)
+                   : "a"(number), "D"(a), "S"(b), "d"(c)
+                   : "rcx", "r11", "memory");
+  return result;
+}
+
+static inline long ode_sys_write(int fd, const void *data, size_t size) {
+  return ode_syscall3(ODE_SYS_WRITE, fd, (long)data, (long)size);
+}
+
+__attribute__((noreturn)) static inline void ode_sys_exit(int status) {
+  for (;;) {
+    ode_syscall1(ODE_SYS_EXIT_GROUP, status);
+  }
+}
+
+#endif
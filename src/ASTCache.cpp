@@ -0,0 +1,681 @@
+#include "ASTCache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr char MAGIC[8] = {'O', 'D', 'E', 'A', 'S', 'T', '\0', '\0'};
+constexpr uint32_t VERSION = 4;
+// Written in host byte order, so a file from a host of the other byte order
+// fails the comparison instead of being misread.
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr uint32_t NONE = ~0u;
+
+enum class Kind : uint16_t {
+  Program,
+  Block,
+  VarDecl,
+  Assign,
+  IfStmt,
+  WhileStmt,
+  ParallelFor,
+  FuncDecl,
+  StructDecl,
+  FuncCall,
+  ReturnStmt,
+  PrintStmt,
+  SpawnStmt,
+  ExprStmt,
+  BinaryOp,
+  UnaryOp,
+  Await,
+  FieldAccess,
+  Number,
+  Boolean,
+  Identifier,
+  Type,
+  ParamList,
+  ArgList,
+  Count
+};
+
+enum Flags : uint16_t { ASYNC = 1, TAIL = 2, CONST = 4 };
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t sourceHash;
+  uint64_t sourceSize;
+  uint32_t nodeCount;
+  uint32_t tokenCount;
+  uint32_t childCount;
+  uint32_t stringCount;
+  uint32_t stringBytes;
+  uint32_t reserved;
+};
+
+struct NodeRecord {
+  uint16_t kind;
+  uint16_t flags;
+  uint32_t line;
+  uint32_t column;
+  uint32_t type;
+  uint32_t firstToken;
+  uint32_t tokenCount;
+  uint32_t firstChild;
+  uint32_t childCount;
+};
+
+struct TokenRecord {
+  uint32_t string;
+  uint32_t type;
+  uint32_t line;
+  uint32_t column;
+};
+
+static_assert(sizeof(Header) == 56 && sizeof(NodeRecord) == 32 &&
+              sizeof(TokenRecord) == 16);
+
+// Stands in for the argument of an attribute written without one.
+const Token NO_TOKEN;
+
+class Writer : public AST::Visitor {
+public:
+  explicit Writer(const SemanticAnalyzer *analysis) : analysis_(analysis) {}
+
+  std::vector<NodeRecord> nodes;
+  std::vector<TokenRecord> tokens;
+  std::vector<uint32_t> children;
+  std::vector<uint32_t> stringOffsets{0};
+  std::string strings;
+
+  uint32_t write(const AST::Node *node) {
+    if (!node) {
+      return NONE;
+    }
+    node->accept(*this);
+    return static_cast<uint32_t>(nodes.size() - 1);
+  }
+
+  void visit(const AST::ProgramNode &node) override {
+    std::vector<const Token *> imports;
+    for (const auto &module : node.imports()) {
+      imports.push_back(&module);
+    }
+    add(node, Kind::Program, imports, writeAll(node.statements()));
+  }
+
+  void visit(const AST::BlockNode &node) override {
+    add(node, Kind::Block, {}, writeAll(node.statements()));
+  }
+
+  void visit(const AST::VarDeclNode &node) override {
+    add(node, Kind::VarDecl, {&node.name()},
+        {write(node.type()), write(node.expr())});
+  }
+
+  void visit(const AST::AssignNode &node) override {
+    std::vector<const Token *> names = {&node.name()};
+    for (const auto &field : node.fields()) {
+      names.push_back(&field);
+    }
+    add(node, Kind::Assign, names, {write(node.expr())});
+  }
+
+  void visit(const AST::IfStmtNode &node) override {
+    add(node, Kind::IfStmt, {},
+        {write(node.condition()), write(node.thenBlock()),
+         write(node.elseBlock())});
+  }
+
+  void visit(const AST::WhileStmtNode &node) override {
+    add(node, Kind::WhileStmt, {},
+        {write(node.condition()), write(node.body())});
+  }
+
+  void visit(const AST::ParallelForNode &node) override {
+    std::vector<const Token *> names = {&node.var()};
+    for (const auto &reduction : node.reductions()) {
+      names.push_back(&reduction.op);
+      names.push_back(&reduction.name);
+    }
+    add(node, Kind::ParallelFor, names,
+        {write(node.begin()), write(node.end()), write(node.body())});
+  }
+
+  // The name is followed by one name and argument pair per attribute.
+  void visit(const AST::FuncDeclNode &node) override {
+    std::vector<const Token *> names = {&node.name()};
+    for (const auto &attribute : node.attributes()) {
+      names.push_back(&attribute.name);
+      names.push_back(attribute.argument ? &*attribute.argument : &NO_TOKEN);
+    }
+    add(node, Kind::FuncDecl, names,
+        {write(node.returnType()), write(node.params()), write(node.body())},
+        (node.isAsync() ? ASYNC : 0) | (node.isConst() ? CONST : 0));
+  }
+
+  // The field names follow the struct name, then one name and argument
+  // pair per attribute.
+  void visit(const AST::StructDeclNode &node) override {
+    std::vector<const Token *> names = {&node.name()};
+    std::vector<uint32_t> types;
+    for (const auto &field : node.fields()) {
+      names.push_back(&field.name);
+      types.push_back(write(field.type.get()));
+    }
+    for (const auto &attribute : node.attributes()) {
+      names.push_back(&attribute.name);
+      names.push_back(attribute.argument ? &*attribute.argument : &NO_TOKEN);
+    }
+    add(node, Kind::StructDecl, names, types);
+  }
+
+  void visit(const AST::FuncCallNode &node) override {
+    add(node, Kind::FuncCall, {&node.name()}, {write(node.args())});
+  }
+
+  void visit(const AST::ReturnStmtNode &node) override {
+    add(node, Kind::ReturnStmt, {}, {write(node.expr())},
+        node.isTail() ? TAIL : 0);
+  }
+
+  void visit(const AST::PrintStmtNode &node) override {
+    add(node, Kind::PrintStmt, {}, {write(node.expr())});
+  }
+
+  void visit(const AST::SpawnStmtNode &node) override {
+    add(node, Kind::SpawnStmt, {}, {write(node.call())});
+  }
+
+  void visit(const AST::ExprStmtNode &node) override {
+    add(node, Kind::ExprStmt, {}, {write(node.expr())});
+  }
+
+  void visit(const AST::BinaryOpNode &node) override {
+    add(node, Kind::BinaryOp, {&node.op()},
+        {write(node.left()), write(node.right())});
+  }
+
+  void visit(const AST::UnaryOpNode &node) override {
+    add(node, Kind::UnaryOp, {&node.op()}, {write(node.operand())});
+  }
+
+  void visit(const AST::AwaitNode &node) override {
+    add(node, Kind::Await, {}, {write(node.expr())});
+  }
+
+  void visit(const AST::FieldAccessNode &node) override {
+    add(node, Kind::FieldAccess, {&node.field()}, {write(node.object())});
+  }
+
+  void visit(const AST::NumberNode &node) override {
+    add(node, Kind::Number, {&node.value()}, {});
+  }
+
+  void visit(const AST::BooleanNode &node) override {
+    add(node, Kind::Boolean, {&node.value()}, {});
+  }
+
+  void visit(const AST::IdentifierNode &node) override {
+    add(node, Kind::Identifier, {&node.name()}, {});
+  }
+
+  void visit(const AST::TypeNode &node) override {
+    add(node, Kind::Type, {&node.type()}, {});
+  }
+
+  void visit(const AST::ParamListNode &node) override {
+    std::vector<const Token *> names;
+    std::vector<uint32_t> types;
+    for (const auto &param : node.params()) {
+      names.push_back(&param.name);
+      types.push_back(write(param.type.get()));
+    }
+    add(node, Kind::ParamList, names, types);
+  }
+
+  void visit(const AST::ArgListNode &node) override {
+    add(node, Kind::ArgList, {}, writeAll(node.args()));
+  }
+
+private:
+  const SemanticAnalyzer *analysis_;
+  std::unordered_map<std::string, uint32_t> interned_;
+
+  std::vector<uint32_t> writeAll(const std::vector<AST::NodePtr> &nodes) {
+    std::vector<uint32_t> indices;
+    for (const auto &node : nodes) {
+      indices.push_back(write(node.get()));
+    }
+    return indices;
+  }
+
+  uint32_t intern(const std::string &text) {
+    auto [it, inserted] = interned_.try_emplace(
+        text, static_cast<uint32_t>(stringOffsets.size() - 1));
+    if (inserted) {
+      strings += text;
+      stringOffsets.push_back(static_cast<uint32_t>(strings.size()));
+    }
+    return it->second;
+  }
+
+  // Children are written before this is called, so they precede node.
+  void add(const AST::Node &node, Kind kind,
+           const std::vector<const Token *> &names,
+           const std::vector<uint32_t> &childIndices, uint16_t flags = 0) {
+    NodeRecord record{static_cast<uint16_t>(kind),
+                      flags,
+                      node.location().line,
+                      node.location().column,
+                      NONE,
+                      static_cast<uint32_t>(tokens.size()),
+                      static_cast<uint32_t>(names.size()),
+                      static_cast<uint32_t>(children.size()),
+                      static_cast<uint32_t>(childIndices.size())};
+    if (analysis_) {
+      if (std::optional<Type> type = analysis_->expressionType(&node)) {
+        record.type = static_cast<uint32_t>(*type);
+      }
+    }
+
+    for (const Token *token : names) {
+      tokens.push_back({intern(token->value),
+                        static_cast<uint32_t>(token->type),
+                        token->location.line, token->location.column});
+    }
+    children.insert(children.end(), childIndices.begin(), childIndices.end());
+    nodes.push_back(record);
+  }
+};
+
+class Mapping {
+public:
+  explicit Mapping(const std::filesystem::path &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        data_ = static_cast<const char *>(data);
+        size_ = static_cast<size_t>(info.st_size);
+      }
+    }
+    close(fd);
+  }
+
+  ~Mapping() {
+    if (data_) {
+      munmap(const_cast<char *>(data_), size_);
+    }
+  }
+
+  Mapping(const Mapping &) = delete;
+  Mapping &operator=(const Mapping &) = delete;
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Rebuilds the tree from the tables of a mapped file, checking every index
+// it follows so that a damaged file fails to load instead of crashing.
+class Loader {
+public:
+  Loader(const Mapping &mapping, const ASTCache::Key &key) {
+    if (mapping.size() < sizeof(Header)) {
+      throw ASTCache::Error("file too short");
+    }
+    std::memcpy(&header_, mapping.data(), sizeof(Header));
+    if (std::memcmp(header_.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header_.version != VERSION || header_.byteOrder != BYTE_ORDER_MARK) {
+      throw ASTCache::Error("not an AST cache of this version");
+    }
+    if (header_.sourceHash != key.hash || header_.sourceSize != key.size) {
+      throw ASTCache::Error("built from a different source");
+    }
+
+    uint64_t offset = sizeof(Header);
+    nodes_ = table<NodeRecord>(mapping, offset, header_.nodeCount);
+    tokens_ = table<TokenRecord>(mapping, offset, header_.tokenCount);
+    children_ = table<uint32_t>(mapping, offset, header_.childCount);
+    stringOffsets_ =
+        table<uint32_t>(mapping, offset, uint64_t{header_.stringCount} + 1);
+    strings_ = table<char>(mapping, offset, header_.stringBytes);
+    if (nodes_.empty()) {
+      throw ASTCache::Error("no nodes");
+    }
+  }
+
+  AST::NodePtr load() {
+    built_.resize(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      built_[i] = build(static_cast<uint32_t>(i));
+      built_[i]->setLocation({nodes_[i].line, nodes_[i].column});
+    }
+    for (size_t i = 0; i + 1 < built_.size(); ++i) {
+      if (built_[i]) {
+        throw ASTCache::Error("node without a parent");
+      }
+    }
+    return std::move(built_.back());
+  }
+
+private:
+  Header header_;
+  std::span<const NodeRecord> nodes_;
+  std::span<const TokenRecord> tokens_;
+  std::span<const uint32_t> children_;
+  std::span<const uint32_t> stringOffsets_;
+  std::span<const char> strings_;
+  std::vector<AST::NodePtr> built_;
+
+  template <typename T>
+  static std::span<const T> table(const Mapping &mapping, uint64_t &offset,
+                                  uint64_t count) {
+    uint64_t bytes = count * sizeof(T);
+    if (offset + bytes > mapping.size()) {
+      throw ASTCache::Error("file too short");
+    }
+    auto *data = reinterpret_cast<const T *>(mapping.data() + offset);
+    offset += (bytes + 3) & ~uint64_t{3};
+    return {data, static_cast<size_t>(count)};
+  }
+
+  Token token(const NodeRecord &record, uint32_t i) const {
+    if (i >= record.tokenCount ||
+        uint64_t{record.firstToken} + i >= tokens_.size()) {
+      throw ASTCache::Error("token index out of range");
+    }
+    const TokenRecord &entry = tokens_[record.firstToken + i];
+    if (entry.string >= header_.stringCount ||
+        entry.type > static_cast<uint32_t>(Token::Type::End)) {
+      throw ASTCache::Error("bad token");
+    }
+    uint32_t begin = stringOffsets_[entry.string];
+    uint32_t end = stringOffsets_[entry.string + 1];
+    if (begin > end || end > strings_.size()) {
+      throw ASTCache::Error("string out of range");
+    }
+
+    Token result(static_cast<Token::Type>(entry.type),
+                 std::string(strings_.data() + begin, end - begin));
+    result.location = {entry.line, entry.column};
+    return result;
+  }
+
+  // Name and argument pairs from token first on; a None token stands for
+  // a missing argument.
+  std::vector<AST::Attribute> attributes(const NodeRecord &record,
+                                         uint32_t first) const {
+    std::vector<AST::Attribute> result;
+    for (uint32_t i = first; i < record.tokenCount; i += 2) {
+      Token argument = token(record, i + 1);
+      std::optional<Token> value;
+      if (argument.type != Token::Type::None) {
+        value = std::move(argument);
+      }
+      result.push_back({token(record, i), std::move(value)});
+    }
+    return result;
+  }
+
+  // Hands over the ith child of the node at index, which must have been
+  // built already and not given to another parent.
+  AST::NodePtr child(uint32_t index, uint32_t i, bool optional = false) {
+    const NodeRecord &record = nodes_[index];
+    if (i >= record.childCount ||
+        uint64_t{record.firstChild} + i >= children_.size()) {
+      throw ASTCache::Error("child index out of range");
+    }
+    uint32_t node = children_[record.firstChild + i];
+    if (node == NONE && optional) {
+      return nullptr;
+    }
+    if (node >= index || !built_[node]) {
+      throw ASTCache::Error("bad child");
+    }
+    return std::move(built_[node]);
+  }
+
+  std::vector<AST::NodePtr> allChildren(uint32_t index) {
+    std::vector<AST::NodePtr> nodes;
+    for (uint32_t i = 0; i < nodes_[index].childCount; ++i) {
+      nodes.push_back(child(index, i));
+    }
+    return nodes;
+  }
+
+  AST::NodePtr build(uint32_t index) {
+    const NodeRecord &record = nodes_[index];
+    if (record.kind >= static_cast<uint16_t>(Kind::Count)) {
+      throw ASTCache::Error("unknown node kind");
+    }
+
+    switch (static_cast<Kind>(record.kind)) {
+    case Kind::Program: {
+      auto program = std::make_unique<AST::ProgramNode>();
+      for (uint32_t i = 0; i < record.tokenCount; ++i) {
+        program->addImport(token(record, i));
+      }
+      for (auto &stmt : allChildren(index)) {
+        program->addStatement(std::move(stmt));
+      }
+      return program;
+    }
+    case Kind::Block: {
+      auto block = std::make_unique<AST::BlockNode>();
+      for (auto &stmt : allChildren(index)) {
+        block->addStatement(std::move(stmt));
+      }
+      return block;
+    }
+    case Kind::VarDecl:
+      return std::make_unique<AST::VarDeclNode>(
+          token(record, 0), child(index, 0), child(index, 1));
+    case Kind::Assign: {
+      std::vector<Token> fields;
+      for (uint32_t i = 1; i < record.tokenCount; ++i) {
+        fields.push_back(token(record, i));
+      }
+      return std::make_unique<AST::AssignNode>(
+          token(record, 0), child(index, 0), std::move(fields));
+    }
+    case Kind::IfStmt:
+      return std::make_unique<AST::IfStmtNode>(
+          child(index, 0), child(index, 1), child(index, 2, true));
+    case Kind::WhileStmt:
+      return std::make_unique<AST::WhileStmtNode>(child(index, 0),
+                                                  child(index, 1));
+    case Kind::ParallelFor: {
+      if (record.tokenCount % 2 != 1) {
+        throw ASTCache::Error("bad reduction list");
+      }
+      std::vector<AST::ParallelForNode::Reduction> reductions;
+      for (uint32_t i = 1; i < record.tokenCount; i += 2) {
+        reductions.push_back({token(record, i), token(record, i + 1)});
+      }
+      return std::make_unique<AST::ParallelForNode>(
+          token(record, 0), child(index, 0), child(index, 1),
+          std::move(reductions), child(index, 2));
+    }
+    case Kind::FuncDecl:
+      if (record.tokenCount % 2 != 1) {
+        throw ASTCache::Error("bad function declaration");
+      }
+      return std::make_unique<AST::FuncDeclNode>(
+          token(record, 0), child(index, 0), child(index, 1), child(index, 2),
+          (record.flags & ASYNC) != 0, (record.flags & CONST) != 0,
+          attributes(record, 1));
+    case Kind::StructDecl: {
+      uint32_t fieldCount = record.childCount;
+      if (record.tokenCount < 1 + fieldCount ||
+          (record.tokenCount - 1 - fieldCount) % 2 != 0) {
+        throw ASTCache::Error("bad struct declaration");
+      }
+      std::vector<AST::StructDeclNode::Field> fields;
+      for (uint32_t i = 0; i < fieldCount; ++i) {
+        fields.push_back({token(record, 1 + i), child(index, i)});
+      }
+      return std::make_unique<AST::StructDeclNode>(
+          token(record, 0), std::move(fields),
+          attributes(record, 1 + fieldCount));
+    }
+    case Kind::FuncCall:
+      return std::make_unique<AST::FuncCallNode>(token(record, 0),
+                                                 child(index, 0));
+    case Kind::ReturnStmt:
+      return std::make_unique<AST::ReturnStmtNode>(child(index, 0),
+                                                   (record.flags & TAIL) != 0);
+    case Kind::PrintStmt:
+      return std::make_unique<AST::PrintStmtNode>(child(index, 0));
+    case Kind::SpawnStmt:
+      return std::make_unique<AST::SpawnStmtNode>(child(index, 0));
+    case Kind::ExprStmt:
+      return std::make_unique<AST::ExprStmtNode>(child(index, 0));
+    case Kind::BinaryOp:
+      return std::make_unique<AST::BinaryOpNode>(
+          token(record, 0), child(index, 0), child(index, 1));
+    case Kind::UnaryOp:
+      return std::make_unique<AST::UnaryOpNode>(token(record, 0),
+                                                child(index, 0));
+    case Kind::Await:
+      return std::make_unique<AST::AwaitNode>(child(index, 0));
+    case Kind::FieldAccess:
+      return std::make_unique<AST::FieldAccessNode>(child(index, 0),
+                                                    token(record, 0));
+    case Kind::Number:
+      return std::make_unique<AST::NumberNode>(token(record, 0));
+    case Kind::Boolean:
+      return std::make_unique<AST::BooleanNode>(token(record, 0));
+    case Kind::Identifier:
+      return std::make_unique<AST::IdentifierNode>(token(record, 0));
+    case Kind::Type:
+      return std::make_unique<AST::TypeNode>(token(record, 0));
+    case Kind::ParamList: {
+      if (record.tokenCount != record.childCount) {
+        throw ASTCache::Error("bad parameter list");
+      }
+      auto params = std::make_unique<AST::ParamListNode>();
+      for (uint32_t i = 0; i < record.childCount; ++i) {
+        params->addParam(token(record, i), child(index, i));
+      }
+      return params;
+    }
+    case Kind::ArgList: {
+      auto args = std::make_unique<AST::ArgListNode>();
+      for (auto &arg : allChildren(index)) {
+        args->addArg(std::move(arg));
+      }
+      return args;
+    }
+    case Kind::Count:
+      break;
+    }
+    throw ASTCache::Error("unknown node kind");
+  }
+};
+
+template <typename T>
+void writeTable(std::ofstream &out, const std::vector<T> &table) {
+  size_t bytes = table.size() * sizeof(T);
+  out.write(reinterpret_cast<const char *>(table.data()), bytes);
+  static constexpr char padding[4] = {};
+  out.write(padding, (4 - bytes % 4) % 4);
+}
+
+} // namespace
+
+// FNV-1a. The key also holds the size, which makes an accidental match of
+// two different sources even less likely.
+ASTCache::Key ASTCache::key(std::string_view source) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (unsigned char c : source) {
+    hash = (hash ^ c) * 0x100000001b3;
+  }
+  return {hash, source.size()};
+}
+
+std::filesystem::path ASTCache::path(const std::filesystem::path &directory,
+                                     const Key &key) {
+  return directory / std::format("{:016x}.odeast", key.hash);
+}
+
+AST::NodePtr ASTCache::load(const std::filesystem::path &path,
+                            const Key &key) {
+  Mapping mapping(path);
+  if (!mapping.data()) {
+    return nullptr;
+  }
+  try {
+    Loader loader(mapping, key);
+    return loader.load();
+  } catch (const Error &) {
+    return nullptr;
+  }
+}
+
+// The file is written under a temporary name and renamed into place, so
+// concurrent compiles never map a half-written cache.
+void ASTCache::store(const std::filesystem::path &path, const Key &key,
+                     const AST::Node &root,
+                     const SemanticAnalyzer *analysis) {
+  Writer writer(analysis);
+  writer.write(&root);
+
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.byteOrder = BYTE_ORDER_MARK;
+  header.sourceHash = key.hash;
+  header.sourceSize = key.size;
+  header.nodeCount = static_cast<uint32_t>(writer.nodes.size());
+  header.tokenCount = static_cast<uint32_t>(writer.tokens.size());
+  header.childCount = static_cast<uint32_t>(writer.children.size());
+  header.stringCount = static_cast<uint32_t>(writer.stringOffsets.size() - 1);
+  header.stringBytes = static_cast<uint32_t>(writer.strings.size());
+
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+  std::filesystem::path temporary = path;
+  temporary += std::format(".{}.tmp", getpid());
+
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw Error("could not write AST cache", temporary.string());
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeTable(out, writer.nodes);
+    writeTable(out, writer.tokens);
+    writeTable(out, writer.children);
+    writeTable(out, writer.stringOffsets);
+    out.write(writer.strings.data(), writer.strings.size());
+    if (!out) {
+      throw Error("could not write AST cache", temporary.string());
+    }
+  }
+
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    throw Error("could not write AST cache", ec.message());
+  }
+}
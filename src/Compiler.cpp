@@ -1,45 +1,433 @@
 #include "Compiler.hpp"
 
+#include <algorithm>
 #include <format>
+#include <iostream>
+#include <iterator>
 #include <memory>
+#include <print>
 #include <string>
 #include <vector>
 
+#include "ASTCache.hpp"
 #include "IRGenerator.hpp"
+#include "Interface.hpp"
+#include "Interpreter/BytecodeCompiler.hpp"
+#include "Interpreter/VM.hpp"
 #include "Lexer/Lexer.hpp"
 #include "Linker.hpp"
+#include "Optimizer/ASTPass.hpp"
 #include "Parser/AST.hpp"
 #include "Parser/ASTPrinter.hpp"
+#include "Parser/ASTStatistics.hpp"
 #include "Parser/Parser.hpp"
 #include "Reader.hpp"
+#include "Remarks.hpp"
 #include "SemanticAnalyzer.hpp"
+#include "TieredJIT.hpp"
 
-Compiler::Compiler(const char *filePath) : filePath(filePath) {}
+Compiler::Compiler(Options options) : options(std::move(options)) {}
 
-void Compiler::run() {
+void Compiler::startPhase(const std::string &name) {
+  if (memoryReport) {
+    memoryReport->startPhase(name);
+  }
+  if (timeReport) {
+    timeReport->startPhase(name);
+  }
+}
+
+int Compiler::run() {
+  if (options.memReport) {
+    memoryReport = std::make_unique<MemoryReport>();
+  }
+  if (options.timeReport) {
+    timeReport = std::make_unique<TimeReport>();
+  }
+
+  std::vector<SourceModule> modules;
+  for (const auto &input : options.inputs) {
+    modules.push_back(parseModule(input));
+  }
+
+  if (options.printDependencies) {
+    printDependencies(modules);
+    return 0;
+  }
+
+  int status = 0;
+  if (options.interpret) {
+    status = interpret(modules);
+  } else {
+    build(modules);
+  }
+
+  if (memoryReport) {
+    memoryReport->print(std::cerr);
+    memoryReport.reset();
+  }
+  if (timeReport) {
+    timeReport->print(std::cerr);
+  }
+  return status;
+}
+
+void Compiler::build(std::vector<SourceModule> &modules) {
+  std::vector<std::filesystem::path> outputs;
+  for (auto &module : modules) {
+    std::ranges::move(compileModule(module, modules),
+                      std::back_inserter(outputs));
+  }
+
+  if (options.emit == Options::Emit::Executable) {
+    startPhase("link");
+    outputs.insert(outputs.end(), options.objects.begin(),
+                   options.objects.end());
+    auto linker = std::make_unique<Linker>(outputs);
+    if (options.lto) {
+      linker->enableThinLTO(options.optLevel);
+    }
+    if (options.runtime == Options::Runtime::Tiny) {
+      linker->useTinyRuntime();
+    }
+    std::filesystem::path executable = options.output;
+    if (executable.empty()) {
+      executable = modules.empty()
+                       ? std::filesystem::path(options.objects.front()).stem()
+                       : std::filesystem::path(modules.front().name);
+    }
+    linker->link(executable);
+  }
+}
+
+// --interp: the checked modules run on the bytecode VM, so no IR, object
+// file or executable is ever made. With --tiered, the analyzers are kept
+// for the JIT, which generates IR from the same trees once the VM asks.
+int Compiler::interpret(std::vector<SourceModule> &modules) {
+  BytecodeCompiler bytecode;
+  std::vector<std::unique_ptr<SemanticAnalyzer>> analyzers;
+  std::vector<TieredJIT::Module> jitModules;
+  for (auto &module : modules) {
+    std::vector<FunctionSignature> externals =
+        externalSignatures(module, modules);
+    for (const auto &signature : externals) {
+      bytecode.declare(signature);
+    }
+    std::unique_ptr<SemanticAnalyzer> analyzer =
+        analyzeModule(module, externals);
+
+    startPhase(std::format("bytecode {}", module.name));
+    bytecode.compile(*module.root, *analyzer);
+    if (options.tiered) {
+      jitModules.push_back({module.name, module.root.get(), analyzer.get(),
+                            std::move(externals)});
+      analyzers.push_back(std::move(analyzer));
+    }
+  }
+
+  Bytecode::Program program = bytecode.finish();
+  // Hot code is what optimization pays off for, so the JIT works at -O2
+  // unless asked for more.
+  std::unique_ptr<TieredJIT> jit;
+  if (options.tiered) {
+    jit = std::make_unique<TieredJIT>(std::move(jitModules), program,
+                                      std::max(options.optLevel, 2u),
+                                      options.arithmetic);
+  }
+
+  startPhase("run");
+  VM vm(std::move(program));
+  if (jit) {
+    vm.setNativeCode(jit.get());
+  }
+  return vm.run();
+}
+
+Compiler::SourceModule Compiler::parseModule(const std::string &filePath) {
+  startPhase(std::format("read {}", filePath));
   std::unique_ptr<Reader> reader = std::make_unique<Reader>(filePath);
   std::string fileText = reader->readAll();
+  std::string name = reader->getFileName();
 
-  std::unique_ptr<Lexer> lexer = std::make_unique<Lexer>(fileText);
-  std::vector<Token> tokens = lexer->tokenize();
+  // On a hit the cache path is cleared, since there is nothing to write
+  // back after analysis.
+  AST::NodePtr root;
+  ASTCache::Key cacheKey;
+  std::filesystem::path cachePath;
+  if (!options.astCache.empty()) {
+    startPhase(std::format("load AST {}", name));
+    cacheKey = ASTCache::key(fileText);
+    cachePath = ASTCache::path(options.astCache, cacheKey);
+    root = ASTCache::load(cachePath, cacheKey);
+    if (root) {
+      cachePath.clear();
+    }
+  }
+  if (!root) {
+    root = parseSource(name, fileText);
+  }
 
-  std::unique_ptr<Parser> parser = std::make_unique<Parser>(tokens);
-  AST::NodePtr root = parser->parse();
+  if (memoryReport) {
+    ASTStatistics statistics;
+    root->accept(statistics);
+    for (const auto &[kind, stats] : statistics.kinds()) {
+      memoryReport->recordNodes(name, kind, stats.count, stats.bytes);
+    }
+  }
 
   auto printer = std::make_unique<ASTPrinter>();
   // printer->visit(static_cast<const AST::ProgramNode&>(*root));
 
+  auto signatures = SemanticAnalyzer::collectSignatures(*root);
+  return {name, reader->getFilePath(), std::move(root), std::move(signatures),
+          cacheKey, std::move(cachePath)};
+}
+
+AST::NodePtr Compiler::parseSource(const std::string &name,
+                                   const std::string &text) {
+  startPhase(std::format("lex {}", name));
+  std::unique_ptr<Lexer> lexer = std::make_unique<Lexer>(text);
+  std::vector<Token> tokens = lexer->tokenize();
+  if (memoryReport) {
+    memoryReport->recordTokens(name, tokens.size(),
+                               tokens.capacity() * sizeof(Token));
+  }
+
+  startPhase(std::format("parse {}", name));
+  std::unique_ptr<Parser> parser = std::make_unique<Parser>(tokens);
+  return parser->parse();
+}
+
+// Functions defined in the other input files are visible as external
+// declarations, so calls across files resolve at link time. Modules compiled
+// earlier on their own are only known by their interface files.
+std::vector<FunctionSignature>
+Compiler::externalSignatures(const SourceModule &module,
+                             const std::vector<SourceModule> &program) const {
+  std::vector<FunctionSignature> externals;
+  for (const auto &other : program) {
+    if (&other != &module) {
+      externals.insert(externals.end(), other.signatures.begin(),
+                       other.signatures.end());
+    }
+  }
+
+  const auto &root = static_cast<const AST::ProgramNode &>(*module.root);
+  for (const auto &import : root.imports()) {
+    std::ranges::move(importedSignatures(module, import, program),
+                      std::back_inserter(externals));
+  }
+  return externals;
+}
+
+std::unique_ptr<SemanticAnalyzer>
+Compiler::analyzeModule(SourceModule &module,
+                        const std::vector<FunctionSignature> &externals) {
+  startPhase(std::format("analyze {}", module.name));
   auto analyzer = std::make_unique<SemanticAnalyzer>();
-  analyzer->analyze(*root);
+  for (const auto &signature : externals) {
+    analyzer->declareExternal(signature);
+  }
+  if (options.emit != Options::Emit::Executable || !options.objects.empty()) {
+    analyzer->allowMissingMain();
+  }
+
+  // The bytecode compiler takes the types of expressions from the analyzer.
+  if (!module.cachePath.empty() || options.interpret) {
+    analyzer->recordExpressionTypes();
+  }
+  analyzer->analyze(*module.root);
+  if (!module.cachePath.empty()) {
+    // The AST passes below rewrite the tree, so it is saved as checked.
+    try {
+      ASTCache::store(module.cachePath, module.cacheKey, *module.root,
+                      analyzer.get());
+    } catch (const std::exception &err) {
+      std::println(stderr, "[Warning] {}", err.what());
+    }
+  }
+  if (memoryReport) {
+    memoryReport->recordScopes(module.name, analyzer->peakScopeSizes());
+  }
+  // Only outputs that get linked later need an interface next to them.
+  bool linkable = options.emit == Options::Emit::Object ||
+                  options.emit == Options::Emit::Bitcode;
+  if (linkable && options.output != "-") {
+    Interface::write(interfacePath(module), module.name, module.signatures);
+  }
 
+  startPhase(std::format("AST passes {}", module.name));
+  ASTPassManager passes = ASTPassManager::createDefault();
+  passes.run(*module.root);
+  return analyzer;
+}
+
+std::vector<std::filesystem::path>
+Compiler::compileModule(SourceModule &module,
+                        const std::vector<SourceModule> &program) {
+  std::vector<FunctionSignature> externals =
+      externalSignatures(module, program);
+  std::unique_ptr<SemanticAnalyzer> analyzer =
+      analyzeModule(module, externals);
+
+  startPhase(std::format("IR generation {}", module.name));
+  // Declared first so that it outlives the LLVM context it collects from.
+  std::unique_ptr<Remarks> remarks;
   std::unique_ptr<IRGenerator> irgen =
-      std::make_unique<IRGenerator>("myProgram");
+      std::make_unique<IRGenerator>(module.name, options.optLevel);
+  if (options.debugInfo != Options::DebugInfo::None) {
+    irgen->enableDebugInfo(
+        module.path,
+        options.debugInfo == Options::DebugInfo::LineTablesOnly);
+  }
+  const Options::RemarkKinds &kinds = options.remarks;
+  if (kinds.passed || kinds.missed || kinds.analysis || options.saveRemarks) {
+    irgen->trackLocations(module.path);
+    remarks = std::make_unique<Remarks>(
+        irgen->getModule()->getContext(), kinds,
+        options.saveRemarks ? std::format("{}.opt.yaml", module.name) : "");
+  }
+  irgen->keepFramePointers(options.framePointers);
+  irgen->setArithmetic(options.arithmetic);
+  if (options.instrumentFunctions) {
+    irgen->instrumentFunctions();
+  }
+  if (options.runtime == Options::Runtime::Tiny) {
+    irgen->useTinyRuntime();
+  }
+  if (!options.optLevelGiven) {
+    irgen->useDefaultCodeGenLevel();
+  }
+  for (const auto &signature : externals) {
+    irgen->declareExternal(signature);
+  }
+
+  irgen->generate(*module.root, *analyzer);
+  if (memoryReport) {
+    memoryReport->recordInstructions(
+        module.name, "after generation",
+        irgen->getModule()->getInstructionCount());
+  }
+
+  startPhase(std::format("optimize {}", module.name));
+  bool executable = options.emit == Options::Emit::Executable;
+  bool bitcode = options.emit == Options::Emit::Bitcode ||
+                 (executable && options.lto);
+  if (program.size() == 1 && executable && !bitcode) {
+    irgen->internalizeFunctions();
+  }
+  irgen->optimize(bitcode);
+  if (memoryReport) {
+    memoryReport->recordInstructions(
+        module.name, "after optimization",
+        irgen->getModule()->getInstructionCount());
+  }
 
-  irgen->generate(*root);
-  irgen->emitToFile(std::format("{}.ll", reader->getFileName()));
-  auto objectPath = std::format("{}.o", reader->getFileName());
-  irgen->emitObjectFile(objectPath);
+  startPhase(std::format("emit {}", module.name));
+  std::vector<std::filesystem::path> outputs;
+  if (bitcode) {
+    outputs.push_back(outputPath(module, "bc"));
+    irgen->emitBitcodeFile(outputs.front(), true);
+  } else if (options.emit == Options::Emit::LLVMIR) {
+    irgen->emitToFile(outputPath(module, "ll"));
+  } else {
+    // An explicit output path names a single file, so only the default names
+    // leave room for one file per code generation thread.
+    bool assembly = options.emit == Options::Emit::Assembly;
+    const char *extension = assembly ? "s" : "o";
+    if (!options.output.empty() && !executable) {
+      outputs.push_back(options.output);
+    } else if (options.codegenThreads == 1) {
+      outputs.push_back(std::format("{}.{}", module.name, extension));
+    } else {
+      for (unsigned i = 0; i < options.codegenThreads; ++i) {
+        outputs.push_back(std::format("{}.{}.{}", module.name, i, extension));
+      }
+    }
+    irgen->emitMachineCode(outputs, assembly);
+  }
+
+  if (remarks) {
+    remarks->print(std::cerr);
+  }
+  return outputs;
+}
+
+// Intermediate files of an executable always get the default name; -o names
+// the executable itself.
+std::filesystem::path Compiler::outputPath(const SourceModule &module,
+                                           const char *extension) const {
+  if (!options.output.empty() && options.emit != Options::Emit::Executable) {
+    return options.output;
+  }
+  return std::format("{}.{}", module.name, extension);
+}
+
+std::vector<std::filesystem::path>
+Compiler::importSearchPath(const SourceModule &module) const {
+  std::vector<std::filesystem::path> searchPath = {
+      module.path.parent_path().empty() ? "." : module.path.parent_path(),
+      "."};
+  searchPath.insert(searchPath.end(), options.importPaths.begin(),
+                    options.importPaths.end());
+  return searchPath;
+}
+
+// Imports of modules compiled in the same run need nothing more: every
+// function of every input is visible to the others anyway.
+std::vector<FunctionSignature>
+Compiler::importedSignatures(const SourceModule &module, const Token &import,
+                             const std::vector<SourceModule> &program) const {
+  if (import.value == module.name) {
+    throw Interface::Error(std::format("module '{}' imports itself",
+                                       module.name));
+  }
+  for (const auto &other : program) {
+    if (other.name == import.value) {
+      return {};
+    }
+  }
+
+  std::optional<std::filesystem::path> path =
+      Interface::find(import.value, importSearchPath(module));
+  if (!path) {
+    throw Interface::Error(
+        std::format("cannot find module '{}'", import.value),
+        std::format("compile {0}.ode with --emit=obj to get {0}.odei, or "
+                    "pass it to -I",
+                    import.value));
+  }
+  return Interface::read(*path);
+}
+
+// Next to the object file, so build systems can treat both as outputs of
+// the same step.
+std::filesystem::path
+Compiler::interfacePath(const SourceModule &module) const {
+  if (!options.output.empty()) {
+    return std::filesystem::path(options.output).replace_extension("odei");
+  }
+  return std::format("{}.odei", module.name);
+}
 
-  auto linker = std::make_unique<Linker>(objectPath);
-  linker->link(reader->getFileName());
+// Make rules: each module's outputs depend on its source and on the
+// interfaces of the modules it imports.
+void Compiler::printDependencies(const std::vector<SourceModule> &modules) {
+  for (const auto &module : modules) {
+    std::string rule = std::format("{0}.o {0}.odei: {1}", module.name,
+                                   module.path.string());
+    const auto &root = static_cast<const AST::ProgramNode &>(*module.root);
+    for (const auto &import : root.imports()) {
+      if (std::ranges::any_of(modules, [&](const SourceModule &other) {
+            return other.name == import.value;
+          })) {
+        continue;
+      }
+      std::optional<std::filesystem::path> path =
+          Interface::find(import.value, importSearchPath(module));
+      rule += std::format(" {}", path ? path->string()
+                                      : std::format("{}.odei", import.value));
+    }
+    std::println("{}", rule);
+  }
 }
@@ -0,0 +1,92 @@
+#include "Interface.hpp"
+
+#include <fstream>
+
+#include "Lexer/Lexer.hpp"
+#include "Reader.hpp"
+
+void Interface::write(const std::filesystem::path &path,
+                      const std::string &module,
+                      const std::vector<FunctionSignature> &signatures) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    throw Error("could not write interface", path.string());
+  }
+
+  out << std::format("// Interface of module {}, generated by ode.\n", module);
+  for (const auto &signature : signatures) {
+    if (signature.name == "main") {
+      continue;
+    }
+
+    std::string params;
+    for (Type param : signature.params) {
+      params += std::format("{}{}", params.empty() ? "" : ", ",
+                            SemanticAnalyzer::typeName(param));
+    }
+    out << std::format("{}fn {}({}): {};\n", signature.isAsync ? "async " : "",
+                       signature.name, params,
+                       SemanticAnalyzer::typeName(signature.returnType));
+  }
+}
+
+// Interfaces are only ever written by write above, so a simple pass over the
+// tokens is enough; anything unexpected means the file is damaged.
+std::vector<FunctionSignature>
+Interface::read(const std::filesystem::path &path) {
+  Reader reader(path);
+  std::string text = reader.readAll();
+  std::vector<Token> tokens = Lexer(text).tokenize();
+
+  size_t pos = 0;
+  auto next = [&](Token::Type type, const char *expected) -> const Token & {
+    if (pos >= tokens.size() || tokens[pos].type != type) {
+      throw Error(std::format("malformed interface {}", path.string()),
+                  std::format("expected {}", expected));
+    }
+    return tokens[pos++];
+  };
+  auto peek = [&](Token::Type type) {
+    return pos < tokens.size() && tokens[pos].type == type;
+  };
+
+  std::vector<FunctionSignature> signatures;
+  while (pos < tokens.size()) {
+    FunctionSignature signature;
+    if (peek(Token::Type::Async)) {
+      signature.isAsync = true;
+      ++pos;
+    }
+    next(Token::Type::Fn, "'fn'");
+    signature.name = next(Token::Type::Identifier, "a function name").value;
+
+    next(Token::Type::LParen, "'('");
+    while (!peek(Token::Type::RParen)) {
+      if (!signature.params.empty()) {
+        next(Token::Type::Comma, "','");
+      }
+      signature.params.push_back(SemanticAnalyzer::typeFromName(
+          next(Token::Type::Type, "a parameter type").value));
+    }
+    next(Token::Type::RParen, "')'");
+    next(Token::Type::Colon, "':'");
+    signature.returnType = SemanticAnalyzer::typeFromName(
+        next(Token::Type::Type, "a return type").value);
+    next(Token::Type::Semicolon, "';'");
+
+    signatures.push_back(std::move(signature));
+  }
+  return signatures;
+}
+
+std::optional<std::filesystem::path>
+Interface::find(const std::string &module,
+                const std::vector<std::filesystem::path> &searchPath) {
+  for (const auto &directory : searchPath) {
+    std::filesystem::path candidate = directory / (module + ".odei");
+    if (std::filesystem::exists(candidate)) {
+      return candidate;
+    }
+  }
+  return std::nullopt;
+}
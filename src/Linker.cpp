@@ -5,16 +5,41 @@
 #include <stdexcept>
 #include <string>
 
-Linker::Linker(std::filesystem::path op) : objectPath(std::move(op)) {
-  if (!std::filesystem::exists(objectPath)) {
-    throw std::runtime_error(
-        std::format("Object file not found at {}", objectPath.string()));
+Linker::Linker(std::vector<std::filesystem::path> inputs)
+    : inputPaths(std::move(inputs)) {
+  for (const auto &input : inputPaths) {
+    if (!std::filesystem::exists(input)) {
+      throw std::runtime_error(
+          std::format("Input file not found at {}", input.string()));
+    }
   }
 }
 
+void Linker::enableThinLTO(unsigned optLevel) {
+  thinLTO = true;
+  ltoOptLevel = optLevel;
+}
+
 void Linker::link(const std::filesystem::path &executablePath) {
-  std::string command = std::format("clang++ {} -o {}", objectPath.string(),
-                                    executablePath.string());
+  std::string command = tinyRuntime ? "clang" : "clang++";
+  if (thinLTO) {
+    command += std::format(" -flto=thin -fuse-ld=lld -O{}", ltoOptLevel);
+  }
+  for (const auto &input : inputPaths) {
+    command += std::format(" {}", input.string());
+  }
+  if (tinyRuntime) {
+#ifdef ODE_TINY_RUNTIME_LIBRARY
+    command += std::format(" {} -static -nostdlib -no-pie -Wl,--gc-sections",
+                           ODE_TINY_RUNTIME_LIBRARY);
+#else
+    throw std::runtime_error("The tiny runtime is not built on this platform");
+#endif
+  } else {
+    command += std::format(" {} -pthread", ODE_RUNTIME_LIBRARY);
+  }
+  command += std::format(" -o {}", executablePath.string());
+
   int result = std::system(command.c_str());
   if (result != 0) {
     throw std::runtime_error(
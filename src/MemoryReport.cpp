@@ -0,0 +1,299 @@
+#include "MemoryReport.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <new>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define ODE_ALLOCATION_SIZE malloc_size
+#else
+#include <malloc.h>
+#define ODE_ALLOCATION_SIZE malloc_usable_size
+#endif
+
+// The counters cover every thread. Sizes are what malloc actually reserved,
+// which includes its rounding. Every block starts with a header holding the
+// size it was counted with, zero when it was allocated outside a report, so
+// that freeing a block subtracts exactly what allocating it added and blocks
+// from before the report are never subtracted.
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocatedBytes{0};
+std::atomic<uint64_t> freedBytes{0};
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<int64_t> liveBytes{0};
+std::atomic<int64_t> peakLiveBytes{0};
+
+// The header sits right before the pointer handed out; a larger alignment
+// pads the block out in front of it.
+constexpr size_t headerSize = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+size_t &countedSize(void *ptr) {
+  return *reinterpret_cast<size_t *>(static_cast<char *>(ptr) - sizeof(size_t));
+}
+
+void *countAllocation(void *block, size_t offset) {
+  void *ptr = static_cast<char *>(block) + offset;
+  countedSize(ptr) = 0;
+  if (!counting.load(std::memory_order_relaxed)) {
+    return ptr;
+  }
+  size_t size = ODE_ALLOCATION_SIZE(block);
+  countedSize(ptr) = size;
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+  int64_t live =
+      liveBytes.fetch_add(size, std::memory_order_relaxed) + (int64_t)size;
+  int64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+  while (live > peak && !peakLiveBytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+  return ptr;
+}
+
+void countFree(void *ptr) {
+  size_t size = countedSize(ptr);
+  if (size == 0) {
+    return;
+  }
+  freedBytes.fetch_add(size, std::memory_order_relaxed);
+  liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+size_t headerOffset(std::align_val_t align) {
+  return std::max(static_cast<size_t>(align), headerSize);
+}
+
+void *allocate(size_t size) {
+  void *block = std::malloc(headerSize + size);
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  return countAllocation(block, headerSize);
+}
+
+void *allocate(size_t size, std::align_val_t align) {
+  size_t alignment = std::max(static_cast<size_t>(align), sizeof(void *));
+  size_t offset = headerOffset(align);
+  void *block = nullptr;
+  if (posix_memalign(&block, alignment, offset + size) != 0) {
+    throw std::bad_alloc();
+  }
+  return countAllocation(block, offset);
+}
+
+void deallocate(void *ptr, size_t offset = headerSize) {
+  if (!ptr) {
+    return;
+  }
+  countFree(ptr);
+  std::free(static_cast<char *>(ptr) - offset);
+}
+
+void deallocate(void *ptr, std::align_val_t align) {
+  deallocate(ptr, headerOffset(align));
+}
+} // namespace
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void *operator new(size_t size, std::align_val_t align) {
+  return allocate(size, align);
+}
+void *operator new[](size_t size, std::align_val_t align) {
+  return allocate(size, align);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, std::align_val_t align) noexcept {
+  deallocate(ptr, align);
+}
+void operator delete[](void *ptr, std::align_val_t align) noexcept {
+  deallocate(ptr, align);
+}
+void operator delete(void *ptr, size_t, std::align_val_t align) noexcept {
+  deallocate(ptr, align);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t align) noexcept {
+  deallocate(ptr, align);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+
+static std::string formatBytes(double bytes) {
+  const char *units[] = {"B", "KiB", "MiB", "GiB"};
+  size_t unit = 0;
+  bool negative = bytes < 0;
+  double value = negative ? -bytes : bytes;
+  while (value >= 1024 && unit + 1 < std::size(units)) {
+    value /= 1024;
+    ++unit;
+  }
+  if (unit == 0) {
+    return std::format("{}{:.0f} B", negative ? "-" : "", value);
+  }
+  return std::format("{}{:.1f} {}", negative ? "-" : "", value, units[unit]);
+}
+
+// ru_maxrss is in kilobytes on Linux and in bytes on macOS.
+static uint64_t peakResidentBytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+MemoryReport::MemoryReport() {
+  counting.store(true, std::memory_order_relaxed);
+}
+
+MemoryReport::~MemoryReport() {
+  counting.store(false, std::memory_order_relaxed);
+}
+
+void MemoryReport::startPhase(const std::string &name) {
+  endPhase();
+
+  start_.name = name;
+  start_.allocated = allocatedBytes.load(std::memory_order_relaxed);
+  start_.freed = freedBytes.load(std::memory_order_relaxed);
+  start_.allocations = allocationCount.load(std::memory_order_relaxed);
+  peakLiveBytes.store(liveBytes.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+  inPhase_ = true;
+}
+
+void MemoryReport::endPhase() {
+  if (!inPhase_) {
+    return;
+  }
+
+  Phase phase{start_.name};
+  phase.allocated =
+      allocatedBytes.load(std::memory_order_relaxed) - start_.allocated;
+  phase.freed = freedBytes.load(std::memory_order_relaxed) - start_.freed;
+  phase.allocations =
+      allocationCount.load(std::memory_order_relaxed) - start_.allocations;
+  phase.peakLive = peakLiveBytes.load(std::memory_order_relaxed);
+  phases_.push_back(std::move(phase));
+  inPhase_ = false;
+}
+
+MemoryReport::Module &MemoryReport::module(const std::string &name) {
+  if (!modules_.contains(name)) {
+    moduleOrder_.push_back(name);
+  }
+  return modules_[name];
+}
+
+void MemoryReport::recordTokens(const std::string &module, size_t count,
+                                size_t bytes) {
+  Module &entry = this->module(module);
+  entry.tokens = count;
+  entry.tokenBytes = bytes;
+}
+
+void MemoryReport::recordNodes(const std::string &module,
+                               const std::string &kind, size_t count,
+                               size_t bytes) {
+  this->module(module).nodes[kind] = {count, bytes};
+}
+
+void MemoryReport::recordScopes(const std::string &module,
+                                const std::vector<size_t> &peakSizes) {
+  this->module(module).peakScopeSizes = peakSizes;
+}
+
+void MemoryReport::recordInstructions(const std::string &module,
+                                      const std::string &stage,
+                                      size_t count) {
+  this->module(module).instructions.emplace_back(stage, count);
+}
+
+void MemoryReport::print(std::ostream &out) {
+  endPhase();
+
+  out << "===== Memory report =====\n";
+  out << std::format("{:<28} {:>12} {:>12} {:>12} {:>10} {:>12}\n", "phase",
+                     "allocated", "freed", "net", "blocks", "peak live");
+  for (const Phase &phase : phases_) {
+    double net =
+        static_cast<double>(phase.allocated) - static_cast<double>(phase.freed);
+    out << std::format("{:<28} {:>12} {:>12} {:>12} {:>10} {:>12}\n",
+                       phase.name, formatBytes(phase.allocated),
+                       formatBytes(phase.freed), formatBytes(net),
+                       phase.allocations, formatBytes(phase.peakLive));
+  }
+
+  for (const std::string &name : moduleOrder_) {
+    const Module &module = modules_.at(name);
+    out << std::format("\n--- {} ---\n", name);
+    out << std::format("tokens: {} ({})\n", module.tokens,
+                       formatBytes(module.tokenBytes));
+
+    size_t nodeCount = 0;
+    size_t nodeBytes = 0;
+    for (const auto &[kind, node] : module.nodes) {
+      nodeCount += node.count;
+      nodeBytes += node.bytes;
+    }
+    out << std::format("AST nodes: {} ({})\n", nodeCount,
+                       formatBytes(nodeBytes));
+
+    std::vector<std::pair<std::string, Node>> kinds(module.nodes.begin(),
+                                                    module.nodes.end());
+    std::ranges::stable_sort(kinds, [](const auto &a, const auto &b) {
+      return a.second.bytes > b.second.bytes;
+    });
+    for (const auto &[kind, node] : kinds) {
+      out << std::format("  {:<16} {:>10} {:>12}\n", kind, node.count,
+                         formatBytes(node.bytes));
+    }
+
+    out << "peak symbols per scope depth:";
+    for (size_t depth = 0; depth < module.peakScopeSizes.size(); ++depth) {
+      out << std::format(" {}:{}", depth, module.peakScopeSizes[depth]);
+    }
+    out << '\n';
+
+    for (const auto &[stage, count] : module.instructions) {
+      out << std::format("LLVM instructions {}: {}\n", stage, count);
+    }
+  }
+
+  out << std::format("\npeak RSS: {}\n",
+                     formatBytes(static_cast<double>(peakResidentBytes())));
+}
@@ -0,0 +1,186 @@
+#include "Options.hpp"
+
+#include <algorithm>
+#include <ranges>
+#include <string_view>
+#include <thread>
+
+Options Options::parse(int argc, char *argv[]) {
+  Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+
+    if (arg.size() == 3 && arg.starts_with("-O") && arg[2] >= '0' &&
+        arg[2] <= '3') {
+      options.optLevel = arg[2] - '0';
+      options.optLevelGiven = true;
+    } else if (arg.starts_with("--emit=")) {
+      std::string_view kind = arg.substr(arg.find('=') + 1);
+      if (kind == "exe") {
+        options.emit = Emit::Executable;
+      } else if (kind == "obj") {
+        options.emit = Emit::Object;
+      } else if (kind == "asm") {
+        options.emit = Emit::Assembly;
+      } else if (kind == "llvm-ir") {
+        options.emit = Emit::LLVMIR;
+      } else if (kind == "bitcode") {
+        options.emit = Emit::Bitcode;
+      } else {
+        throw Error("unknown output kind", std::string(kind));
+      }
+    } else if (arg == "-o") {
+      if (i + 1 == argc) {
+        throw Error("missing output path after '-o'");
+      }
+      options.output = argv[++i];
+    } else if (arg == "--lto") {
+      options.lto = true;
+    } else if (arg == "-g") {
+      options.debugInfo = DebugInfo::Full;
+    } else if (arg == "-gline-tables-only") {
+      options.debugInfo = DebugInfo::LineTablesOnly;
+    } else if (arg == "-g0") {
+      options.debugInfo = DebugInfo::None;
+    } else if (arg == "-fno-omit-frame-pointer") {
+      options.framePointers = true;
+    } else if (arg == "-fomit-frame-pointer") {
+      options.framePointers = false;
+    } else if (arg == "-fwrapv") {
+      options.arithmetic.wrap = true;
+    } else if (arg == "-fno-wrapv") {
+      options.arithmetic.wrap = false;
+    } else if (arg == "-ffast-math") {
+      options.arithmetic.fastMath = true;
+    } else if (arg == "-fno-fast-math") {
+      options.arithmetic.fastMath = false;
+    } else if (arg.starts_with("-ffp-contract=")) {
+      std::string_view kind = arg.substr(arg.find('=') + 1);
+      if (kind == "off") {
+        options.arithmetic.contract = Arithmetic::Contract::Off;
+      } else if (kind == "on") {
+        options.arithmetic.contract = Arithmetic::Contract::On;
+      } else if (kind == "fast") {
+        options.arithmetic.contract = Arithmetic::Contract::Fast;
+      } else {
+        throw Error("unknown fp contraction", std::string(kind));
+      }
+    } else if (arg.starts_with("--runtime=")) {
+      std::string_view kind = arg.substr(arg.find('=') + 1);
+      if (kind == "default") {
+        options.runtime = Runtime::Default;
+      } else if (kind == "tiny") {
+        options.runtime = Runtime::Tiny;
+      } else {
+        throw Error("unknown runtime", std::string(kind));
+      }
+    } else if (arg.starts_with("--instrument=")) {
+      std::string_view kind = arg.substr(arg.find('=') + 1);
+      if (kind != "functions") {
+        throw Error("unknown instrumentation", std::string(kind));
+      }
+      options.instrumentFunctions = true;
+    } else if (arg == "-j") {
+      options.codegenThreads =
+          std::max(std::thread::hardware_concurrency(), 1u);
+    } else if (arg.starts_with("-j")) {
+      std::string digits(arg.substr(2));
+      if (digits.size() > 4 ||
+          digits.find_first_not_of("0123456789") != std::string::npos ||
+          std::stoul(digits) == 0) {
+        throw Error("invalid thread count", std::string(arg));
+      }
+      options.codegenThreads = std::stoul(digits);
+    } else if (arg.starts_with("--remarks=")) {
+      std::string_view kinds = arg.substr(arg.find('=') + 1);
+      for (auto part : std::views::split(kinds, ',')) {
+        std::string_view kind(part.begin(), part.end());
+        if (kind == "all") {
+          options.remarks = {true, true, true};
+        } else if (kind == "passed") {
+          options.remarks.passed = true;
+        } else if (kind == "missed") {
+          options.remarks.missed = true;
+        } else if (kind == "analysis") {
+          options.remarks.analysis = true;
+        } else {
+          throw Error("unknown remark kind", std::string(kind));
+        }
+      }
+    } else if (arg == "--save-remarks") {
+      options.saveRemarks = true;
+    } else if (arg == "--mem-report") {
+      options.memReport = true;
+    } else if (arg == "--time-report") {
+      options.timeReport = true;
+    } else if (arg.starts_with("--ast-cache=")) {
+      options.astCache = arg.substr(arg.find('=') + 1);
+      if (options.astCache.empty()) {
+        throw Error("missing directory after '--ast-cache='");
+      }
+    } else if (arg == "-I") {
+      if (i + 1 == argc) {
+        throw Error("missing directory after '-I'");
+      }
+      options.importPaths.emplace_back(argv[++i]);
+    } else if (arg.starts_with("-I")) {
+      options.importPaths.emplace_back(arg.substr(2));
+    } else if (arg == "-M") {
+      options.printDependencies = true;
+    } else if (arg == "--interp") {
+      options.interpret = true;
+    } else if (arg == "--tiered") {
+      options.interpret = true;
+      options.tiered = true;
+    } else if (arg.starts_with("-")) {
+      throw Error("unknown option", std::string(arg));
+    } else if (arg.ends_with(".o") || arg.ends_with(".a")) {
+      options.objects.emplace_back(arg);
+    } else {
+      options.inputs.emplace_back(arg);
+    }
+  }
+
+  if (options.inputs.empty() && options.objects.empty()) {
+    throw Error("No input file found");
+  }
+  if (!options.output.empty() && options.emit != Emit::Executable &&
+      options.inputs.size() > 1) {
+    throw Error("cannot use '-o' with several inputs",
+                "only --emit=exe combines them into one output");
+  }
+  if (options.output == "-" && options.emit == Emit::Executable) {
+    throw Error("cannot write an executable to standard output");
+  }
+  // Partitions are compiled in LLVM contexts of their own, where nothing
+  // collects the backend's remarks.
+  const RemarkKinds &kinds = options.remarks;
+  if (kinds.passed || kinds.missed || kinds.analysis || options.saveRemarks) {
+    options.codegenThreads = 1;
+  }
+  if (options.interpret &&
+      (options.emit != Emit::Executable || !options.output.empty())) {
+    throw Error("cannot use '--interp' or '--tiered' with '--emit' or '-o'",
+                "the interpreter runs the program instead of writing it out");
+  }
+  if (options.interpret && !options.objects.empty()) {
+    throw Error("cannot use '--interp' or '--tiered' with object files",
+                "pass the sources of every module instead");
+  }
+  if (options.runtime == Runtime::Tiny) {
+#ifndef ODE_TINY_RUNTIME_LIBRARY
+    throw Error("cannot use '--runtime=tiny'",
+                "the tiny runtime is only built on x86-64 Linux");
+#endif
+    if (options.interpret) {
+      throw Error("cannot use '--runtime=tiny' with '--interp' or '--tiered'");
+    }
+    if (options.instrumentFunctions) {
+      throw Error("cannot use '--runtime=tiny' with '--instrument=functions'",
+                  "the profile is kept by the default runtime");
+    }
+  }
+
+  return options;
+}
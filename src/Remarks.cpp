@@ -0,0 +1,134 @@
+#include "Remarks.hpp"
+
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LLVMRemarkStreamer.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/ToolOutputFile.h>
+
+#include <algorithm>
+#include <print>
+
+namespace {
+
+// Passes only build the remarks their context's handler asks for, which
+// keeps the cost of the kinds nobody prints away.
+class RemarkHandler : public llvm::DiagnosticHandler {
+public:
+  RemarkHandler(Remarks &remarks, Options::RemarkKinds kinds)
+      : remarks_(remarks), kinds_(kinds) {}
+
+  bool isPassedOptRemarkEnabled(llvm::StringRef) const override {
+    return kinds_.passed;
+  }
+  bool isMissedOptRemarkEnabled(llvm::StringRef) const override {
+    return kinds_.missed;
+  }
+  bool isAnalysisRemarkEnabled(llvm::StringRef) const override {
+    return kinds_.analysis;
+  }
+  bool isAnyRemarkEnabled() const override {
+    return kinds_.passed || kinds_.missed || kinds_.analysis;
+  }
+
+  // Other diagnostics, such as backend warnings, keep LLVM's default
+  // handling.
+  bool handleDiagnostics(const llvm::DiagnosticInfo &info) override {
+    auto *remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info);
+    if (!remark) {
+      return false;
+    }
+    remarks_.add(*remark);
+    return true;
+  }
+
+private:
+  Remarks &remarks_;
+  Options::RemarkKinds kinds_;
+};
+
+} // namespace
+
+Remarks::Remarks(llvm::LLVMContext &context, Options::RemarkKinds kinds,
+                 const std::filesystem::path &yamlPath)
+    : kinds_(kinds) {
+  context.setDiagnosticHandler(std::make_unique<RemarkHandler>(*this, kinds));
+
+  if (yamlPath.empty()) {
+    return;
+  }
+  llvm::Expected<std::unique_ptr<llvm::ToolOutputFile>> file =
+      llvm::setupLLVMOptimizationRemarks(context, yamlPath.string(), "",
+                                         "yaml", false);
+  if (!file) {
+    throw Error(std::format("cannot write remarks to '{}'", yamlPath.string()),
+                llvm::toString(file.takeError()));
+  }
+  yaml_ = std::move(*file);
+}
+
+Remarks::~Remarks() {
+  if (yaml_) {
+    yaml_->keep();
+  }
+}
+
+void Remarks::add(const llvm::DiagnosticInfoOptimizationBase &remark) {
+  Kind kind;
+  switch (remark.getKind()) {
+  case llvm::DK_OptimizationRemark:
+  case llvm::DK_MachineOptimizationRemark:
+    if (!kinds_.passed) {
+      return;
+    }
+    kind = Kind::Passed;
+    break;
+  case llvm::DK_OptimizationRemarkMissed:
+  case llvm::DK_MachineOptimizationRemarkMissed:
+  case llvm::DK_OptimizationFailure:
+    if (!kinds_.missed) {
+      return;
+    }
+    kind = Kind::Missed;
+    break;
+  default:
+    if (!kinds_.analysis) {
+      return;
+    }
+    kind = Kind::Analysis;
+    break;
+  }
+
+  Remark entry{"", 0, 0, kind, remark.getFunction().getName().str(),
+               remark.getPassName(), remark.getMsg()};
+  if (remark.isLocationAvailable()) {
+    llvm::DiagnosticLocation location = remark.getLocation();
+    entry.file = location.getRelativePath();
+    entry.line = location.getLine();
+    entry.column = location.getColumn();
+  }
+  remarks_.push_back(std::move(entry));
+}
+
+// Unrolled and inlined code repeats the same remark for the same source
+// position, so duplicates are only printed once.
+void Remarks::print(std::ostream &out) {
+  std::ranges::sort(remarks_);
+  auto duplicates = std::ranges::unique(remarks_);
+  remarks_.erase(duplicates.begin(), duplicates.end());
+
+  for (const auto &remark : remarks_) {
+    const char *kind = remark.kind == Kind::Passed   ? "Passed"
+                       : remark.kind == Kind::Missed ? "Missed"
+                                                     : "Analysis";
+    std::string position =
+        remark.file.empty()
+            ? remark.function
+            : std::format("{}:{}:{}", remark.file, remark.line, remark.column);
+    std::println(out, "[{}] {}: {} ({} in '{}')", kind, position,
+                 remark.message, remark.pass, remark.function);
+  }
+  remarks_.clear();
+}
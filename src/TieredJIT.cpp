@@ -0,0 +1,209 @@
+#include "TieredJIT.hpp"
+
+#include <llvm/ExecutionEngine/Orc/AbsoluteSymbols.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <print>
+
+#include "IRGenerator.hpp"
+#include "ode_runtime.h"
+
+// A function is eligible unless it is async or may reach an await, a spawn
+// or a sleep. Calls are followed backwards until nothing changes.
+static std::vector<bool> eligibleFunctions(const Bytecode::Program &program) {
+  using Op = Bytecode::Op;
+  size_t count = program.functions.size();
+  std::vector<bool> eligible(count, true);
+  std::vector<std::vector<uint16_t>> callers(count);
+  for (size_t i = 0; i < count; ++i) {
+    const Bytecode::Function &function = program.functions[i];
+    if (function.isAsync || !function.source) {
+      eligible[i] = false;
+    }
+    for (const auto &instruction : function.code) {
+      if (instruction.op == Op::Await || instruction.op == Op::Spawn ||
+          instruction.op == Op::Sleep) {
+        eligible[i] = false;
+      } else if (instruction.op == Op::Call ||
+                 instruction.op == Op::TailCall) {
+        callers[instruction.b].push_back(static_cast<uint16_t>(i));
+      }
+    }
+  }
+
+  std::vector<uint16_t> pending;
+  for (size_t i = 0; i < count; ++i) {
+    if (!eligible[i]) {
+      pending.push_back(static_cast<uint16_t>(i));
+    }
+  }
+  while (!pending.empty()) {
+    uint16_t callee = pending.back();
+    pending.pop_back();
+    for (uint16_t caller : callers[callee]) {
+      if (eligible[caller]) {
+        eligible[caller] = false;
+        pending.push_back(caller);
+      }
+    }
+  }
+  return eligible;
+}
+
+TieredJIT::TieredJIT(std::vector<Module> modules,
+                     const Bytecode::Program &program, unsigned optLevel,
+                     const Options::Arithmetic &arithmetic)
+    : modules_(std::move(modules)), optLevel_(optLevel),
+      arithmetic_(arithmetic) {
+  std::vector<bool> eligible = eligibleFunctions(program);
+  for (size_t i = 0; i < program.functions.size(); ++i) {
+    const Bytecode::Function &function = program.functions[i];
+    functions_.push_back({std::format("{}.cells", function.name),
+                          function.module, function.source, nullptr,
+                          {}, eligible[i]});
+  }
+  for (size_t i = 0; i < program.loops.size(); ++i) {
+    const Bytecode::Loop &loop = program.loops[i];
+    const Bytecode::Function &function = program.functions[loop.function];
+    loops_.push_back({std::format("{}.loop{}", function.name, i),
+                      function.module, function.source, loop.source,
+                      loop.scopes, eligible[loop.function]});
+  }
+  functionEntries_.assign(functions_.size(), nullptr);
+  loopEntries_.assign(loops_.size(), nullptr);
+}
+
+TieredJIT::~TieredJIT() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void TieredJIT::compile() { thread_ = std::thread([this] { build(); }); }
+
+bool TieredJIT::ready() const {
+  return ready_.load(std::memory_order_acquire);
+}
+
+TieredJIT::Entry TieredJIT::function(uint16_t index) const {
+  return functionEntries_[index];
+}
+
+TieredJIT::Entry TieredJIT::loop(uint16_t index) const {
+  return loopEntries_[index];
+}
+
+template <typename T> static T check(llvm::Expected<T> value) {
+  if (!value) {
+    throw TieredJIT::Error(llvm::toString(value.takeError()));
+  }
+  return std::move(*value);
+}
+
+static void check(llvm::Error error) {
+  if (error) {
+    throw TieredJIT::Error(llvm::toString(std::move(error)));
+  }
+}
+
+void TieredJIT::build() {
+  try {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    std::unique_ptr<llvm::orc::LLJIT> jit =
+        check(llvm::orc::LLJITBuilder().create());
+
+    // The runtime is linked into ode itself, which need not export it, so
+    // its symbols are handed over by address. Anything else, such as
+    // libm, comes from the process.
+    llvm::orc::JITDylib &dylib = jit->getMainJITDylib();
+    llvm::orc::MangleAndInterner mangle(jit->getExecutionSession(),
+                                        jit->getDataLayout());
+    llvm::orc::SymbolMap runtime;
+    auto define = [&](const char *name, auto *address) {
+      runtime[mangle(name)] = {llvm::orc::ExecutorAddr::fromPtr(address),
+                               llvm::JITSymbolFlags::Exported};
+    };
+    define("ode_print_i32", &ode_print_i32);
+    define("ode_print_f32", &ode_print_f32);
+    define("ode_print_bool", &ode_print_bool);
+    define("ode_flush", &ode_flush);
+    define("ode_parallel_for", &ode_parallel_for);
+    define("ode_parallel_lock", &ode_parallel_lock);
+    define("ode_parallel_unlock", &ode_parallel_unlock);
+    define("ode_coro_alloc", &ode_coro_alloc);
+    define("ode_coro_free", &ode_coro_free);
+    define("ode_coro_schedule", &ode_coro_schedule);
+    define("ode_block_on", &ode_block_on);
+    define("ode_sleep", &ode_sleep);
+    define("ode_spawn", &ode_spawn);
+    define("ode_run_tasks", &ode_run_tasks);
+    define("ode_prof_enter", &ode_prof_enter);
+    define("ode_prof_exit", &ode_prof_exit);
+    check(dylib.define(llvm::orc::absoluteSymbols(std::move(runtime))));
+    dylib.addGenerator(check(
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            jit->getDataLayout().getGlobalPrefix())));
+
+    for (unsigned index = 0; index < modules_.size(); ++index) {
+      const Module &module = modules_[index];
+      IRGenerator irgen(module.name, optLevel_);
+      irgen.setArithmetic(arithmetic_);
+      for (const auto &signature : module.externals) {
+        irgen.declareExternal(signature);
+      }
+      irgen.generate(*module.root, *module.analysis);
+
+      for (const Site &site : functions_) {
+        if (site.eligible && site.module == index) {
+          irgen.generateCellEntry(site.entry, *site.function,
+                                  *module.analysis);
+        }
+      }
+      for (const Site &site : loops_) {
+        if (!site.eligible || site.module != index) {
+          continue;
+        }
+        std::vector<std::vector<IRGenerator::CellVariable>> scopes;
+        for (const auto &locals : site.scopes) {
+          auto &variables = scopes.emplace_back();
+          for (const auto &local : locals) {
+            variables.push_back({local.name, local.type, local.reg});
+          }
+        }
+        irgen.generateLoopEntry(site.entry, *site.function, *site.loop,
+                                scopes, *module.analysis);
+      }
+
+      irgen.optimize();
+      auto [context, llvmModule] = irgen.release();
+      check(jit->addIRModule(llvm::orc::ThreadSafeModule(
+          std::move(llvmModule),
+          llvm::orc::ThreadSafeContext(std::move(context)))));
+    }
+
+    // Looking the entries up compiles every module.
+    auto lookup = [&](const std::vector<Site> &sites,
+                      std::vector<Entry> &entries) {
+      for (size_t i = 0; i < sites.size(); ++i) {
+        if (sites[i].eligible) {
+          entries[i] = check(jit->lookup(sites[i].entry)).toPtr<Entry>();
+        }
+      }
+    };
+    lookup(functions_, functionEntries_);
+    lookup(loops_, loopEntries_);
+    jit_ = std::move(jit);
+  } catch (const std::exception &err) {
+    std::println(stderr, "[Warning] JIT: {}; staying in the interpreter",
+                 err.what());
+    functionEntries_.assign(functions_.size(), nullptr);
+    loopEntries_.assign(loops_.size(), nullptr);
+  }
+  ready_.store(true, std::memory_order_release);
+}
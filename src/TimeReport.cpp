@@ -0,0 +1,33 @@
+#include "TimeReport.hpp"
+
+#include <format>
+
+void TimeReport::startPhase(const std::string &name) {
+  endPhase();
+  current_ = name;
+  inPhase_ = true;
+  start_ = Clock::now();
+}
+
+void TimeReport::endPhase() {
+  if (!inPhase_) {
+    return;
+  }
+  phases_.emplace_back(std::move(current_), Clock::now() - start_);
+  inPhase_ = false;
+}
+
+void TimeReport::print(std::ostream &out) {
+  endPhase();
+
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  Milliseconds total{0};
+
+  out << "===== Time report =====\n";
+  for (const auto &[name, duration] : phases_) {
+    Milliseconds elapsed = duration;
+    total += elapsed;
+    out << std::format("{:<28} {:>12.3f} ms\n", name, elapsed.count());
+  }
+  out << std::format("{:<28} {:>12.3f} ms\n", "total", total.count());
+}
@@ -0,0 +1,103 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+
+bool IRGenerator::isBuiltinCall(const AST::FuncCallNode &node) const {
+  if (node.name().type == Token::Type::Type) {
+    return true;
+  }
+  return SemanticAnalyzer::isBuiltinName(node.name().value) &&
+         !module_->getFunction(node.name().value);
+}
+
+// Builtins lower straight to vector instructions and llvm.vector.reduce.*
+// intrinsics, so they never show up as calls in the generated code.
+llvm::Value *IRGenerator::generateBuiltinCall(const AST::FuncCallNode &node) {
+  const std::string &name = node.name().value;
+
+  std::vector<llvm::Value *> args;
+  if (auto *argList = dynamic_cast<const AST::ArgListNode *>(node.args())) {
+    for (const auto &arg : argList->args()) {
+      args.push_back(generateExpr(arg.get()));
+    }
+  }
+
+  if (node.name().type == Token::Type::Type) {
+    auto *vectorType = llvm::cast<llvm::FixedVectorType>(
+        getLLVMType(SemanticAnalyzer::typeFromName(name)));
+    unsigned lanes = vectorType->getNumElements();
+    if (args.size() == 1) {
+      return builder_.CreateVectorSplat(lanes, args[0], "splat");
+    }
+
+    llvm::Value *vector = llvm::PoisonValue::get(vectorType);
+    for (unsigned i = 0; i < lanes; ++i) {
+      vector = builder_.CreateInsertElement(vector, args[i], uint64_t(i));
+    }
+    return vector;
+  }
+
+  // Lane counts are powers of two, and an index out of range wraps around
+  // instead of producing poison. Literal indices fold to a constant.
+  auto laneIndex = [&](llvm::Value *index) {
+    unsigned lanes =
+        llvm::cast<llvm::FixedVectorType>(args[0]->getType())->getNumElements();
+    return builder_.CreateAnd(index, lanes - 1, "lane.index");
+  };
+
+  if (name == "extract") {
+    return builder_.CreateExtractElement(args[0], laneIndex(args[1]), "lane");
+  }
+
+  if (name == "insert") {
+    return builder_.CreateInsertElement(args[0], args[2], laneIndex(args[1]));
+  }
+
+  if (name == "shuffle") {
+    // The analyzer only accepts literal lane indices for shuffles.
+    std::vector<int> mask;
+    const auto *argList = static_cast<const AST::ArgListNode *>(node.args());
+    for (size_t i = 2; i < argList->args().size(); ++i) {
+      const auto *index =
+          static_cast<const AST::NumberNode *>(argList->args()[i].get());
+      mask.push_back(std::stoi(index->value().value));
+    }
+    return builder_.CreateShuffleVector(args[0], args[1], mask, "shuffle");
+  }
+
+  llvm::Value *vector = args[0];
+  bool isFloat = vector->getType()->isFPOrFPVectorTy();
+  llvm::Type *laneType = vector->getType()->getScalarType();
+
+  // Without fast-math flags the FP reductions keep the strict left-to-right
+  // order, matching a scalar loop over the lanes.
+  if (name == "reduce_add") {
+    if (isFloat) {
+      return builder_.CreateFAddReduce(
+          llvm::ConstantFP::getNegativeZero(laneType), vector);
+    }
+    return builder_.CreateAddReduce(vector);
+  }
+  if (name == "reduce_mul") {
+    if (isFloat) {
+      return builder_.CreateFMulReduce(llvm::ConstantFP::get(laneType, 1.0),
+                                       vector);
+    }
+    return builder_.CreateMulReduce(vector);
+  }
+  if (name == "reduce_min") {
+    if (isFloat) {
+      return builder_.CreateFPMinReduce(vector);
+    }
+    return builder_.CreateIntMinReduce(vector, true);
+  }
+  if (name == "reduce_max") {
+    if (isFloat) {
+      return builder_.CreateFPMaxReduce(vector);
+    }
+    return builder_.CreateIntMaxReduce(vector, true);
+  }
+
+  throw Error(std::format("unknown builtin '{}'", name));
+}
@@ -0,0 +1,241 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Intrinsics.h>
+
+// The awaiting coroutine comes first so the runtime and the awaiter can find
+// it without knowing the result type.
+llvm::StructType *IRGenerator::promiseType(llvm::Type *resultType) {
+  std::vector<llvm::Type *> fields = {builder_.getPtrTy()};
+  if (!resultType->isVoidTy()) {
+    fields.push_back(resultType);
+  }
+  return llvm::StructType::get(context_, fields);
+}
+
+// The ramp allocates the frame and suspends before running any of the body,
+// so a task only makes progress once the executor resumes it. CoroSplit later
+// turns the function into the ramp plus resume and destroy clones.
+void IRGenerator::beginCoroutine(llvm::Function *func,
+                                 llvm::Type *resultType) {
+  func->addFnAttr(llvm::Attribute::PresplitCoroutine);
+
+  llvm::PointerType *ptrType = builder_.getPtrTy();
+  llvm::StructType *promiseTy = promiseType(resultType);
+  llvm::Align align = module_->getDataLayout().getABITypeAlign(promiseTy);
+
+  llvm::AllocaInst *promise =
+      builder_.CreateAlloca(promiseTy, nullptr, "promise");
+  promise->setAlignment(align);
+
+  llvm::Value *null = llvm::ConstantPointerNull::get(ptrType);
+  llvm::Value *id = builder_.CreateIntrinsic(
+      llvm::Intrinsic::coro_id, {},
+      {builder_.getInt32(align.value()), promise, null, null}, nullptr, "id");
+  llvm::Value *needAlloc =
+      builder_.CreateIntrinsic(llvm::Intrinsic::coro_alloc, {}, {id});
+
+  llvm::BasicBlock *entryBB = builder_.GetInsertBlock();
+  llvm::BasicBlock *allocBB =
+      llvm::BasicBlock::Create(context_, "coro.alloc", func);
+  llvm::BasicBlock *beginBB =
+      llvm::BasicBlock::Create(context_, "coro.begin", func);
+  builder_.CreateCondBr(needAlloc, allocBB, beginBB);
+  sealBlock(allocBB);
+
+  // When the frame does not outlive the caller, CoroElide places it in the
+  // caller's frame and coro.alloc folds to false.
+  builder_.SetInsertPoint(allocBB);
+  llvm::Value *size = builder_.CreateIntrinsic(llvm::Intrinsic::coro_size,
+                                               {builder_.getInt64Ty()}, {});
+  llvm::FunctionType *allocType =
+      llvm::FunctionType::get(ptrType, {builder_.getInt64Ty()}, false);
+  llvm::Function *alloc = getRuntimeFunction("ode_coro_alloc", allocType);
+  alloc->addRetAttr(llvm::Attribute::NoAlias);
+  llvm::Value *memory = builder_.CreateCall(alloc, {size}, "memory");
+  builder_.CreateBr(beginBB);
+  sealBlock(beginBB);
+
+  builder_.SetInsertPoint(beginBB);
+  llvm::PHINode *frame = builder_.CreatePHI(ptrType, 2, "frame");
+  frame->addIncoming(null, entryBB);
+  frame->addIncoming(memory, allocBB);
+  llvm::Value *handle = builder_.CreateIntrinsic(
+      llvm::Intrinsic::coro_begin, {}, {id, frame}, nullptr, "handle");
+  builder_.CreateStore(null, builder_.CreateStructGEP(promiseTy, promise, 0));
+
+  coroutine_ = CoroutineState{
+      id,
+      handle,
+      promise,
+      promiseTy,
+      llvm::BasicBlock::Create(context_, "coro.final", func),
+      llvm::BasicBlock::Create(context_, "coro.cleanup", func),
+      llvm::BasicBlock::Create(context_, "coro.suspend", func)};
+
+  suspendCoroutine();
+}
+
+// Suspends the current coroutine. Code emitted afterwards runs once the
+// executor resumes it.
+void IRGenerator::suspendCoroutine() {
+  llvm::Value *state = builder_.CreateIntrinsic(
+      llvm::Intrinsic::coro_suspend, {},
+      {llvm::ConstantTokenNone::get(context_), builder_.getFalse()});
+
+  llvm::BasicBlock *resumeBB =
+      llvm::BasicBlock::Create(context_, "coro.resume", currentFunc_);
+  llvm::SwitchInst *dispatch =
+      builder_.CreateSwitch(state, coroutine_->suspendBB, 2);
+  dispatch->addCase(builder_.getInt8(0), resumeBB);
+  dispatch->addCase(builder_.getInt8(1), coroutine_->cleanupBB);
+
+  sealBlock(resumeBB);
+  builder_.SetInsertPoint(resumeBB);
+}
+
+// Every return branches to the final suspend point. A task nobody awaits
+// frees itself there; otherwise it wakes its awaiter and stays suspended so
+// the awaiter can read the result before destroying the frame.
+void IRGenerator::endCoroutine() {
+  CoroutineState &coro = *coroutine_;
+  llvm::PointerType *ptrType = builder_.getPtrTy();
+
+  if (!builder_.GetInsertBlock()->getTerminator()) {
+    if (coro.promiseType->getNumElements() > 1) {
+      llvm::Type *resultType = coro.promiseType->getElementType(1);
+      builder_.CreateStore(
+          llvm::Constant::getNullValue(resultType),
+          builder_.CreateStructGEP(coro.promiseType, coro.promise, 1));
+    }
+    builder_.CreateBr(coro.finalBB);
+  }
+
+  sealBlock(coro.finalBB);
+  builder_.SetInsertPoint(coro.finalBB);
+  llvm::Value *awaiter = builder_.CreateLoad(
+      ptrType, builder_.CreateStructGEP(coro.promiseType, coro.promise, 0),
+      "awaiter");
+  llvm::BasicBlock *notifyBB =
+      llvm::BasicBlock::Create(context_, "coro.notify", currentFunc_);
+  builder_.CreateCondBr(builder_.CreateIsNull(awaiter), coro.cleanupBB,
+                        notifyBB);
+  sealBlock(notifyBB);
+
+  builder_.SetInsertPoint(notifyBB);
+  llvm::FunctionType *handleType =
+      llvm::FunctionType::get(builder_.getVoidTy(), {ptrType}, false);
+  builder_.CreateCall(
+      getRuntimeFunction("ode_coro_schedule", handleType, false), {awaiter});
+  llvm::Value *state = builder_.CreateIntrinsic(
+      llvm::Intrinsic::coro_suspend, {},
+      {llvm::ConstantTokenNone::get(context_), builder_.getTrue()});
+
+  // Resuming a coroutine at its final suspend point is undefined.
+  llvm::BasicBlock *trapBB =
+      llvm::BasicBlock::Create(context_, "coro.trap", currentFunc_);
+  llvm::SwitchInst *dispatch = builder_.CreateSwitch(state, coro.suspendBB, 2);
+  dispatch->addCase(builder_.getInt8(0), trapBB);
+  dispatch->addCase(builder_.getInt8(1), coro.cleanupBB);
+  sealBlock(trapBB);
+  builder_.SetInsertPoint(trapBB);
+  builder_.CreateUnreachable();
+
+  sealBlock(coro.cleanupBB);
+  builder_.SetInsertPoint(coro.cleanupBB);
+  llvm::Value *memory = builder_.CreateIntrinsic(
+      llvm::Intrinsic::coro_free, {}, {coro.id, coro.handle}, nullptr,
+      "memory");
+  llvm::BasicBlock *freeBB =
+      llvm::BasicBlock::Create(context_, "coro.free", currentFunc_);
+  builder_.CreateCondBr(builder_.CreateIsNotNull(memory), freeBB,
+                        coro.suspendBB);
+  sealBlock(freeBB);
+
+  builder_.SetInsertPoint(freeBB);
+  builder_.CreateCall(getRuntimeFunction("ode_coro_free", handleType, false),
+                      {memory});
+  builder_.CreateBr(coro.suspendBB);
+
+  sealBlock(coro.suspendBB);
+  builder_.SetInsertPoint(coro.suspendBB);
+  builder_.CreateIntrinsic(llvm::Intrinsic::coro_end, {},
+                           {coro.handle, builder_.getFalse(),
+                            llvm::ConstantTokenNone::get(context_)});
+  builder_.CreateRet(coro.handle);
+}
+
+// Inside an async function the awaiter registers itself with the task and
+// suspends; synchronous code instead runs the executor until the task is
+// done. Either way the task sits at its final suspend point afterwards, so
+// its result can be read before the frame is destroyed.
+llvm::Value *IRGenerator::generateAwait(const AST::AwaitNode &node) {
+  const auto *call = static_cast<const AST::FuncCallNode *>(node.expr());
+  llvm::PointerType *ptrType = builder_.getPtrTy();
+
+  if (call->name().value == "sleep" && !module_->getFunction("sleep")) {
+    const auto *args = static_cast<const AST::ArgListNode *>(call->args());
+    llvm::Value *millis = generateExpr(args->args()[0].get());
+    llvm::Value *waiter = coroutine_ ? coroutine_->handle
+                                     : llvm::ConstantPointerNull::get(ptrType);
+
+    llvm::FunctionType *sleepType = llvm::FunctionType::get(
+        builder_.getVoidTy(), {ptrType, builder_.getInt32Ty()}, false);
+    llvm::Value *sleep = builder_.CreateCall(
+        getRuntimeFunction("ode_sleep", sleepType, false), {waiter, millis});
+    if (coroutine_) {
+      suspendCoroutine();
+    }
+    return sleep;
+  }
+
+  llvm::StructType *promiseTy =
+      promiseType(asyncResultTypes_.at(call->name().value));
+  llvm::Align align = module_->getDataLayout().getABITypeAlign(promiseTy);
+
+  llvm::Value *task = generateExpr(call);
+  llvm::Value *promise = builder_.CreateIntrinsic(
+      llvm::Intrinsic::coro_promise, {},
+      {task, builder_.getInt32(align.value()), builder_.getFalse()}, nullptr,
+      "promise");
+  llvm::Value *awaiter = builder_.CreateStructGEP(promiseTy, promise, 0);
+
+  llvm::FunctionType *handleType =
+      llvm::FunctionType::get(builder_.getVoidTy(), {ptrType}, false);
+  if (coroutine_) {
+    builder_.CreateStore(coroutine_->handle, awaiter);
+    builder_.CreateCall(
+        getRuntimeFunction("ode_coro_schedule", handleType, false), {task});
+    suspendCoroutine();
+  } else {
+    llvm::FunctionType *blockOnType = llvm::FunctionType::get(
+        builder_.getVoidTy(), {ptrType, ptrType}, false);
+    builder_.CreateCall(getRuntimeFunction("ode_block_on", blockOnType, false),
+                        {task, awaiter});
+  }
+
+  llvm::Value *result = nullptr;
+  if (promiseTy->getNumElements() > 1) {
+    llvm::Value *slot = builder_.CreateStructGEP(promiseTy, promise, 1);
+    result =
+        builder_.CreateLoad(promiseTy->getElementType(1), slot, "awaited");
+  }
+  llvm::Value *destroy =
+      builder_.CreateIntrinsic(llvm::Intrinsic::coro_destroy, {}, {task});
+  return result ? result : destroy;
+}
+
+// A spawned task has no awaiter, so it frees its own frame when it finishes.
+void IRGenerator::visit(const AST::SpawnStmtNode &node) {
+  llvm::Value *task = generateExpr(node.call());
+
+  llvm::FunctionType *spawnType = llvm::FunctionType::get(
+      builder_.getVoidTy(), {builder_.getPtrTy()}, false);
+  builder_.CreateCall(getRuntimeFunction("ode_spawn", spawnType, false),
+                      {task});
+}
+
+void IRGenerator::visit(const AST::AwaitNode &node) {
+  throw Error("AwaitNode should not be visited directly - use generateExpr()");
+}
@@ -0,0 +1,202 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+
+void IRGenerator::enableDebugInfo(const std::filesystem::path &source,
+                                  bool lineTablesOnly) {
+  createDebugUnit(source, lineTablesOnly
+                              ? llvm::DICompileUnit::LineTablesOnly
+                              : llvm::DICompileUnit::FullDebug);
+}
+
+// The same locations as line tables, but the backend emits no DWARF for a
+// NoDebug unit.
+void IRGenerator::trackLocations(const std::filesystem::path &source) {
+  if (!debugBuilder_) {
+    createDebugUnit(source, llvm::DICompileUnit::NoDebug);
+  }
+}
+
+void IRGenerator::createDebugUnit(
+    const std::filesystem::path &source,
+    llvm::DICompileUnit::DebugEmissionKind emissionKind) {
+  std::filesystem::path path = std::filesystem::absolute(source);
+
+  debugBuilder_ = std::make_unique<llvm::DIBuilder>(*module_);
+  lineTablesOnly_ = emissionKind != llvm::DICompileUnit::FullDebug;
+
+  // DWARF has no language code for Ode. C is the closest match, and it keeps
+  // debuggers from applying the name mangling rules of other languages.
+  llvm::DIFile *file = debugBuilder_->createFile(
+      path.filename().string(), path.parent_path().string());
+  debugUnit_ = debugBuilder_->createCompileUnit(
+      llvm::dwarf::DW_LANG_C, file, "ode", optLevel_ > 0, "", 0, "",
+      emissionKind);
+
+  module_->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
+                         llvm::DEBUG_METADATA_VERSION);
+  module_->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 5);
+}
+
+// Makes func the scope of the debug locations that follow. Every instruction
+// in a described function needs a location, so the function's own line is
+// used until its first statement sets another.
+void IRGenerator::beginDebugFunction(llvm::Function *func,
+                                     SourceLocation location,
+                                     Type returnType,
+                                     const std::vector<Type> &params) {
+  if (!debugBuilder_) {
+    return;
+  }
+
+  std::vector<llvm::Metadata *> types;
+  if (!lineTablesOnly_) {
+    types.push_back(debugType(returnType));
+    for (Type param : params) {
+      types.push_back(debugType(param));
+    }
+  }
+  llvm::DISubroutineType *funcType = debugBuilder_->createSubroutineType(
+      debugBuilder_->getOrCreateTypeArray(types));
+
+  llvm::DISubprogram::DISPFlags flags = llvm::DISubprogram::SPFlagDefinition;
+  if (optLevel_ > 0) {
+    flags |= llvm::DISubprogram::SPFlagOptimized;
+  }
+  llvm::DISubprogram *subprogram = debugBuilder_->createFunction(
+      debugUnit_, func->getName(), func->getName(), debugUnit_->getFile(),
+      location.line, funcType, location.line, llvm::DINode::FlagPrototyped,
+      flags);
+  func->setSubprogram(subprogram);
+
+  debugScope_ = subprogram;
+  builder_.SetCurrentDebugLocation(llvm::DILocation::get(
+      context_, location.line, location.column, subprogram));
+}
+
+// Blocks only get their own scope with full debug info, where they limit
+// the lifetime of the variables declared in them. Returns the enclosing
+// scope, which the caller restores once the block is done.
+llvm::DIScope *IRGenerator::enterDebugBlock(const AST::Node &node) {
+  llvm::DIScope *enclosing = debugScope_;
+  SourceLocation location = node.location();
+  if (debugScope_ && !lineTablesOnly_ && location.line != 0) {
+    debugScope_ = debugBuilder_->createLexicalBlock(
+        debugScope_, debugUnit_->getFile(), location.line, location.column);
+  }
+  return enclosing;
+}
+
+// Nodes synthesized by the AST passes have no location and keep the one of
+// the code around them.
+void IRGenerator::setDebugLocation(const AST::Node &node) {
+  SourceLocation location = node.location();
+  if (!debugScope_ || location.line == 0) {
+    return;
+  }
+  builder_.SetCurrentDebugLocation(llvm::DILocation::get(
+      context_, location.line, location.column, debugScope_));
+}
+
+llvm::DIType *IRGenerator::debugType(Type type) {
+  if (type == Type::Void) {
+    return nullptr;
+  }
+  if (auto it = debugTypes_.find(type); it != debugTypes_.end()) {
+    return it->second;
+  }
+
+  const llvm::DataLayout &layout = module_->getDataLayout();
+  llvm::Type *llvmType = getLLVMType(type);
+  uint64_t size = layout.getTypeAllocSizeInBits(llvmType).getFixedValue();
+  uint32_t align = layout.getABITypeAlign(llvmType).value() * 8;
+
+  llvm::DIType *result = nullptr;
+  if (isStructType(type)) {
+    const StructInfo &info = analysis_->structInfo(type);
+    const llvm::StructLayout *structLayout =
+        layout.getStructLayout(llvm::cast<llvm::StructType>(llvmType));
+    llvm::DIFile *file = debugUnit_->getFile();
+
+    // Members are listed in memory order, which is what debuggers expect.
+    std::vector<llvm::Metadata *> members(info.fields.size());
+    for (size_t i = 0; i < info.fields.size(); ++i) {
+      unsigned slot = info.slots[i];
+      llvm::Type *fieldType = getLLVMType(info.fields[i].type);
+      members[slot] = debugBuilder_->createMemberType(
+          debugUnit_, info.fields[i].name, file, 0,
+          layout.getTypeAllocSizeInBits(fieldType).getFixedValue(),
+          layout.getABITypeAlign(fieldType).value() * 8,
+          structLayout->getElementOffsetInBits(slot), llvm::DINode::FlagZero,
+          debugType(info.fields[i].type));
+    }
+    result = debugBuilder_->createStructType(
+        debugUnit_, info.name, file, 0, size, align, llvm::DINode::FlagZero,
+        nullptr, debugBuilder_->getOrCreateArray(members));
+  } else if (isVectorType(type)) {
+    llvm::Metadata *lanes =
+        debugBuilder_->getOrCreateSubrange(0, laneCount(type));
+    result = debugBuilder_->createVectorType(
+        size, align, debugType(elementType(type)),
+        debugBuilder_->getOrCreateArray({lanes}));
+  } else if (type == Type::I32) {
+    result = debugBuilder_->createBasicType("i32", 32,
+                                            llvm::dwarf::DW_ATE_signed);
+  } else if (type == Type::F32) {
+    result = debugBuilder_->createBasicType("f32", 32,
+                                            llvm::dwarf::DW_ATE_float);
+  } else {
+    result = debugBuilder_->createBasicType("bool", 8,
+                                            llvm::dwarf::DW_ATE_boolean);
+  }
+
+  debugTypes_[type] = result;
+  return result;
+}
+
+// Variables live in SSA registers, so the debugger learns about each new
+// value through a #dbg_value record rather than from a stack slot.
+void IRGenerator::describeVariable(const std::string &name,
+                                   SourceLocation location, Type type,
+                                   unsigned argNo) {
+  if (!debugScope_ || lineTablesOnly_) {
+    return;
+  }
+
+  llvm::DIFile *file = debugUnit_->getFile();
+  llvm::DILocalVariable *variable =
+      argNo > 0 ? debugBuilder_->createParameterVariable(
+                      debugScope_, name, argNo, file, location.line,
+                      debugType(type), true)
+                : debugBuilder_->createAutoVariable(
+                      debugScope_, name, file, location.line, debugType(type),
+                      true);
+
+  unsigned var = lookupVariable(name);
+  ssa_.variables[var].debugVariable = variable;
+  emitDebugValue(var, loadVariable(name), builder_.GetInsertPoint());
+}
+
+void IRGenerator::emitDebugValue(unsigned var, llvm::Value *val,
+                                 llvm::BasicBlock::iterator position) {
+  llvm::DILocalVariable *variable = ssa_.variables[var].debugVariable;
+  if (!variable) {
+    return;
+  }
+
+  // Records for PHIs are placed away from the statement being generated, so
+  // they get a line-0 location in the variable's own scope.
+  const llvm::DILocation *location = builder_.getCurrentDebugLocation();
+  if (!location || position != builder_.GetInsertPoint()) {
+    location = llvm::DILocation::get(context_, 0, 0, variable->getScope());
+  }
+  debugBuilder_->insertDbgValueIntrinsic(
+      val, variable, debugBuilder_->createExpression(), location, position);
+}
+
+void IRGenerator::finalizeDebugInfo() {
+  if (debugBuilder_) {
+    debugBuilder_->finalize();
+  }
+}
@@ -1,58 +1,31 @@
 #include "IRGenerator.hpp"
 
+#include <llvm/IR/Intrinsics.h>
+
+// Each expression is attributed to its own token, and the enclosing
+// expression's location is restored for the code that consumes its value.
 llvm::Value *IRGenerator::generateExpr(const AST::Node *node) {
+  llvm::DebugLoc enclosing = builder_.getCurrentDebugLocation();
+  setDebugLocation(*node);
+  llvm::Value *value = lowerExpr(node);
+  builder_.SetCurrentDebugLocation(enclosing);
+  return value;
+}
+
+llvm::Value *IRGenerator::lowerExpr(const AST::Node *node) {
   if (auto *binOp = dynamic_cast<const AST::BinaryOpNode *>(node)) {
+    Token::Type op = binOp->op().type;
+    if (op == Token::Type::And || op == Token::Type::Or) {
+      return generateLogicalOp(*binOp);
+    }
+    if (arithmetic_.contract == Options::Arithmetic::Contract::On) {
+      if (llvm::Value *fused = generateMulAdd(*binOp)) {
+        return fused;
+      }
+    }
     llvm::Value *left = generateExpr(binOp->left());
     llvm::Value *right = generateExpr(binOp->right());
-
-    switch (binOp->op().type) {
-    case Token::Type::Or:
-      return builder_.CreateOr(left, right);
-    case Token::Type::And:
-      return builder_.CreateAnd(left, right);
-    case Token::Type::Equal:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFCmpOEQ(left, right);
-      return builder_.CreateICmpEQ(left, right);
-    case Token::Type::NotEqual:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFCmpONE(left, right);
-      return builder_.CreateICmpNE(left, right);
-    case Token::Type::Greater:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFCmpOGT(left, right);
-      return builder_.CreateICmpSGT(left, right);
-    case Token::Type::GreaterEqual:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFCmpOGE(left, right);
-      return builder_.CreateICmpSGE(left, right);
-    case Token::Type::Less:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFCmpOLT(left, right);
-      return builder_.CreateICmpSLT(left, right);
-    case Token::Type::LessEqual:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFCmpOLE(left, right);
-      return builder_.CreateICmpSLE(left, right);
-    case Token::Type::Plus:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFAdd(left, right);
-      return builder_.CreateAdd(left, right);
-    case Token::Type::Minus:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFSub(left, right);
-      return builder_.CreateSub(left, right);
-    case Token::Type::Multiply:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFMul(left, right);
-      return builder_.CreateMul(left, right);
-    case Token::Type::Divide:
-      if (left->getType()->isFloatingPointTy())
-        return builder_.CreateFDiv(left, right);
-      return builder_.CreateSDiv(left, right);
-    default:
-      throw Error("unknown binary operator");
-    }
+    return generateBinaryOp(binOp->op().type, left, right);
   }
 
   if (auto *unaryOp = dynamic_cast<const AST::UnaryOpNode *>(node)) {
@@ -60,10 +33,9 @@ llvm::Value *IRGenerator::generateExpr(const AST::Node *node) {
 
     switch (unaryOp->op().type) {
     case Token::Type::Minus: {
-      if (operand->getType()->isFloatingPointTy())
+      if (operand->getType()->isFPOrFPVectorTy())
         return builder_.CreateFNeg(operand, "neg");
-      llvm::Value *zero = llvm::ConstantInt::get(operand->getType(), 0);
-      return builder_.CreateSub(zero, operand, "neg");
+      return builder_.CreateNeg(operand, "neg", !arithmetic_.wrap);
     }
     case Token::Type::Not: {
       return builder_.CreateNot(operand, "not");
@@ -93,6 +65,12 @@ llvm::Value *IRGenerator::generateExpr(const AST::Node *node) {
   }
 
   if (auto *call = dynamic_cast<const AST::FuncCallNode *>(node)) {
+    if (std::optional<Type> type = analysis_->structType(call->name().value)) {
+      return generateStructConstruction(*call, *type);
+    }
+    if (isBuiltinCall(*call)) {
+      return generateBuiltinCall(*call);
+    }
     llvm::Function *func = module_->getFunction(call->name().value);
     if (!func)
       throw Error("undefined function: " + call->name().value);
@@ -109,5 +87,178 @@ llvm::Value *IRGenerator::generateExpr(const AST::Node *node) {
         func, args, func->getReturnType()->isVoidTy() ? "" : "calltmp");
   }
 
+  if (auto *await = dynamic_cast<const AST::AwaitNode *>(node)) {
+    return generateAwait(*await);
+  }
+
+  if (auto *access = dynamic_cast<const AST::FieldAccessNode *>(node)) {
+    llvm::Value *object = generateExpr(access->object());
+    const std::string &field = access->field().value;
+    return builder_.CreateExtractValue(
+        object, fieldSlot(object->getType(), field), field);
+  }
+
   throw Error("unknown expression node type");
 }
+
+// '&&' and '||' short-circuit: the right operand is only evaluated, with
+// whatever calls it makes, when the left one does not decide the result.
+llvm::Value *IRGenerator::generateLogicalOp(const AST::BinaryOpNode &node) {
+  bool isAnd = node.op().type == Token::Type::And;
+  llvm::Value *left = generateExpr(node.left());
+  llvm::BasicBlock *leftBB = builder_.GetInsertBlock();
+
+  llvm::Function *func = leftBB->getParent();
+  llvm::BasicBlock *rightBB =
+      llvm::BasicBlock::Create(context_, isAnd ? "and.rhs" : "or.rhs", func);
+  llvm::BasicBlock *endBB =
+      llvm::BasicBlock::Create(context_, isAnd ? "and.end" : "or.end", func);
+
+  if (isAnd) {
+    builder_.CreateCondBr(left, rightBB, endBB);
+  } else {
+    builder_.CreateCondBr(left, endBB, rightBB);
+  }
+  sealBlock(rightBB);
+
+  builder_.SetInsertPoint(rightBB);
+  llvm::Value *right = generateExpr(node.right());
+  llvm::BasicBlock *rightEndBB = builder_.GetInsertBlock();
+  builder_.CreateBr(endBB);
+  sealBlock(endBB);
+
+  builder_.SetInsertPoint(endBB);
+  llvm::PHINode *result = builder_.CreatePHI(builder_.getInt1Ty(), 2,
+                                             isAnd ? "and" : "or");
+  result->addIncoming(builder_.getInt1(!isAnd), leftBB);
+  result->addIncoming(right, rightEndBB);
+  return result;
+}
+
+// Floating-point operations take their fast-math flags from the builder;
+// see useArithmetic.
+llvm::Value *IRGenerator::generateBinaryOp(Token::Type op, llvm::Value *left,
+                                           llvm::Value *right) {
+  bool isFloat = left->getType()->isFPOrFPVectorTy();
+  bool nsw = !arithmetic_.wrap;
+  switch (op) {
+  case Token::Type::Equal:
+    if (isFloat)
+      return builder_.CreateFCmpOEQ(left, right);
+    return builder_.CreateICmpEQ(left, right);
+  case Token::Type::NotEqual:
+    if (isFloat)
+      return builder_.CreateFCmpONE(left, right);
+    return builder_.CreateICmpNE(left, right);
+  case Token::Type::Greater:
+    if (isFloat)
+      return builder_.CreateFCmpOGT(left, right);
+    return builder_.CreateICmpSGT(left, right);
+  case Token::Type::GreaterEqual:
+    if (isFloat)
+      return builder_.CreateFCmpOGE(left, right);
+    return builder_.CreateICmpSGE(left, right);
+  case Token::Type::Less:
+    if (isFloat)
+      return builder_.CreateFCmpOLT(left, right);
+    return builder_.CreateICmpSLT(left, right);
+  case Token::Type::LessEqual:
+    if (isFloat)
+      return builder_.CreateFCmpOLE(left, right);
+    return builder_.CreateICmpSLE(left, right);
+  case Token::Type::Plus:
+    if (isFloat)
+      return builder_.CreateFAdd(left, right);
+    return builder_.CreateAdd(left, right, "", false, nsw);
+  case Token::Type::Minus:
+    if (isFloat)
+      return builder_.CreateFSub(left, right);
+    return builder_.CreateSub(left, right, "", false, nsw);
+  case Token::Type::Multiply:
+    if (isFloat)
+      return builder_.CreateFMul(left, right);
+    return builder_.CreateMul(left, right, "", false, nsw);
+  case Token::Type::Divide:
+    if (isFloat)
+      return builder_.CreateFDiv(left, right);
+    return builder_.CreateSDiv(left, right);
+  default:
+    throw Error("unknown binary operator");
+  }
+}
+
+// -ffp-contract=on: a*b+c, a*b-c and c-a*b within one expression become
+// llvm.fmuladd, which is fused wherever the target has FMA. Operands are
+// still evaluated left to right.
+llvm::Value *IRGenerator::generateMulAdd(const AST::BinaryOpNode &node) {
+  auto product = [](const AST::Node *operand) {
+    auto *binOp = dynamic_cast<const AST::BinaryOpNode *>(operand);
+    return binOp && binOp->op().type == Token::Type::Multiply ? binOp
+                                                               : nullptr;
+  };
+  Token::Type op = node.op().type;
+  const AST::BinaryOpNode *left = product(node.left());
+  const AST::BinaryOpNode *right = left ? nullptr : product(node.right());
+  if ((op != Token::Type::Plus && op != Token::Type::Minus) ||
+      (!left && !right)) {
+    return nullptr;
+  }
+
+  llvm::Value *a, *b, *c;
+  if (left) {
+    a = generateExpr(left->left());
+    b = generateExpr(left->right());
+    c = generateExpr(node.right());
+  } else {
+    c = generateExpr(node.left());
+    a = generateExpr(right->left());
+    b = generateExpr(right->right());
+  }
+
+  if (!a->getType()->isFPOrFPVectorTy()) {
+    llvm::Value *mul = generateBinaryOp(Token::Type::Multiply, a, b);
+    return left ? generateBinaryOp(op, mul, c) : generateBinaryOp(op, c, mul);
+  }
+  if (op == Token::Type::Minus) {
+    if (left) {
+      c = builder_.CreateFNeg(c);
+    } else {
+      a = builder_.CreateFNeg(a);
+    }
+  }
+  return builder_.CreateIntrinsic(llvm::Intrinsic::fmuladd, {a->getType()},
+                                  {a, b, c});
+}
+
+// A function's attributes apply on top of the arithmetic of the code
+// around it; the analyzer has checked their arguments.
+Options::Arithmetic
+IRGenerator::functionArithmetic(const AST::FuncDeclNode &node) const {
+  Options::Arithmetic arithmetic = arithmetic_;
+  for (const auto &attribute : node.attributes()) {
+    const std::string &attr = attribute.name.value;
+    std::string argument = attribute.argument ? attribute.argument->value : "";
+    if (attr == "fast_math" || attr == "no_fast_math") {
+      arithmetic.fastMath = attr == "fast_math";
+    } else if (attr == "overflow") {
+      arithmetic.wrap = argument == "wrap";
+    } else if (attr == "fp_contract") {
+      using Contract = Options::Arithmetic::Contract;
+      arithmetic.contract = argument == "off"  ? Contract::Off
+                            : argument == "on" ? Contract::On
+                                               : Contract::Fast;
+    }
+  }
+  return arithmetic;
+}
+
+void IRGenerator::useArithmetic(const Options::Arithmetic &arithmetic) {
+  arithmetic_ = arithmetic;
+  llvm::FastMathFlags flags;
+  if (arithmetic.fastMath) {
+    flags.setFast();
+  } else if (arithmetic.contract == Options::Arithmetic::Contract::Fast) {
+    flags.setAllowContract();
+  }
+  builder_.setFastMathFlags(flags);
+}
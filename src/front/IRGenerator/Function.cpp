@@ -5,58 +5,124 @@
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constants.h>
 
+#include <utility>
+
+void IRGenerator::declareExternal(const FunctionSignature &signature) {
+  std::vector<llvm::Type *> paramTypes;
+  for (Type paramType : signature.params) {
+    paramTypes.push_back(getLLVMType(paramType));
+  }
+
+  // An async function returns the handle of the task it creates.
+  llvm::Type *returnType = getLLVMType(signature.returnType);
+  if (signature.isAsync) {
+    asyncResultTypes_[signature.name] = returnType;
+    returnType = builder_.getPtrTy();
+  }
+
+  llvm::FunctionType *funcType =
+      llvm::FunctionType::get(returnType, paramTypes, false);
+  llvm::Function *func =
+      llvm::Function::Create(funcType, llvm::Function::ExternalLinkage,
+                             signature.name, module_.get());
+  func->setDoesNotThrow();
+}
+
 void IRGenerator::visit(const AST::FuncDeclNode &node) {
-  Type retType = SemanticAnalyzer::parseType(node.returnType());
+  Type retType = analysis_->resolveType(node.returnType());
   llvm::Type *llvmRetType = getLLVMType(retType);
 
-  std::vector<llvm::Type *> paramTypes;
-  std::vector<std::string> paramNames;
+  std::vector<Type> paramTypes;
+  std::vector<llvm::Type *> llvmParamTypes;
+  std::vector<const Token *> paramNames;
 
   const auto *params = dynamic_cast<const AST::ParamListNode *>(node.params());
   if (params) {
     for (const auto &param : params->params()) {
-      Type paramType = SemanticAnalyzer::parseType(param.type.get());
-      paramTypes.push_back(getLLVMType(paramType));
-      paramNames.push_back(param.name.value);
+      Type paramType = analysis_->resolveType(param.type.get());
+      paramTypes.push_back(paramType);
+      llvmParamTypes.push_back(getLLVMType(paramType));
+      paramNames.push_back(&param.name);
     }
   }
 
-  llvm::FunctionType *funcType =
-      llvm::FunctionType::get(llvmRetType, paramTypes, false);
+  if (node.isAsync()) {
+    asyncResultTypes_[node.name().value] = llvmRetType;
+  }
+
+  llvm::FunctionType *funcType = llvm::FunctionType::get(
+      node.isAsync() ? builder_.getPtrTy() : llvmRetType, llvmParamTypes,
+      false);
   llvm::Function *func =
       llvm::Function::Create(funcType, llvm::Function::ExternalLinkage,
                              node.name().value, module_.get());
 
   unsigned idx = 0;
   for (auto &arg : func->args()) {
-    arg.setName(paramNames[idx++]);
+    arg.setName(paramNames[idx++]->value);
+  }
+
+  // The facts the analyzer derives describe the body, which for an async
+  // function runs in the resume clone rather than in the ramp.
+  if (node.isAsync()) {
+    func->setDoesNotThrow();
+  } else if (const FunctionInfo *info =
+                 analysis_->functionInfo(node.name().value)) {
+    applyFunctionAttributes(func, *info);
   }
 
+  llvm::BasicBlock *enclosingBlock = builder_.GetInsertBlock();
+  llvm::Function *enclosingFunc = std::exchange(currentFunc_, func);
+  SSAState enclosingState = std::exchange(ssa_, {});
+  std::optional<CoroutineState> enclosingCoroutine =
+      std::exchange(coroutine_, std::nullopt);
+  llvm::DIScope *enclosingScope = debugScope_;
+  llvm::DebugLoc enclosingLocation = builder_.getCurrentDebugLocation();
+  Options::Arithmetic enclosingArithmetic = arithmetic_;
+  useArithmetic(functionArithmetic(node));
+
   llvm::BasicBlock *block = llvm::BasicBlock::Create(context_, "entry", func);
   builder_.SetInsertPoint(block);
+  sealBlock(block);
+  beginDebugFunction(func, node.location(), retType, paramTypes);
+  if (node.isAsync()) {
+    beginCoroutine(func, llvmRetType);
+  }
+  emitProfileEnter();
 
-  currentFunc_ = func;
-  allocaMap_.clear();
-
+  enterScope();
   for (auto &arg : func->args()) {
-    llvm::AllocaInst *alloca =
-        createEntryBlockAlloca(func, arg.getName().str(), arg.getType());
-    allocaMap_[arg.getName().str()] = alloca;
-    builder_.CreateStore(&arg, alloca);
+    const Token &name = *paramNames[arg.getArgNo()];
+    declareVariable(name.value, arg.getType(), &arg);
+    describeVariable(name.value, name.location, paramTypes[arg.getArgNo()],
+                     arg.getArgNo() + 1);
   }
 
   node.body()->accept(*this);
 
   llvm::BasicBlock *currentBlock = builder_.GetInsertBlock();
-  if (!currentBlock->getTerminator()) {
+  if (coroutine_) {
+    endCoroutine();
+  } else if (!currentBlock->getTerminator()) {
+    emitProfileExit();
     if (retType == Type::Void) {
       builder_.CreateRetVoid();
     } else {
-      builder_.CreateRet(llvm::ConstantInt::get(llvmRetType, 0));
+      builder_.CreateRet(llvm::Constant::getNullValue(llvmRetType));
     }
   }
 
-  currentFunc_ = nullptr;
+  useArithmetic(enclosingArithmetic);
+  coroutine_ = enclosingCoroutine;
+  debugScope_ = enclosingScope;
+  builder_.SetCurrentDebugLocation(enclosingLocation);
+  ssa_ = std::move(enclosingState);
+  currentFunc_ = enclosingFunc;
+  if (enclosingBlock) {
+    builder_.SetInsertPoint(enclosingBlock);
+  } else {
+    builder_.ClearInsertionPoint();
+  }
 }
 
 void IRGenerator::visit(const AST::FuncCallNode &node) {
@@ -83,6 +149,39 @@ void IRGenerator::visit(const AST::FuncCallNode &node) {
 
 void IRGenerator::visit(const AST::ReturnStmtNode &node) {
   llvm::Value *retVal = generateExpr(node.expr());
+
+  // An async function hands its result over through the promise and then
+  // runs its final suspend point.
+  if (coroutine_) {
+    if (coroutine_->promiseType->getNumElements() > 1) {
+      builder_.CreateStore(retVal,
+                           builder_.CreateStructGEP(coroutine_->promiseType,
+                                                    coroutine_->promise, 1));
+    }
+    builder_.CreateBr(coroutine_->finalBB);
+    return;
+  }
+
+  // A call in tail position whose prototype matches the caller's becomes a
+  // musttail call, so recursion runs in constant stack space even at -O0.
+  // The analyzer has already rejected 'return tail' calls that cannot.
+  // Builtins lower to intrinsics, which are never tail called.
+  auto *callNode = dynamic_cast<const AST::FuncCallNode *>(node.expr());
+  llvm::CallInst *tailCall = nullptr;
+  if (callNode && !isBuiltinCall(*callNode)) {
+    if (auto *call = llvm::dyn_cast<llvm::CallInst>(retVal)) {
+      bool sameCallingConvention = call->getCallingConv() ==
+                                   currentFunc_->getCallingConv();
+      bool samePrototype =
+          call->getFunctionType() == currentFunc_->getFunctionType();
+      call->setTailCallKind(sameCallingConvention && samePrototype
+                                ? llvm::CallInst::TCK_MustTail
+                                : llvm::CallInst::TCK_Tail);
+      tailCall = call;
+    }
+  }
+
+  emitProfileExit(tailCall);
   builder_.CreateRet(retVal);
 }
 
@@ -1,6 +1,10 @@
 #include "IRGenerator.hpp"
 
 llvm::Type *IRGenerator::getLLVMType(Type type) {
+  if (isStructType(type)) {
+    return getStructType(type);
+  }
+
   switch (type) {
   case Type::I32:
     return llvm::Type::getInt32Ty(context_);
@@ -10,46 +14,93 @@ llvm::Type *IRGenerator::getLLVMType(Type type) {
     return llvm::Type::getInt1Ty(context_);
   case Type::Void:
     return llvm::Type::getVoidTy(context_);
+  case Type::V4F32:
+  case Type::V8F32:
+  case Type::V4I32:
+  case Type::V8I32:
+    return llvm::FixedVectorType::get(getLLVMType(elementType(type)),
+                                      laneCount(type));
   default:
     throw Error("unknown type");
   }
 }
 
-llvm::AllocaInst *IRGenerator::createEntryBlockAlloca(llvm::Function *func,
-                                                      const std::string &name,
-                                                      llvm::Type *type) {
-  llvm::IRBuilder<> tmpBuilder(&func->getEntryBlock(),
-                               func->getEntryBlock().begin());
-  return tmpBuilder.CreateAlloca(type, nullptr, name);
+// Ode has no exceptions and no pointers, so every function is nounwind and
+// the analyzer can prove most of them free of memory effects. The profiling
+// hooks write the runtime's own state, so instrumented pure functions are
+// kept in order with each other and are no longer merged or hoisted, but
+// calls to them still leave the program's memory untouched.
+void IRGenerator::applyFunctionAttributes(llvm::Function *func,
+                                          const FunctionInfo &info) {
+  func->setDoesNotThrow();
+  if (info.pure && instrumentFunctions_) {
+    func->setOnlyAccessesInaccessibleMemory();
+  } else if (info.pure) {
+    func->setDoesNotAccessMemory();
+  }
+  if (!info.recursive) {
+    func->setDoesNotRecurse();
+  }
+  if (info.willReturn) {
+    func->setWillReturn();
+  }
 }
 
-void IRGenerator::storeVariable(const std::string &name, llvm::Value *val) {
-  auto it = allocaMap_.find(name);
-  if (it != allocaMap_.end()) {
-    builder_.CreateStore(val, it->second);
-  } else {
-    throw Error(std::format("variable '{}' not found", name));
+// Most runtime entry points only touch the runtime's own state, such as the
+// output buffer, which lets LLVM keep Ode values in registers across the call.
+// Entry points that read or order the program's memory pass ownStateOnly =
+// false.
+llvm::Function *IRGenerator::getRuntimeFunction(const std::string &name,
+                                                llvm::FunctionType *type,
+                                                bool ownStateOnly) {
+  llvm::Function *func = module_->getFunction(name);
+  if (!func) {
+    if (tinyRuntime_ && !name.starts_with("ode_print_") &&
+        name != "ode_flush") {
+      throw Error(std::format("{} is not in the tiny runtime", name),
+                  "parallel loops, async functions, spawn and sleep need "
+                  "'--runtime=default'");
+    }
+    func = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name,
+                                  module_.get());
+    func->setDoesNotThrow();
+    if (ownStateOnly) {
+      func->setOnlyAccessesInaccessibleMemory();
+    }
   }
+  return func;
 }
 
-llvm::Value *IRGenerator::loadVariable(const std::string &name) {
-  auto it = allocaMap_.find(name);
-  if (it != allocaMap_.end()) {
-    return builder_.CreateLoad(it->second->getAllocatedType(), it->second);
+// Async functions are not instrumented: their bodies suspend and resume on
+// the executor, so entry and exit do not bracket the time they run.
+void IRGenerator::emitProfileEnter() {
+  if (!instrumentFunctions_ || coroutine_) {
+    return;
   }
-  throw Error(std::format("variable '{}' not found", name));
-}
 
-llvm::Function *IRGenerator::getPrintfFunction() {
-  llvm::Function *printfFunc = module_->getFunction("printf");
-  if (!printfFunc) {
-    llvm::Type *i8PtrType = llvm::PointerType::get(context_, 0);
+  llvm::StringRef name = currentFunc_->getName();
+  llvm::Value *site = builder_.CreateGlobalString(name, name + ".prof");
+  llvm::FunctionType *enterType = llvm::FunctionType::get(
+      builder_.getVoidTy(), {builder_.getPtrTy()}, false);
+  builder_.CreateCall(getRuntimeFunction("ode_prof_enter", enterType),
+                      {site});
+}
 
-    llvm::FunctionType *printfType = llvm::FunctionType::get(
-        llvm::Type::getInt32Ty(context_), {i8PtrType}, true);
+// A tail call has to be immediately followed by the return, so the hook runs
+// before it and the callee's time is charged to the caller's caller.
+void IRGenerator::emitProfileExit(llvm::Instruction *before) {
+  if (!instrumentFunctions_ || coroutine_) {
+    return;
+  }
 
-    printfFunc = llvm::Function::Create(
-        printfType, llvm::Function::ExternalLinkage, "printf", module_.get());
+  llvm::FunctionType *exitType =
+      llvm::FunctionType::get(builder_.getVoidTy(), false);
+  llvm::Function *hook = getRuntimeFunction("ode_prof_exit", exitType);
+  if (before) {
+    llvm::CallInst *call =
+        llvm::CallInst::Create(hook, {}, "", before->getIterator());
+    call->setDebugLoc(before->getDebugLoc());
+  } else {
+    builder_.CreateCall(hook);
   }
-  return printfFunc;
 }
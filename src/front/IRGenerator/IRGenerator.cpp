@@ -13,29 +13,67 @@
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/TargetParser/Host.h>
 
-IRGenerator::IRGenerator(const std::string &moduleName)
-    : module_(std::make_unique<llvm::Module>(moduleName, context_)),
-      builder_(context_) {}
+IRGenerator::IRGenerator(const std::string &moduleName, unsigned optLevel)
+    : ownedContext_(std::make_unique<llvm::LLVMContext>()),
+      context_(*ownedContext_),
+      module_(std::make_unique<llvm::Module>(moduleName, context_)),
+      builder_(context_), optLevel_(optLevel) {}
 
-void IRGenerator::generate(const AST::Node &root) {
+std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>>
+IRGenerator::release() {
+  return {std::move(ownedContext_), std::move(module_)};
+}
+
+void IRGenerator::generate(const AST::Node &root,
+                           const SemanticAnalyzer &analysis) {
+  // Coroutine frames and promises are laid out with the target's data
+  // layout, so it has to be known before any code is generated.
+  targetMachine();
+
+  analysis_ = &analysis;
   root.accept(*this);
+  analysis_ = nullptr;
+  finalizeDebugInfo();
+
+  if (framePointers_) {
+    module_->setFramePointer(llvm::FramePointerKind::All);
+    for (llvm::Function &func : *module_) {
+      if (!func.isDeclaration()) {
+        func.addFnAttr("frame-pointer", "all");
+      }
+    }
+  }
 
   if (llvm::verifyModule(*module_, &llvm::errs())) {
     throw Error("module verification failed");
   }
 }
 
+void IRGenerator::internalizeFunctions() {
+  for (llvm::Function &func : *module_) {
+    if (!func.isDeclaration() && func.getName() != "main") {
+      func.setLinkage(llvm::Function::InternalLinkage);
+    }
+  }
+}
+
 void IRGenerator::visit(const AST::ProgramNode &node) {
   for (const auto &stmt : node.statements()) {
+    setDebugLocation(*stmt);
     stmt->accept(*this);
   }
 }
 
 void IRGenerator::visit(const AST::BlockNode &node) {
+  enterScope();
+  llvm::DIScope *enclosingScope = enterDebugBlock(node);
   for (const auto &stmt : node.statements()) {
     if (builder_.GetInsertBlock()->getTerminator()) {
       break;
     }
+    setDebugLocation(*stmt);
     stmt->accept(*this);
   }
+  debugScope_ = enclosingScope;
+  exitScope();
 }
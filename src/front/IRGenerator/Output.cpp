@@ -1,5 +1,9 @@
 #include "IRGenerator.hpp"
 
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/CodeGen/ParallelCG.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DerivedTypes.h>
@@ -14,31 +18,29 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/TargetParser/Host.h>
+
 #include <memory>
 
-void IRGenerator::emitToFile(const std::string &filename) {
-  try {
-    std::error_code ec;
-    llvm::raw_fd_ostream file(filename, ec, llvm::sys::fs::OF_None);
-    if (ec) {
-      throw Error("could not open file", ec.message());
-    }
-    module_->print(file, nullptr);
-    file.close();
-  } catch (Error err) {
-    module_->print(llvm::errs(), nullptr);
+// The output file "-" is standard output.
+static std::unique_ptr<llvm::raw_fd_ostream>
+openOutput(const std::filesystem::path &path) {
+  std::error_code ec;
+  auto file = std::make_unique<llvm::raw_fd_ostream>(path.string(), ec,
+                                                     llvm::sys::fs::OF_None);
+  if (ec) {
+    throw IRGenerator::Error("could not open file", ec.message());
   }
+  return file;
 }
 
-void IRGenerator::emitObjectFile(const std::string &filename) {
-  llvm::InitializeAllTargetInfos();
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmParsers();
-  llvm::InitializeAllAsmPrinters();
+void IRGenerator::emitToFile(const std::filesystem::path &filename) {
+  module_->print(*openOutput(filename), nullptr);
+}
 
+// Target machines are not thread-safe, so parallel code generation asks for
+// a fresh one per partition.
+std::unique_ptr<llvm::TargetMachine> IRGenerator::createTargetMachine() const {
   llvm::Triple targetTriple(llvm::sys::getDefaultTargetTriple());
-  module_->setTargetTriple(targetTriple);
 
   std::string error;
   auto target =
@@ -46,30 +48,115 @@ void IRGenerator::emitObjectFile(const std::string &filename) {
   if (!target)
     throw Error("could not find target", error);
 
+  llvm::CodeGenOptLevel codeGenLevel = llvm::CodeGenOptLevel::None;
+  switch (defaultCodeGenLevel_ ? 2 : optLevel_) {
+  case 0:
+    codeGenLevel = llvm::CodeGenOptLevel::None;
+    break;
+  case 1:
+    codeGenLevel = llvm::CodeGenOptLevel::Less;
+    break;
+  case 2:
+    codeGenLevel = llvm::CodeGenOptLevel::Default;
+    break;
+  default:
+    codeGenLevel = llvm::CodeGenOptLevel::Aggressive;
+    break;
+  }
+
   llvm::TargetOptions opt;
-  auto targetMachine = target->createTargetMachine(
-      targetTriple, "generic", "", opt, std::nullopt, std::nullopt,
-      llvm::CodeGenOptLevel::Default);
-  if (!targetMachine)
+  std::optional<llvm::Reloc::Model> relocModel;
+  if (tinyRuntime_) {
+    opt.FunctionSections = true;
+    opt.DataSections = true;
+    relocModel = llvm::Reloc::Static;
+  }
+  std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+      targetTriple, "generic", "", opt, relocModel, std::nullopt,
+      codeGenLevel));
+  if (!machine)
     throw Error("could not create target machine");
+  return machine;
+}
 
-  module_->setDataLayout(targetMachine->createDataLayout());
+llvm::TargetMachine *IRGenerator::targetMachine() {
+  if (targetMachine_) {
+    return targetMachine_.get();
+  }
 
-  std::error_code ec;
-  llvm::raw_fd_ostream dest(filename, ec, llvm::sys::fs::OF_None);
-  if (ec) {
-    throw Error("could not open file", ec.message());
+  llvm::InitializeAllTargetInfos();
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmParsers();
+  llvm::InitializeAllAsmPrinters();
+
+  targetMachine_ = createTargetMachine();
+  module_->setTargetTriple(targetMachine_->getTargetTriple());
+  module_->setDataLayout(targetMachine_->createDataLayout());
+  return targetMachine_.get();
+}
+
+void IRGenerator::emitMachineCode(
+    const std::vector<std::filesystem::path> &outputs, bool assembly) {
+  llvm::TargetMachine *machine = targetMachine();
+  auto fileType = assembly ? llvm::CodeGenFileType::AssemblyFile
+                           : llvm::CodeGenFileType::ObjectFile;
+
+  std::vector<std::unique_ptr<llvm::raw_fd_ostream>> files;
+  for (const auto &output : outputs) {
+    files.push_back(openOutput(output));
   }
 
-  llvm::legacy::PassManager pass;
-  auto fileType = llvm::CodeGenFileType::ObjectFile;
+  if (files.size() == 1) {
+    // The object writer seeks back to patch headers, which a pipe on
+    // standard output cannot do, so such output is buffered whole and
+    // written when the buffer is destroyed.
+    std::unique_ptr<llvm::buffer_ostream> buffer;
+    llvm::raw_pwrite_stream *out = files.front().get();
+    if (!files.front()->supportsSeeking()) {
+      buffer = std::make_unique<llvm::buffer_ostream>(*files.front());
+      out = buffer.get();
+    }
+
+    llvm::legacy::PassManager pass;
+    if (machine->addPassesToEmitFile(pass, *out, nullptr, fileType)) {
+      throw Error(assembly ? "target machine could not emit assembly file"
+                           : "target machine could not emit object file");
+    }
+    pass.run(*module_);
+    return;
+  }
 
-  if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
-    throw Error("target machine could not emit object file");
+  // splitCodeGen partitions the module along its call graph, round-trips
+  // each partition through bitcode into a context of its own and runs the
+  // backend on them concurrently, one thread per partition. Internal
+  // symbols referenced across partitions are promoted to hidden ones, so
+  // the objects still link like the single object would.
+  std::vector<llvm::raw_pwrite_stream *> streams;
+  for (auto &file : files) {
+    streams.push_back(file.get());
   }
+  llvm::splitCodeGen(
+      *module_, streams, {}, [this] { return createTargetMachine(); },
+      fileType);
+}
+
+void IRGenerator::emitBitcodeFile(const std::filesystem::path &filename,
+                                  bool withSummary) {
+  targetMachine();
 
-  pass.run(*module_);
-  dest.close();
+  std::unique_ptr<llvm::raw_fd_ostream> dest = openOutput(filename);
+
+  if (withSummary) {
+    // ThinLTO needs a per-module summary so the link step can import
+    // functions across modules without loading every module in full.
+    llvm::ProfileSummaryInfo psi(*module_);
+    llvm::ModuleSummaryIndex index =
+        llvm::buildModuleSummaryIndex(*module_, nullptr, &psi);
+    llvm::WriteBitcodeToFile(*module_, *dest, false, &index, true);
+  } else {
+    llvm::WriteBitcodeToFile(*module_, *dest);
+  }
 }
 
 void IRGenerator::printIR() { module_->print(llvm::outs(), nullptr); }
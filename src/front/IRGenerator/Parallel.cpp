@@ -0,0 +1,288 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Intrinsics.h>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+// Every variable name read or assigned below node. Inner declarations may
+// shadow outer variables, so this over-approximates what a parallel body
+// captures; capturing an unused value is harmless.
+static void collectNames(const AST::Node *node, std::set<std::string> &names) {
+  if (!node) {
+    return;
+  }
+
+  if (auto *ident = dynamic_cast<const AST::IdentifierNode *>(node)) {
+    names.insert(ident->name().value);
+  } else if (auto *block = dynamic_cast<const AST::BlockNode *>(node)) {
+    for (const auto &stmt : block->statements()) {
+      collectNames(stmt.get(), names);
+    }
+  } else if (auto *varDecl = dynamic_cast<const AST::VarDeclNode *>(node)) {
+    collectNames(varDecl->expr(), names);
+  } else if (auto *assign = dynamic_cast<const AST::AssignNode *>(node)) {
+    names.insert(assign->name().value);
+    collectNames(assign->expr(), names);
+  } else if (auto *ifStmt = dynamic_cast<const AST::IfStmtNode *>(node)) {
+    collectNames(ifStmt->condition(), names);
+    collectNames(ifStmt->thenBlock(), names);
+    collectNames(ifStmt->elseBlock(), names);
+  } else if (auto *whileStmt = dynamic_cast<const AST::WhileStmtNode *>(node)) {
+    collectNames(whileStmt->condition(), names);
+    collectNames(whileStmt->body(), names);
+  } else if (auto *loop = dynamic_cast<const AST::ParallelForNode *>(node)) {
+    collectNames(loop->begin(), names);
+    collectNames(loop->end(), names);
+    for (const auto &reduction : loop->reductions()) {
+      names.insert(reduction.name.value);
+    }
+    collectNames(loop->body(), names);
+  } else if (auto *call = dynamic_cast<const AST::FuncCallNode *>(node)) {
+    collectNames(call->args(), names);
+  } else if (auto *args = dynamic_cast<const AST::ArgListNode *>(node)) {
+    for (const auto &arg : args->args()) {
+      collectNames(arg.get(), names);
+    }
+  } else if (auto *print = dynamic_cast<const AST::PrintStmtNode *>(node)) {
+    collectNames(print->expr(), names);
+  } else if (auto *spawn = dynamic_cast<const AST::SpawnStmtNode *>(node)) {
+    collectNames(spawn->call(), names);
+  } else if (auto *exprStmt = dynamic_cast<const AST::ExprStmtNode *>(node)) {
+    collectNames(exprStmt->expr(), names);
+  } else if (auto *binOp = dynamic_cast<const AST::BinaryOpNode *>(node)) {
+    collectNames(binOp->left(), names);
+    collectNames(binOp->right(), names);
+  } else if (auto *unaryOp = dynamic_cast<const AST::UnaryOpNode *>(node)) {
+    collectNames(unaryOp->operand(), names);
+  } else if (auto *await = dynamic_cast<const AST::AwaitNode *>(node)) {
+    collectNames(await->expr(), names);
+  } else if (auto *access = dynamic_cast<const AST::FieldAccessNode *>(node)) {
+    collectNames(access->object(), names);
+  }
+}
+
+static llvm::Value *reductionIdentity(const Token &op, llvm::Type *type) {
+  bool isFloat = type->isFloatingPointTy();
+  unsigned bits = isFloat ? 0 : type->getIntegerBitWidth();
+
+  if (op.type == Token::Type::Plus) {
+    return isFloat ? llvm::ConstantFP::getNegativeZero(type)
+                   : llvm::ConstantInt::get(type, 0);
+  }
+  if (op.type == Token::Type::Multiply) {
+    return isFloat ? llvm::ConstantFP::get(type, 1.0)
+                   : llvm::ConstantInt::get(type, 1);
+  }
+  if (op.value == "min") {
+    return isFloat ? llvm::ConstantFP::getInfinity(type, false)
+                   : llvm::ConstantInt::get(
+                         type, llvm::APInt::getSignedMaxValue(bits));
+  }
+  return isFloat ? llvm::ConstantFP::getInfinity(type, true)
+                 : llvm::ConstantInt::get(
+                       type, llvm::APInt::getSignedMinValue(bits));
+}
+
+static llvm::Value *combineReduction(llvm::IRBuilder<> &builder,
+                                     const Token &op, llvm::Value *left,
+                                     llvm::Value *right, bool nsw) {
+  bool isFloat = left->getType()->isFloatingPointTy();
+
+  if (op.type == Token::Type::Plus) {
+    return isFloat ? builder.CreateFAdd(left, right)
+                   : builder.CreateAdd(left, right, "", false, nsw);
+  }
+  if (op.type == Token::Type::Multiply) {
+    return isFloat ? builder.CreateFMul(left, right)
+                   : builder.CreateMul(left, right, "", false, nsw);
+  }
+  if (op.value == "min") {
+    return builder.CreateBinaryIntrinsic(
+        isFloat ? llvm::Intrinsic::minnum : llvm::Intrinsic::smin, left, right);
+  }
+  return builder.CreateBinaryIntrinsic(
+      isFloat ? llvm::Intrinsic::maxnum : llvm::Intrinsic::smax, left, right);
+}
+
+// The body is outlined into a function over a sub-range of the iterations,
+// which the runtime hands to its worker threads. Values the body reads from
+// the enclosing function are copied into a context struct, followed by one
+// slot per reduction that the outlined function folds its partial result
+// into.
+void IRGenerator::visit(const AST::ParallelForNode &node) {
+  llvm::Value *begin = generateExpr(node.begin());
+  llvm::Value *end = generateExpr(node.end());
+
+  std::set<std::string> names;
+  collectNames(node.body(), names);
+
+  std::vector<std::string> reductions;
+  for (const auto &reduction : node.reductions()) {
+    reductions.push_back(reduction.name.value);
+  }
+
+  std::vector<std::string> captures;
+  for (const auto &name : names) {
+    if (name != node.var().value && findVariable(name) &&
+        std::ranges::find(reductions, name) == reductions.end()) {
+      captures.push_back(name);
+    }
+  }
+
+  std::vector<llvm::Type *> fieldTypes;
+  std::vector<llvm::Value *> fieldValues;
+  for (const auto *group : {&captures, &reductions}) {
+    for (const auto &name : *group) {
+      fieldTypes.push_back(ssa_.variables[lookupVariable(name)].type);
+      fieldValues.push_back(loadVariable(name));
+    }
+  }
+
+  llvm::StructType *contextType = llvm::StructType::get(context_, fieldTypes);
+  llvm::BasicBlock &entry = currentFunc_->getEntryBlock();
+  llvm::IRBuilder<> entryBuilder(&entry, entry.begin());
+  llvm::AllocaInst *contextSlot =
+      entryBuilder.CreateAlloca(contextType, nullptr, "parallel.ctx");
+
+  for (unsigned i = 0; i < fieldValues.size(); ++i) {
+    builder_.CreateStore(fieldValues[i],
+                         builder_.CreateStructGEP(contextType, contextSlot, i));
+  }
+
+  llvm::Function *body = outlineParallelBody(node, contextType, captures);
+
+  llvm::FunctionType *parallelForType = llvm::FunctionType::get(
+      builder_.getVoidTy(),
+      {builder_.getPtrTy(), builder_.getInt32Ty(), builder_.getInt32Ty(),
+       builder_.getPtrTy()},
+      false);
+  builder_.CreateCall(
+      getRuntimeFunction("ode_parallel_for", parallelForType, false),
+      {body, begin, end, contextSlot});
+
+  for (unsigned i = 0; i < reductions.size(); ++i) {
+    unsigned field = captures.size() + i;
+    llvm::Value *result = builder_.CreateLoad(
+        fieldTypes[field],
+        builder_.CreateStructGEP(contextType, contextSlot, field),
+        reductions[i]);
+    storeVariable(reductions[i], result);
+  }
+}
+
+llvm::Function *
+IRGenerator::outlineParallelBody(const AST::ParallelForNode &node,
+                                 llvm::StructType *contextType,
+                                 const std::vector<std::string> &captures) {
+  llvm::FunctionType *bodyType = llvm::FunctionType::get(
+      builder_.getVoidTy(),
+      {builder_.getInt32Ty(), builder_.getInt32Ty(), builder_.getPtrTy()},
+      false);
+  llvm::Function *func = llvm::Function::Create(
+      bodyType, llvm::Function::InternalLinkage,
+      currentFunc_->getName() + ".parallel", module_.get());
+  func->setDoesNotThrow();
+
+  llvm::Argument *begin = func->getArg(0);
+  llvm::Argument *end = func->getArg(1);
+  llvm::Argument *context = func->getArg(2);
+  begin->setName("begin");
+  end->setName("end");
+  context->setName("ctx");
+
+  llvm::BasicBlock *enclosingBlock = builder_.GetInsertBlock();
+  llvm::Function *enclosingFunc = std::exchange(currentFunc_, func);
+  SSAState enclosingState = std::exchange(ssa_, {});
+  std::optional<CoroutineState> enclosingCoroutine =
+      std::exchange(coroutine_, std::nullopt);
+  llvm::DIScope *enclosingScope = debugScope_;
+  llvm::DebugLoc enclosingLocation = builder_.getCurrentDebugLocation();
+
+  llvm::BasicBlock *entryBB = llvm::BasicBlock::Create(context_, "entry", func);
+  builder_.SetInsertPoint(entryBB);
+  sealBlock(entryBB);
+  if (enclosingScope) {
+    beginDebugFunction(func, node.location(), Type::Void, {});
+  }
+  emitProfileEnter();
+  enterScope();
+
+  unsigned field = 0;
+  for (const auto &name : captures) {
+    llvm::Type *type = contextType->getElementType(field);
+    llvm::Value *slot = builder_.CreateStructGEP(contextType, context, field);
+    declareVariable(name, type, builder_.CreateLoad(type, slot, name));
+    ++field;
+  }
+  for (const auto &reduction : node.reductions()) {
+    llvm::Type *type = contextType->getElementType(field);
+    declareVariable(reduction.name.value, type,
+                    reductionIdentity(reduction.op, type));
+    ++field;
+  }
+  declareVariable(node.var().value, builder_.getInt32Ty(), begin);
+
+  llvm::BasicBlock *condBB =
+      llvm::BasicBlock::Create(context_, "for.cond", func);
+  llvm::BasicBlock *bodyBB =
+      llvm::BasicBlock::Create(context_, "for.body", func);
+  llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context_, "for.end", func);
+
+  builder_.CreateBr(condBB);
+
+  builder_.SetInsertPoint(condBB);
+  llvm::Value *index = loadVariable(node.var().value);
+  builder_.CreateCondBr(builder_.CreateICmpSLT(index, end), bodyBB, endBB);
+  sealBlock(bodyBB);
+  sealBlock(endBB);
+
+  builder_.SetInsertPoint(bodyBB);
+  node.body()->accept(*this);
+  if (!builder_.GetInsertBlock()->getTerminator()) {
+    // index < end <= INT32_MAX, so the increment cannot overflow.
+    llvm::Value *next = builder_.CreateNSWAdd(
+        loadVariable(node.var().value), builder_.getInt32(1), "next");
+    storeVariable(node.var().value, next);
+    builder_.CreateBr(condBB);
+  }
+  sealBlock(condBB);
+
+  builder_.SetInsertPoint(endBB);
+  if (!node.reductions().empty()) {
+    llvm::FunctionType *lockType =
+        llvm::FunctionType::get(builder_.getVoidTy(), false);
+    builder_.CreateCall(
+        getRuntimeFunction("ode_parallel_lock", lockType, false));
+
+    field = captures.size();
+    for (const auto &reduction : node.reductions()) {
+      llvm::Type *type = contextType->getElementType(field);
+      llvm::Value *slot = builder_.CreateStructGEP(contextType, context, field);
+      llvm::Value *combined =
+          combineReduction(builder_, reduction.op,
+                           builder_.CreateLoad(type, slot),
+                           loadVariable(reduction.name.value),
+                           !arithmetic_.wrap);
+      builder_.CreateStore(combined, slot);
+      ++field;
+    }
+
+    builder_.CreateCall(
+        getRuntimeFunction("ode_parallel_unlock", lockType, false));
+  }
+  emitProfileExit();
+  builder_.CreateRetVoid();
+
+  coroutine_ = enclosingCoroutine;
+  debugScope_ = enclosingScope;
+  builder_.SetCurrentDebugLocation(enclosingLocation);
+  ssa_ = std::move(enclosingState);
+  currentFunc_ = enclosingFunc;
+  builder_.SetInsertPoint(enclosingBlock);
+
+  return func;
+}
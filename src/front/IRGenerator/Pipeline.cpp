@@ -0,0 +1,53 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+
+static llvm::OptimizationLevel toOptimizationLevel(unsigned level) {
+  switch (level) {
+  case 0:
+    return llvm::OptimizationLevel::O0;
+  case 1:
+    return llvm::OptimizationLevel::O1;
+  case 2:
+    return llvm::OptimizationLevel::O2;
+  default:
+    return llvm::OptimizationLevel::O3;
+  }
+}
+
+void IRGenerator::optimize(bool prepareForThinLTO) {
+  llvm::LoopAnalysisManager lam;
+  llvm::FunctionAnalysisManager fam;
+  llvm::CGSCCAnalysisManager cgam;
+  llvm::ModuleAnalysisManager mam;
+
+  llvm::PassBuilder passBuilder(targetMachine());
+  passBuilder.registerModuleAnalyses(mam);
+  passBuilder.registerCGSCCAnalyses(cgam);
+  passBuilder.registerFunctionAnalyses(fam);
+  passBuilder.registerLoopAnalyses(lam);
+  passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+  // Every default pipeline, O0 included, runs the coroutine passes that split
+  // async functions into their ramp, resume and destroy functions.
+  llvm::OptimizationLevel level = toOptimizationLevel(optLevel_);
+  llvm::ModulePassManager mpm;
+
+  if (level == llvm::OptimizationLevel::O0) {
+    mpm = passBuilder.buildO0DefaultPipeline(
+        level, prepareForThinLTO ? llvm::ThinOrFullLTOPhase::ThinLTOPreLink
+                                 : llvm::ThinOrFullLTOPhase::None);
+  } else if (prepareForThinLTO) {
+    // The heavy inlining and cleanup happens again at link time, once every
+    // module's summary is visible, so only the pre-link subset runs here.
+    mpm = passBuilder.buildThinLTOPreLinkDefaultPipeline(level);
+  } else {
+    mpm = passBuilder.buildPerModuleDefaultPipeline(level);
+  }
+
+  mpm.run(*module_, mam);
+}
@@ -0,0 +1,155 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+
+void IRGenerator::enterScope() { ssa_.scopes.emplace_back(); }
+
+void IRGenerator::exitScope() {
+  if (!ssa_.scopes.empty()) {
+    ssa_.scopes.pop_back();
+  }
+}
+
+void IRGenerator::declareVariable(const std::string &name, llvm::Type *type,
+                                  llvm::Value *val) {
+  unsigned var = ssa_.variables.size();
+  ssa_.variables.push_back({name, type, {}});
+  ssa_.scopes.back()[name] = var;
+  writeVariable(var, builder_.GetInsertBlock(), val);
+}
+
+std::optional<unsigned>
+IRGenerator::findVariable(const std::string &name) const {
+  for (auto it = ssa_.scopes.rbegin(); it != ssa_.scopes.rend(); ++it) {
+    auto found = it->find(name);
+    if (found != it->end()) {
+      return found->second;
+    }
+  }
+  return std::nullopt;
+}
+
+unsigned IRGenerator::lookupVariable(const std::string &name) const {
+  if (std::optional<unsigned> var = findVariable(name)) {
+    return *var;
+  }
+  throw Error(std::format("variable '{}' not found", name));
+}
+
+void IRGenerator::storeVariable(const std::string &name, llvm::Value *val) {
+  unsigned var = lookupVariable(name);
+  writeVariable(var, builder_.GetInsertBlock(), val);
+  emitDebugValue(var, val, builder_.GetInsertPoint());
+}
+
+llvm::Value *IRGenerator::loadVariable(const std::string &name) {
+  return readVariable(lookupVariable(name), builder_.GetInsertBlock());
+}
+
+void IRGenerator::writeVariable(unsigned var, llvm::BasicBlock *block,
+                                llvm::Value *val) {
+  ssa_.variables[var].definitions[block] = val;
+}
+
+llvm::Value *IRGenerator::readVariable(unsigned var, llvm::BasicBlock *block) {
+  auto &definitions = ssa_.variables[var].definitions;
+  auto it = definitions.find(block);
+  if (it != definitions.end() && it->second) {
+    return it->second;
+  }
+  return readVariableRecursive(var, block);
+}
+
+llvm::Value *IRGenerator::readVariableRecursive(unsigned var,
+                                                llvm::BasicBlock *block) {
+  llvm::Value *val;
+
+  if (!ssa_.sealedBlocks.contains(block)) {
+    // More predecessors may still appear, so the operands are filled in
+    // once the block is sealed.
+    llvm::PHINode *phi = createPhi(var, block);
+    ssa_.incompletePhis[block].push_back({var, phi});
+    val = phi;
+  } else if (llvm::BasicBlock *pred = block->getSinglePredecessor()) {
+    val = readVariable(var, pred);
+  } else {
+    // Record the PHI before reading the predecessors to break cycles.
+    llvm::PHINode *phi = createPhi(var, block);
+    writeVariable(var, block, phi);
+    val = addPhiOperands(var, phi);
+  }
+
+  writeVariable(var, block, val);
+  return val;
+}
+
+llvm::PHINode *IRGenerator::createPhi(unsigned var, llvm::BasicBlock *block) {
+  llvm::IRBuilder<> phiBuilder(block, block->begin());
+  const Variable &variable = ssa_.variables[var];
+  llvm::PHINode *phi = phiBuilder.CreatePHI(variable.type, 2, variable.name);
+  emitDebugValue(var, phi, block->getFirstInsertionPt());
+  return phi;
+}
+
+llvm::Value *IRGenerator::addPhiOperands(unsigned var, llvm::PHINode *phi) {
+  ssa_.phisUnderConstruction.insert(phi);
+  for (llvm::BasicBlock *pred : llvm::predecessors(phi->getParent())) {
+    phi->addIncoming(readVariable(var, pred), pred);
+  }
+  ssa_.phisUnderConstruction.erase(phi);
+
+  return tryRemoveTrivialPhi(phi);
+}
+
+llvm::Value *IRGenerator::tryRemoveTrivialPhi(llvm::PHINode *phi) {
+  llvm::Value *same = nullptr;
+  for (llvm::Value *op : phi->incoming_values()) {
+    if (op == same || op == phi) {
+      continue;
+    }
+    if (same) {
+      // The PHI merges at least two values.
+      return phi;
+    }
+    same = op;
+  }
+
+  if (!same) {
+    // The PHI is unreachable or only refers to itself.
+    same = llvm::PoisonValue::get(phi->getType());
+  }
+
+  std::vector<llvm::WeakVH> users;
+  for (llvm::User *user : phi->users()) {
+    if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+      users.emplace_back(user);
+    }
+  }
+
+  phi->replaceAllUsesWith(same);
+  phi->eraseFromParent();
+
+  // Removing this PHI may make the PHIs that used it trivial as well. The
+  // result is tracked because that cascade may in turn replace 'same'.
+  llvm::WeakTrackingVH result(same);
+  for (llvm::WeakVH &user : users) {
+    auto *userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(user);
+    if (userPhi && !ssa_.phisUnderConstruction.contains(userPhi)) {
+      tryRemoveTrivialPhi(userPhi);
+    }
+  }
+  return result;
+}
+
+void IRGenerator::sealBlock(llvm::BasicBlock *block) {
+  auto it = ssa_.incompletePhis.find(block);
+  if (it != ssa_.incompletePhis.end()) {
+    auto pending = std::move(it->second);
+    ssa_.incompletePhis.erase(it);
+    for (auto &[var, phi] : pending) {
+      addPhiOperands(var, phi);
+    }
+  }
+  ssa_.sealedBlocks.insert(block);
+}
@@ -1,19 +1,30 @@
 #include "IRGenerator.hpp"
 
 void IRGenerator::visit(const AST::VarDeclNode &node) {
-  Type varType = SemanticAnalyzer::parseType(node.type());
+  Type varType = analysis_->resolveType(node.type());
   llvm::Type *llvmType = getLLVMType(varType);
 
-  llvm::AllocaInst *alloca =
-      createEntryBlockAlloca(currentFunc_, node.name().value, llvmType);
-  allocaMap_[node.name().value] = alloca;
-
   llvm::Value *val = generateExpr(node.expr());
-  builder_.CreateStore(val, alloca);
+  declareVariable(node.name().value, llvmType, val);
+  describeVariable(node.name().value, node.location(), varType);
 }
 
 void IRGenerator::visit(const AST::AssignNode &node) {
   llvm::Value *val = generateExpr(node.expr());
+
+  // Writing a field rebuilds the whole struct value with the field replaced.
+  if (!node.fields().empty()) {
+    llvm::Value *object = loadVariable(node.name().value);
+    llvm::Type *type = object->getType();
+    std::vector<unsigned> indices;
+    for (const auto &field : node.fields()) {
+      unsigned slot = fieldSlot(type, field.value);
+      indices.push_back(slot);
+      type = type->getStructElementType(slot);
+    }
+    val = builder_.CreateInsertValue(object, val, indices);
+  }
+
   storeVariable(node.name().value, val);
 }
 
@@ -36,21 +47,26 @@ void IRGenerator::visit(const AST::IfStmtNode &node) {
       llvm::BasicBlock::Create(context_, "if.end", func);
 
   builder_.CreateCondBr(condVal, thenBB, elseBB ? elseBB : mergeBB);
+  sealBlock(thenBB);
+  if (elseBB) {
+    sealBlock(elseBB);
+  }
 
   builder_.SetInsertPoint(thenBB);
   node.thenBlock()->accept(*this);
-  if (!thenBB->getTerminator()) {
+  if (!builder_.GetInsertBlock()->getTerminator()) {
     builder_.CreateBr(mergeBB);
   }
 
   if (elseBB) {
     builder_.SetInsertPoint(elseBB);
     node.elseBlock()->accept(*this);
-    if (!elseBB->getTerminator()) {
+    if (!builder_.GetInsertBlock()->getTerminator()) {
       builder_.CreateBr(mergeBB);
     }
   }
 
+  sealBlock(mergeBB);
   builder_.SetInsertPoint(mergeBB);
 }
 
@@ -75,42 +91,43 @@ void IRGenerator::visit(const AST::WhileStmtNode &node) {
   }
 
   builder_.CreateCondBr(condVal, bodyBB, endBB);
+  sealBlock(bodyBB);
+  sealBlock(endBB);
 
   builder_.SetInsertPoint(bodyBB);
   node.body()->accept(*this);
-  if (!bodyBB->getTerminator()) {
+  if (!builder_.GetInsertBlock()->getTerminator()) {
     builder_.CreateBr(condBB);
   }
 
+  // The back edge is in place, so the loop header has all its predecessors.
+  sealBlock(condBB);
   builder_.SetInsertPoint(endBB);
 }
 void IRGenerator::visit(const AST::PrintStmtNode &node) {
   llvm::Value *expr = generateExpr(node.expr());
 
-  std::string formatStr;
+  std::string runtimeName;
   if (expr->getType()->isIntegerTy(1)) {
-    formatStr = "%d\n";
+    runtimeName = "ode_print_bool";
   } else if (expr->getType()->isIntegerTy(32)) {
-    formatStr = "%d\n";
-  } else if (expr->getType()->isIntegerTy(64)) {
-    formatStr = "%lld\n";
+    runtimeName = "ode_print_i32";
   } else if (expr->getType()->isFloatTy()) {
-    formatStr = "%f\n";
+    runtimeName = "ode_print_f32";
   } else {
     throw Error("unsupported type for print statement");
   }
 
-  llvm::Value *formatStrVal = builder_.CreateGlobalString(formatStr);
-  llvm::Function *printfFunc = getPrintfFunction();
+  llvm::FunctionType *printType = llvm::FunctionType::get(
+      llvm::Type::getVoidTy(context_), {expr->getType()}, false);
+  llvm::Function *printFunc = getRuntimeFunction(runtimeName, printType);
+  llvm::CallInst *call = builder_.CreateCall(printFunc, {expr});
 
+  // The runtime takes a C bool, which the caller has to zero-extend.
   if (expr->getType()->isIntegerTy(1)) {
-    expr = builder_.CreateZExt(expr, llvm::Type::getInt32Ty(context_));
+    printFunc->addParamAttr(0, llvm::Attribute::ZExt);
+    call->addParamAttr(0, llvm::Attribute::ZExt);
   }
-
-  std::vector<llvm::Value *> args;
-  args.push_back(formatStrVal);
-  args.push_back(expr);
-  builder_.CreateCall(printfFunc, args);
 }
 
 void IRGenerator::visit(const AST::ExprStmtNode &node) {
@@ -0,0 +1,76 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/Support/Alignment.h>
+
+// Struct types are built on first use. The analyzer has already chosen the
+// order of the elements, and the data layout places them.
+llvm::StructType *IRGenerator::getStructType(Type type) {
+  if (auto it = structTypes_.find(type); it != structTypes_.end()) {
+    return it->second;
+  }
+
+  const StructInfo &info = analysis_->structInfo(type);
+  std::vector<llvm::Type *> elements(info.fields.size());
+  for (size_t i = 0; i < info.fields.size(); ++i) {
+    elements[info.slots[i]] = getLLVMType(info.fields[i].type);
+  }
+
+  // LLVM types carry no alignment of their own, so @align(N) only rounds the
+  // size up with a trailing byte array. The unpadded size comes from a
+  // literal struct: the data layout caches the layout of every struct it is
+  // asked about, so the named one must get its body exactly once.
+  if (info.align) {
+    const llvm::DataLayout &layout = module_->getDataLayout();
+    const llvm::StructLayout *structLayout = layout.getStructLayout(
+        llvm::StructType::get(context_, elements, info.packed));
+    uint64_t end =
+        structLayout->getElementOffset(elements.size() - 1) +
+        layout.getTypeAllocSize(elements.back()).getFixedValue();
+    uint64_t padded = llvm::alignTo(end, info.align);
+    if (padded > end) {
+      elements.push_back(
+          llvm::ArrayType::get(builder_.getInt8Ty(), padded - end));
+    }
+  }
+
+  llvm::StructType *structType =
+      llvm::StructType::create(context_, elements, info.name, info.packed);
+
+  structTypes_[type] = structType;
+  structOrigins_[structType] = type;
+  return structType;
+}
+
+unsigned IRGenerator::fieldSlot(llvm::Type *structType,
+                                const std::string &field) const {
+  const StructInfo &info = analysis_->structInfo(structOrigins_.at(structType));
+  return info.slots[*info.fieldIndex(field)];
+}
+
+llvm::Value *
+IRGenerator::generateStructConstruction(const AST::FuncCallNode &node,
+                                        Type type) {
+  llvm::StructType *structType = getStructType(type);
+  const StructInfo &info = analysis_->structInfo(type);
+
+  llvm::Value *value = llvm::PoisonValue::get(structType);
+  if (auto *args = dynamic_cast<const AST::ArgListNode *>(node.args())) {
+    for (size_t i = 0; i < args->args().size(); ++i) {
+      llvm::Value *field = generateExpr(args->args()[i].get());
+      value = builder_.CreateInsertValue(value, field, info.slots[i]);
+    }
+  }
+
+  // Padding added for @align is left as poison.
+  return value;
+}
+
+void IRGenerator::visit(const AST::StructDeclNode &node) {}
+
+void IRGenerator::visit(const AST::FieldAccessNode &node) {
+  throw Error(
+      "FieldAccessNode should not be visited directly - use generateExpr()");
+}
@@ -0,0 +1,231 @@
+#include "IRGenerator.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Verifier.h>
+
+#include <algorithm>
+#include <utility>
+
+// Collects the statements from node down to target, target excluded. Only
+// blocks, ifs and whiles are entered: a loop in a nested function or a
+// parallel body is never resumed.
+static bool findPath(const AST::Node *node, const AST::Node *target,
+                     std::vector<const AST::Node *> &path) {
+  if (node == target) {
+    return true;
+  }
+  if (!node) {
+    return false;
+  }
+
+  path.push_back(node);
+  std::vector<const AST::Node *> children;
+  if (auto *block = dynamic_cast<const AST::BlockNode *>(node)) {
+    for (const auto &stmt : block->statements()) {
+      children.push_back(stmt.get());
+    }
+  } else if (auto *ifStmt = dynamic_cast<const AST::IfStmtNode *>(node)) {
+    children = {ifStmt->thenBlock(), ifStmt->elseBlock()};
+  } else if (auto *whileStmt = dynamic_cast<const AST::WhileStmtNode *>(node)) {
+    children = {whileStmt->body()};
+  }
+  for (const AST::Node *child : children) {
+    if (findPath(child, target, path)) {
+      return true;
+    }
+  }
+  path.pop_back();
+  return false;
+}
+
+llvm::Value *IRGenerator::loadCells(Type type, llvm::Value *cells,
+                                    unsigned &cell) {
+  if (isStructType(type)) {
+    const StructInfo &info = analysis_->structInfo(type);
+    llvm::Value *value = llvm::PoisonValue::get(getStructType(type));
+    for (size_t i = 0; i < info.fields.size(); ++i) {
+      value = builder_.CreateInsertValue(
+          value, loadCells(info.fields[i].type, cells, cell), info.slots[i]);
+    }
+    return value;
+  }
+
+  llvm::Value *address =
+      builder_.CreateConstInBoundsGEP1_32(builder_.getInt32Ty(), cells, cell);
+  cell += laneCount(type);
+  if (type == Type::Bool) {
+    llvm::Value *bits = builder_.CreateLoad(builder_.getInt32Ty(), address);
+    return builder_.CreateICmpNE(bits, builder_.getInt32(0));
+  }
+  return builder_.CreateAlignedLoad(getLLVMType(type), address,
+                                    llvm::Align(4));
+}
+
+void IRGenerator::storeCells(Type type, llvm::Value *value,
+                             llvm::Value *cells, unsigned &cell) {
+  if (isStructType(type)) {
+    const StructInfo &info = analysis_->structInfo(type);
+    for (size_t i = 0; i < info.fields.size(); ++i) {
+      storeCells(info.fields[i].type,
+                 builder_.CreateExtractValue(value, info.slots[i]), cells,
+                 cell);
+    }
+    return;
+  }
+
+  llvm::Value *address =
+      builder_.CreateConstInBoundsGEP1_32(builder_.getInt32Ty(), cells, cell);
+  cell += laneCount(type);
+  if (type == Type::Bool) {
+    value = builder_.CreateZExt(value, builder_.getInt32Ty());
+  }
+  builder_.CreateAlignedStore(value, address, llvm::Align(4));
+}
+
+void IRGenerator::generateCellEntry(const std::string &name,
+                                    const AST::FuncDeclNode &function,
+                                    const SemanticAnalyzer &analysis) {
+  analysis_ = &analysis;
+  llvm::Function *callee = module_->getFunction(function.name().value);
+  if (!callee) {
+    throw Error("undefined function: " + function.name().value);
+  }
+
+  llvm::FunctionType *entryType = llvm::FunctionType::get(
+      builder_.getVoidTy(), {builder_.getPtrTy(), builder_.getPtrTy()}, false);
+  llvm::Function *entry = llvm::Function::Create(
+      entryType, llvm::Function::ExternalLinkage, name, module_.get());
+  entry->setDoesNotThrow();
+  builder_.SetInsertPoint(llvm::BasicBlock::Create(context_, "entry", entry));
+
+  std::vector<llvm::Value *> args;
+  unsigned cell = 0;
+  if (auto *params =
+          dynamic_cast<const AST::ParamListNode *>(function.params())) {
+    for (const auto &param : params->params()) {
+      args.push_back(loadCells(analysis_->resolveType(param.type.get()),
+                               entry->getArg(0), cell));
+    }
+  }
+  llvm::Value *result = builder_.CreateCall(callee, args);
+  Type retType = analysis_->resolveType(function.returnType());
+  if (retType != Type::Void) {
+    cell = 0;
+    storeCells(retType, result, entry->getArg(1), cell);
+  }
+  builder_.CreateRetVoid();
+
+  builder_.ClearInsertionPoint();
+  analysis_ = nullptr;
+  if (llvm::verifyFunction(*entry, &llvm::errs())) {
+    throw Error("cell entry verification failed: " + name);
+  }
+}
+
+// The loop runs again from its condition, and then whatever follows it:
+// walking outwards, the rest of each enclosing block, and each enclosing
+// loop from its condition once its body is done.
+void IRGenerator::generateLoopEntry(
+    const std::string &name, const AST::FuncDeclNode &function,
+    const AST::WhileStmtNode &loop,
+    const std::vector<std::vector<CellVariable>> &scopes,
+    const SemanticAnalyzer &analysis) {
+  analysis_ = &analysis;
+  std::vector<const AST::Node *> path;
+  if (!findPath(function.body(), &loop, path)) {
+    throw Error("loop entry", "loop is not part of " + function.name().value);
+  }
+  size_t blocks = std::count_if(path.begin(), path.end(), [](auto *node) {
+    return dynamic_cast<const AST::BlockNode *>(node) != nullptr;
+  });
+  if (scopes.size() != blocks + 1) {
+    throw Error("loop entry", "scopes do not match the blocks around loop");
+  }
+
+  Type retType = analysis_->resolveType(function.returnType());
+  llvm::Type *llvmRetType = getLLVMType(retType);
+  llvm::Function *resume = llvm::Function::Create(
+      llvm::FunctionType::get(llvmRetType, {builder_.getPtrTy()}, false),
+      llvm::Function::InternalLinkage, name + ".resume", module_.get());
+  resume->setDoesNotThrow();
+
+  currentFunc_ = resume;
+  ssa_ = {};
+  Options::Arithmetic enclosingArithmetic = arithmetic_;
+  useArithmetic(functionArithmetic(function));
+  llvm::BasicBlock *block = llvm::BasicBlock::Create(context_, "entry", resume);
+  builder_.SetInsertPoint(block);
+  sealBlock(block);
+
+  llvm::Value *cells = resume->getArg(0);
+  auto declareScope = [&](const std::vector<CellVariable> &variables) {
+    enterScope();
+    for (const auto &variable : variables) {
+      unsigned cell = variable.cell;
+      declareVariable(variable.name, getLLVMType(variable.type),
+                      loadCells(variable.type, cells, cell));
+    }
+  };
+  size_t scope = 0;
+  declareScope(scopes[scope++]);
+  for (const AST::Node *node : path) {
+    if (dynamic_cast<const AST::BlockNode *>(node)) {
+      declareScope(scopes[scope++]);
+    }
+  }
+
+  loop.accept(*this);
+  for (size_t i = path.size(); i-- > 0;) {
+    if (builder_.GetInsertBlock()->getTerminator()) {
+      break;
+    }
+    const AST::Node *child = i + 1 < path.size() ? path[i + 1] : &loop;
+    if (auto *enclosing = dynamic_cast<const AST::BlockNode *>(path[i])) {
+      const auto &stmts = enclosing->statements();
+      auto it = std::find_if(stmts.begin(), stmts.end(), [&](const auto &stmt) {
+        return stmt.get() == child;
+      });
+      for (++it; it != stmts.end(); ++it) {
+        if (builder_.GetInsertBlock()->getTerminator()) {
+          break;
+        }
+        (*it)->accept(*this);
+      }
+      exitScope();
+    } else if (auto *whileStmt =
+                   dynamic_cast<const AST::WhileStmtNode *>(path[i])) {
+      whileStmt->accept(*this);
+    }
+  }
+  if (!builder_.GetInsertBlock()->getTerminator()) {
+    if (retType == Type::Void) {
+      builder_.CreateRetVoid();
+    } else {
+      builder_.CreateRet(llvm::Constant::getNullValue(llvmRetType));
+    }
+  }
+
+  llvm::FunctionType *entryType = llvm::FunctionType::get(
+      builder_.getVoidTy(), {builder_.getPtrTy(), builder_.getPtrTy()}, false);
+  llvm::Function *entry = llvm::Function::Create(
+      entryType, llvm::Function::ExternalLinkage, name, module_.get());
+  entry->setDoesNotThrow();
+  builder_.SetInsertPoint(llvm::BasicBlock::Create(context_, "entry", entry));
+  llvm::Value *result = builder_.CreateCall(resume, {entry->getArg(0)});
+  if (retType != Type::Void) {
+    unsigned cell = 0;
+    storeCells(retType, result, entry->getArg(1), cell);
+  }
+  builder_.CreateRetVoid();
+
+  builder_.ClearInsertionPoint();
+  useArithmetic(enclosingArithmetic);
+  ssa_ = {};
+  currentFunc_ = nullptr;
+  analysis_ = nullptr;
+  if (llvm::verifyFunction(*resume, &llvm::errs()) ||
+      llvm::verifyFunction(*entry, &llvm::errs())) {
+    throw Error("loop entry verification failed: " + name);
+  }
+}
@@ -0,0 +1,717 @@
+#include "Interpreter/BytecodeCompiler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+#include "Optimizer/ConstEvaluator.hpp"
+
+using Op = Bytecode::Op;
+
+// Functions are global by name in the bytecode as in the native code, so
+// nested ones are compiled like top-level ones.
+static void collectFunctions(const AST::Node *node,
+                             std::vector<const AST::FuncDeclNode *> &out) {
+  if (!node) {
+    return;
+  }
+
+  if (auto *program = dynamic_cast<const AST::ProgramNode *>(node)) {
+    for (const auto &stmt : program->statements()) {
+      collectFunctions(stmt.get(), out);
+    }
+  } else if (auto *block = dynamic_cast<const AST::BlockNode *>(node)) {
+    for (const auto &stmt : block->statements()) {
+      collectFunctions(stmt.get(), out);
+    }
+  } else if (auto *func = dynamic_cast<const AST::FuncDeclNode *>(node)) {
+    out.push_back(func);
+    collectFunctions(func->body(), out);
+  } else if (auto *ifStmt = dynamic_cast<const AST::IfStmtNode *>(node)) {
+    collectFunctions(ifStmt->thenBlock(), out);
+    collectFunctions(ifStmt->elseBlock(), out);
+  } else if (auto *whileStmt = dynamic_cast<const AST::WhileStmtNode *>(node)) {
+    collectFunctions(whileStmt->body(), out);
+  } else if (auto *loop = dynamic_cast<const AST::ParallelForNode *>(node)) {
+    collectFunctions(loop->body(), out);
+  }
+}
+
+static std::vector<const AST::Node *> argsOf(const AST::FuncCallNode &node) {
+  std::vector<const AST::Node *> args;
+  if (auto *argList = dynamic_cast<const AST::ArgListNode *>(node.args())) {
+    for (const auto &arg : argList->args()) {
+      args.push_back(arg.get());
+    }
+  }
+  return args;
+}
+
+static std::optional<unsigned> literalLane(const AST::Node *node) {
+  if (auto *num = dynamic_cast<const AST::NumberNode *>(node)) {
+    return std::stoul(num->value().value);
+  }
+  return std::nullopt;
+}
+
+void BytecodeCompiler::declare(const FunctionSignature &signature) {
+  unsigned paramCells = 0;
+  for (Type param : signature.params) {
+    paramCells += cellCount(param);
+  }
+  declareFunction(signature.name, paramCells, cellCount(signature.returnType),
+                  signature.isAsync);
+}
+
+uint16_t BytecodeCompiler::declareFunction(const std::string &name,
+                                           unsigned paramCells,
+                                           unsigned resultCells,
+                                           bool isAsync) {
+  auto it = functionIndex_.find(name);
+  if (it != functionIndex_.end()) {
+    return it->second;
+  }
+  if (program_.functions.size() > UINT16_MAX) {
+    throw Error("too many functions to interpret");
+  }
+
+  auto index = static_cast<uint16_t>(program_.functions.size());
+  program_.functions.push_back({name, paramCells, resultCells, 0, isAsync});
+  functionIndex_.emplace(name, index);
+  return index;
+}
+
+void BytecodeCompiler::compile(const AST::Node &root,
+                               const SemanticAnalyzer &analysis) {
+  analysis_ = &analysis;
+
+  const auto &program = static_cast<const AST::ProgramNode &>(root);
+  for (const auto &stmt : program.statements()) {
+    if (!dynamic_cast<const AST::FuncDeclNode *>(stmt.get()) &&
+        !dynamic_cast<const AST::StructDeclNode *>(stmt.get())) {
+      throw Error("cannot interpret statements outside functions");
+    }
+  }
+
+  std::vector<const AST::FuncDeclNode *> functions;
+  collectFunctions(&root, functions);
+  for (const auto *func : functions) {
+    const auto &params =
+        static_cast<const AST::ParamListNode *>(func->params())->params();
+    unsigned paramCells = 0;
+    for (const auto &param : params) {
+      paramCells += cellCount(analysis.resolveType(param.type.get()));
+    }
+    uint16_t index = declareFunction(
+        func->name().value, paramCells,
+        cellCount(analysis.resolveType(func->returnType())), func->isAsync());
+    if (program_.functions[index].defined) {
+      throw Error(std::format("function '{}' is defined more than once",
+                              func->name().value));
+    }
+    program_.functions[index].defined = true;
+  }
+
+  for (const auto *func : functions) {
+    compileFunction(*func);
+  }
+  analysis_ = nullptr;
+  ++module_;
+}
+
+Bytecode::Program BytecodeCompiler::finish() {
+  for (const auto &function : program_.functions) {
+    if (!function.defined) {
+      throw Error(
+          std::format("cannot interpret calls to '{}'", function.name),
+          "pass the source file defining it as another input");
+    }
+  }
+  program_.main = userFunction("main");
+  if (!program_.main) {
+    throw Error("No main function found");
+  }
+  return std::move(program_);
+}
+
+void BytecodeCompiler::compileFunction(const AST::FuncDeclNode &node) {
+  function_ = &program_.functions[functionIndex_.at(node.name().value)];
+  function_->module = module_;
+  function_->source = &node;
+  scopes_.assign(1, {});
+  nextRegister_ = 0;
+
+  const auto &params =
+      static_cast<const AST::ParamListNode *>(node.params())->params();
+  for (const auto &param : params) {
+    Type type = analysis_->resolveType(param.type.get());
+    scopes_.back()[param.name.value] = {allocate(cellCount(type)), type};
+  }
+
+  compileStatement(node.body());
+
+  // Falling off the end returns zeros, like the native code.
+  if (function_->resultCells > 0) {
+    uint16_t result = allocate(function_->resultCells);
+    for (unsigned i = 0; i < function_->resultCells; ++i) {
+      emitLoad(result + i, 0);
+    }
+    emit(Op::Return, result);
+  } else {
+    emit(Op::Return);
+  }
+
+  scopes_.clear();
+  function_ = nullptr;
+}
+
+unsigned BytecodeCompiler::cellCount(Type type) const {
+  if (type == Type::Void) {
+    return 0;
+  }
+  if (isStructType(type)) {
+    unsigned cells = 0;
+    for (const auto &field : analysis_->structInfo(type).fields) {
+      cells += cellCount(field.type);
+    }
+    return cells;
+  }
+  return laneCount(type);
+}
+
+unsigned BytecodeCompiler::fieldOffset(Type type, const Token &field) const {
+  const StructInfo &info = analysis_->structInfo(type);
+  unsigned offset = 0;
+  for (unsigned i = 0; i < *info.fieldIndex(field.value); ++i) {
+    offset += cellCount(info.fields[i].type);
+  }
+  return offset;
+}
+
+// The AST passes replace some expressions with literals, which the analyzer
+// has not seen.
+Type BytecodeCompiler::typeOf(const AST::Node *node) const {
+  if (auto literal = ConstEvaluator::readLiteral(node)) {
+    switch (literal->kind) {
+    case ConstEvaluator::Value::Kind::I32:
+      return Type::I32;
+    case ConstEvaluator::Value::Kind::F32:
+      return Type::F32;
+    case ConstEvaluator::Value::Kind::Bool:
+      return Type::Bool;
+    }
+  }
+  if (std::optional<Type> type = analysis_->expressionType(node)) {
+    return *type;
+  }
+  throw Error("expression was not type checked");
+}
+
+const BytecodeCompiler::Variable &
+BytecodeCompiler::lookup(const Token &name) const {
+  for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+    auto it = scope->find(name.value);
+    if (it != scope->end()) {
+      return it->second;
+    }
+  }
+  throw Error(std::format("undefined variable '{}'", name.value));
+}
+
+std::optional<uint16_t>
+BytecodeCompiler::userFunction(const std::string &name) const {
+  auto it = functionIndex_.find(name);
+  if (it == functionIndex_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+uint16_t BytecodeCompiler::allocate(unsigned cells) {
+  unsigned first = nextRegister_;
+  nextRegister_ += cells;
+  if (nextRegister_ > UINT16_MAX) {
+    throw Error(std::format("function '{}' needs too many registers",
+                            function_->name));
+  }
+  function_->registerCount = std::max(function_->registerCount, nextRegister_);
+  return static_cast<uint16_t>(first);
+}
+
+size_t BytecodeCompiler::emit(Op op, unsigned a, unsigned b, unsigned c,
+                              unsigned n) {
+  function_->code.push_back({op, static_cast<uint8_t>(n),
+                             static_cast<uint16_t>(a), static_cast<uint16_t>(b),
+                             static_cast<uint16_t>(c)});
+  return function_->code.size() - 1;
+}
+
+void BytecodeCompiler::emitMove(uint16_t dst, uint16_t src, unsigned cells) {
+  for (unsigned i = 0; i < cells; ++i) {
+    emit(Op::Move, dst + i, src + i);
+  }
+}
+
+void BytecodeCompiler::emitLoad(uint16_t dst, uint32_t bits) {
+  function_->code[emit(Op::LoadImm, dst)].setImm(bits);
+}
+
+void BytecodeCompiler::patch(size_t index) {
+  function_->code[index].setImm(function_->code.size());
+}
+
+uint16_t BytecodeCompiler::place(uint16_t reg, unsigned cells,
+                                 std::optional<uint16_t> dst) {
+  if (!dst || *dst == reg) {
+    return reg;
+  }
+  emitMove(*dst, reg, cells);
+  return *dst;
+}
+
+void BytecodeCompiler::compileStatement(const AST::Node *node) {
+  unsigned mark = nextRegister_;
+
+  if (auto *block = dynamic_cast<const AST::BlockNode *>(node)) {
+    scopes_.emplace_back();
+    for (const auto &stmt : block->statements()) {
+      compileStatement(stmt.get());
+    }
+    scopes_.pop_back();
+  } else if (auto *varDecl = dynamic_cast<const AST::VarDeclNode *>(node)) {
+    // The variable is declared after its initializer, which may still read
+    // a variable it shadows.
+    Type type = analysis_->resolveType(varDecl->type());
+    uint16_t reg = allocate(cellCount(type));
+    compileExpr(varDecl->expr(), reg);
+    nextRegister_ = reg + cellCount(type);
+    scopes_.back()[varDecl->name().value] = {reg, type};
+    return;
+  } else if (auto *assign = dynamic_cast<const AST::AssignNode *>(node)) {
+    const Variable &var = lookup(assign->name());
+    uint16_t reg = var.reg;
+    Type type = var.type;
+    for (const auto &field : assign->fields()) {
+      reg += fieldOffset(type, field);
+      const StructInfo &info = analysis_->structInfo(type);
+      type = info.fields[*info.fieldIndex(field.value)].type;
+    }
+    // The value may read the variable, so it is only stored once complete.
+    emitMove(reg, compileExpr(assign->expr()), cellCount(type));
+  } else if (auto *ifStmt = dynamic_cast<const AST::IfStmtNode *>(node)) {
+    size_t toElse =
+        emit(Op::JumpIfFalse, compileExpr(ifStmt->condition()));
+    nextRegister_ = mark;
+    compileStatement(ifStmt->thenBlock());
+    if (ifStmt->hasElse()) {
+      size_t toEnd = emit(Op::Jump);
+      patch(toElse);
+      compileStatement(ifStmt->elseBlock());
+      patch(toEnd);
+    } else {
+      patch(toElse);
+    }
+  } else if (auto *whileStmt = dynamic_cast<const AST::WhileStmtNode *>(node)) {
+    compileWhile(*whileStmt);
+  } else if (auto *loop = dynamic_cast<const AST::ParallelForNode *>(node)) {
+    compileParallelFor(*loop);
+  } else if (auto *ret = dynamic_cast<const AST::ReturnStmtNode *>(node)) {
+    auto *call = dynamic_cast<const AST::FuncCallNode *>(ret->expr());
+    std::optional<uint16_t> callee;
+    if (call && !analysis_->structType(call->name().value)) {
+      callee = userFunction(call->name().value);
+    }
+    if (callee &&
+        program_.functions[*callee].resultCells == function_->resultCells) {
+      emit(Op::TailCall, 0, *callee, compileArgs(*call, *callee));
+    } else if (ret->expr()) {
+      emit(Op::Return, compileExpr(ret->expr()));
+    } else {
+      emit(Op::Return);
+    }
+  } else if (auto *print = dynamic_cast<const AST::PrintStmtNode *>(node)) {
+    Type type = typeOf(print->expr());
+    Op op = type == Type::F32  ? Op::PrintF
+            : type == Type::Bool ? Op::PrintB
+                                 : Op::PrintI;
+    emit(op, compileExpr(print->expr()));
+  } else if (auto *spawn = dynamic_cast<const AST::SpawnStmtNode *>(node)) {
+    const auto &call = static_cast<const AST::FuncCallNode &>(*spawn->call());
+    uint16_t callee = *userFunction(call.name().value);
+    emit(Op::Spawn, 0, callee, compileArgs(call, callee));
+  } else if (auto *exprStmt = dynamic_cast<const AST::ExprStmtNode *>(node)) {
+    compileExpr(exprStmt->expr());
+  } else if (!dynamic_cast<const AST::FuncDeclNode *>(node) &&
+             !dynamic_cast<const AST::StructDeclNode *>(node)) {
+    throw Error("unknown statement node type");
+  }
+
+  nextRegister_ = mark;
+}
+
+void BytecodeCompiler::compileWhile(const AST::WhileStmtNode &node) {
+  // Native code could only resume a loop inside a parallel for by running
+  // the rest of the parallel loop too, so those stay in the interpreter.
+  std::optional<uint16_t> loop;
+  if (parallelDepth_ == 0 && program_.loops.size() <= UINT16_MAX) {
+    loop = static_cast<uint16_t>(program_.loops.size());
+    Bytecode::Loop &site = program_.loops.emplace_back();
+    site.function =
+        static_cast<uint16_t>(function_ - program_.functions.data());
+    site.source = &node;
+    for (const auto &scope : scopes_) {
+      auto &locals = site.scopes.emplace_back();
+      for (const auto &[name, var] : scope) {
+        locals.push_back({name, var.type, var.reg});
+      }
+    }
+  }
+
+  unsigned mark = nextRegister_;
+  size_t start = function_->code.size();
+  size_t toEnd = emit(Op::JumpIfFalse, compileExpr(node.condition()));
+  nextRegister_ = mark;
+  compileStatement(node.body());
+  size_t backEdge = loop ? emit(Op::Loop, *loop) : emit(Op::Jump);
+  function_->code[backEdge].setImm(start);
+  patch(toEnd);
+}
+
+// The iterations run in order on the calling thread. Each reduction
+// variable starts the loop at its identity and is combined with the value it
+// had before, as a single chunk of the native loop would be.
+void BytecodeCompiler::compileParallelFor(const AST::ParallelForNode &node) {
+  uint16_t index = allocate(1);
+  compileExpr(node.begin(), index);
+  uint16_t end = allocate(1);
+  compileExpr(node.end(), end);
+  uint16_t one = allocate(1);
+  emitLoad(one, 1);
+
+  struct Reduction {
+    uint16_t reg;
+    uint16_t saved;
+    Op combine;
+  };
+  std::vector<Reduction> reductions;
+  for (const auto &reduction : node.reductions()) {
+    const Variable &var = lookup(reduction.name);
+    bool isFloat = var.type == Type::F32;
+    uint32_t identity;
+    Op combine;
+    if (reduction.op.type == Token::Type::Plus) {
+      identity = isFloat ? std::bit_cast<uint32_t>(-0.0f) : 0;
+      combine = isFloat ? Op::AddF : Op::AddI;
+    } else if (reduction.op.type == Token::Type::Multiply) {
+      identity = isFloat ? std::bit_cast<uint32_t>(1.0f) : 1;
+      combine = isFloat ? Op::MulF : Op::MulI;
+    } else if (reduction.op.value == "min") {
+      identity = isFloat ? std::bit_cast<uint32_t>(
+                               std::numeric_limits<float>::infinity())
+                         : INT32_MAX;
+      combine = isFloat ? Op::MinF : Op::MinI;
+    } else {
+      identity = isFloat ? std::bit_cast<uint32_t>(
+                               -std::numeric_limits<float>::infinity())
+                         : static_cast<uint32_t>(INT32_MIN);
+      combine = isFloat ? Op::MaxF : Op::MaxI;
+    }
+
+    uint16_t saved = allocate(1);
+    emitMove(saved, var.reg, 1);
+    emitLoad(var.reg, identity);
+    reductions.push_back({var.reg, saved, combine});
+  }
+
+  scopes_.emplace_back();
+  scopes_.back()[node.var().value] = {index, Type::I32};
+  uint16_t inRange = allocate(1);
+  size_t start = function_->code.size();
+  emit(Op::LtI, inRange, index, end);
+  size_t toEnd = emit(Op::JumpIfFalse, inRange);
+  ++parallelDepth_;
+  compileStatement(node.body());
+  --parallelDepth_;
+  emit(Op::AddI, index, index, one);
+  function_->code[emit(Op::Jump)].setImm(start);
+  patch(toEnd);
+  scopes_.pop_back();
+
+  for (const auto &reduction : reductions) {
+    emit(reduction.combine, reduction.reg, reduction.saved, reduction.reg);
+  }
+}
+
+uint16_t BytecodeCompiler::compileExpr(const AST::Node *node,
+                                       std::optional<uint16_t> dst) {
+  if (auto literal = ConstEvaluator::readLiteral(node)) {
+    uint16_t reg = dst ? *dst : allocate(1);
+    switch (literal->kind) {
+    case ConstEvaluator::Value::Kind::I32:
+      emitLoad(reg, static_cast<uint32_t>(literal->i32));
+      break;
+    case ConstEvaluator::Value::Kind::F32:
+      emitLoad(reg, std::bit_cast<uint32_t>(literal->f32));
+      break;
+    case ConstEvaluator::Value::Kind::Bool:
+      emitLoad(reg, literal->boolean);
+      break;
+    }
+    return reg;
+  }
+  if (auto *ident = dynamic_cast<const AST::IdentifierNode *>(node)) {
+    const Variable &var = lookup(ident->name());
+    return place(var.reg, cellCount(var.type), dst);
+  }
+  if (auto *access = dynamic_cast<const AST::FieldAccessNode *>(node)) {
+    uint16_t object = compileExpr(access->object());
+    uint16_t field =
+        object + fieldOffset(typeOf(access->object()), access->field());
+    return place(field, cellCount(typeOf(node)), dst);
+  }
+  if (auto *binOp = dynamic_cast<const AST::BinaryOpNode *>(node)) {
+    return compileBinaryOp(*binOp, dst);
+  }
+  if (auto *unaryOp = dynamic_cast<const AST::UnaryOpNode *>(node)) {
+    uint16_t operand = compileExpr(unaryOp->operand());
+    Type type = typeOf(node);
+    Op op = unaryOp->op().type == Token::Type::Not ? Op::Not
+            : elementType(type) == Type::F32       ? Op::NegF
+                                                   : Op::NegI;
+    uint16_t reg = dst ? *dst : allocate(cellCount(type));
+    for (unsigned i = 0; i < cellCount(type); ++i) {
+      emit(op, reg + i, operand + i);
+    }
+    return reg;
+  }
+  if (auto *call = dynamic_cast<const AST::FuncCallNode *>(node)) {
+    return compileCall(*call, dst);
+  }
+  if (auto *await = dynamic_cast<const AST::AwaitNode *>(node)) {
+    return compileAwait(*await, dst);
+  }
+  throw Error("unknown expression node type");
+}
+
+uint16_t BytecodeCompiler::compileBinaryOp(const AST::BinaryOpNode &node,
+                                           std::optional<uint16_t> dst) {
+  Token::Type tokenType = node.op().type;
+  if (tokenType == Token::Type::And || tokenType == Token::Type::Or) {
+    uint16_t reg = dst ? *dst : allocate(1);
+    compileExpr(node.left(), reg);
+    size_t toEnd = emit(
+        tokenType == Token::Type::And ? Op::JumpIfFalse : Op::JumpIfTrue, reg);
+    compileExpr(node.right(), reg);
+    patch(toEnd);
+    return reg;
+  }
+
+  Type operand = typeOf(node.left());
+  bool isFloat = elementType(operand) == Type::F32;
+  Op op;
+  switch (tokenType) {
+  case Token::Type::Plus:
+    op = isFloat ? Op::AddF : Op::AddI;
+    break;
+  case Token::Type::Minus:
+    op = isFloat ? Op::SubF : Op::SubI;
+    break;
+  case Token::Type::Multiply:
+    op = isFloat ? Op::MulF : Op::MulI;
+    break;
+  case Token::Type::Divide:
+    op = isFloat ? Op::DivF : Op::DivI;
+    break;
+  case Token::Type::Equal:
+    op = isFloat ? Op::EqF : Op::EqI;
+    break;
+  case Token::Type::NotEqual:
+    op = isFloat ? Op::NeF : Op::NeI;
+    break;
+  case Token::Type::Greater:
+    op = isFloat ? Op::GtF : Op::GtI;
+    break;
+  case Token::Type::GreaterEqual:
+    op = isFloat ? Op::GeF : Op::GeI;
+    break;
+  case Token::Type::Less:
+    op = isFloat ? Op::LtF : Op::LtI;
+    break;
+  case Token::Type::LessEqual:
+    op = isFloat ? Op::LeF : Op::LeI;
+    break;
+  default:
+    throw Error(std::format("unknown operator '{}'", node.op().value));
+  }
+
+  // Vector operators apply lane by lane; only scalars are compared.
+  uint16_t left = compileExpr(node.left());
+  uint16_t right = compileExpr(node.right());
+  unsigned lanes = laneCount(operand);
+  uint16_t reg = dst ? *dst : allocate(cellCount(typeOf(&node)));
+  for (unsigned i = 0; i < lanes; ++i) {
+    emit(op, reg + i, left + i, right + i);
+  }
+  return reg;
+}
+
+uint16_t BytecodeCompiler::compileCall(const AST::FuncCallNode &node,
+                                       std::optional<uint16_t> dst) {
+  const std::string &name = node.name().value;
+
+  if (std::optional<Type> type = analysis_->structType(name)) {
+    const StructInfo &info = analysis_->structInfo(*type);
+    std::vector<const AST::Node *> args = argsOf(node);
+    uint16_t reg = dst ? *dst : allocate(cellCount(*type));
+    unsigned offset = 0;
+    for (size_t i = 0; i < args.size(); ++i) {
+      compileExpr(args[i], reg + offset);
+      offset += cellCount(info.fields[i].type);
+    }
+    return reg;
+  }
+
+  std::optional<uint16_t> callee = userFunction(name);
+  if (node.name().type == Token::Type::Type ||
+      (!callee && SemanticAnalyzer::isBuiltinName(name))) {
+    return compileBuiltinCall(node, dst);
+  }
+  if (!callee) {
+    throw Error(std::format("undefined function '{}'", name));
+  }
+
+  uint16_t args = compileArgs(node, *callee);
+  uint16_t reg =
+      dst ? *dst : allocate(program_.functions[*callee].resultCells);
+  emit(Op::Call, reg, *callee, args);
+  return reg;
+}
+
+uint16_t BytecodeCompiler::compileArgs(const AST::FuncCallNode &node,
+                                       uint16_t function) {
+  std::vector<const AST::Node *> args = argsOf(node);
+  unsigned cells = 0;
+  for (const auto *arg : args) {
+    cells += cellCount(typeOf(arg));
+  }
+  if (cells != program_.functions[function].paramCells) {
+    throw Error(std::format("arguments of '{}' do not match its parameters",
+                            node.name().value));
+  }
+
+  uint16_t first = allocate(cells);
+  unsigned offset = 0;
+  for (const auto *arg : args) {
+    compileExpr(arg, first + offset);
+    offset += cellCount(typeOf(arg));
+  }
+  return first;
+}
+
+uint16_t BytecodeCompiler::compileBuiltinCall(const AST::FuncCallNode &node,
+                                              std::optional<uint16_t> dst) {
+  const std::string &name = node.name().value;
+  std::vector<const AST::Node *> args = argsOf(node);
+  Type type = typeOf(&node);
+
+  if (node.name().type == Token::Type::Type) {
+    unsigned lanes = laneCount(type);
+    uint16_t reg = dst ? *dst : allocate(lanes);
+    if (args.size() == 1) {
+      uint16_t value = compileExpr(args[0]);
+      for (unsigned i = 0; i < lanes; ++i) {
+        emitMove(reg + i, value, 1);
+      }
+    } else {
+      for (unsigned i = 0; i < lanes; ++i) {
+        compileExpr(args[i], reg + i);
+      }
+    }
+    return reg;
+  }
+
+  unsigned lanes = laneCount(typeOf(args[0]));
+  bool isFloat = elementType(typeOf(args[0])) == Type::F32;
+
+  if (name == "extract") {
+    uint16_t vector = compileExpr(args[0]);
+    if (std::optional<unsigned> lane = literalLane(args[1])) {
+      return place(vector + *lane, 1, dst);
+    }
+    uint16_t index = compileExpr(args[1]);
+    uint16_t reg = dst ? *dst : allocate(1);
+    emit(Op::Extract, reg, vector, index, lanes);
+    return reg;
+  }
+
+  if (name == "insert") {
+    uint16_t reg = dst ? *dst : allocate(lanes);
+    compileExpr(args[0], reg);
+    if (std::optional<unsigned> lane = literalLane(args[1])) {
+      compileExpr(args[2], reg + *lane);
+    } else {
+      uint16_t index = compileExpr(args[1]);
+      emit(Op::Insert, reg, index, compileExpr(args[2]), lanes);
+    }
+    return reg;
+  }
+
+  if (name == "shuffle") {
+    uint16_t first = compileExpr(args[0]);
+    uint16_t second = compileExpr(args[1]);
+    uint16_t reg = dst ? *dst : allocate(args.size() - 2);
+    for (size_t i = 2; i < args.size(); ++i) {
+      unsigned lane = *literalLane(args[i]);
+      emitMove(reg + i - 2, lane < lanes ? first + lane : second + lane - lanes,
+               1);
+    }
+    return reg;
+  }
+
+  // Lanes are combined left to right, which for reduce_add and reduce_mul
+  // is the order the native code keeps without fast-math flags.
+  Op op;
+  if (name == "reduce_add") {
+    op = isFloat ? Op::AddF : Op::AddI;
+  } else if (name == "reduce_mul") {
+    op = isFloat ? Op::MulF : Op::MulI;
+  } else if (name == "reduce_min") {
+    op = isFloat ? Op::MinF : Op::MinI;
+  } else if (name == "reduce_max") {
+    op = isFloat ? Op::MaxF : Op::MaxI;
+  } else {
+    throw Error(std::format("unknown builtin '{}'", name));
+  }
+  uint16_t vector = compileExpr(args[0]);
+  uint16_t reg = dst ? *dst : allocate(1);
+  emitMove(reg, vector, 1);
+  for (unsigned i = 1; i < lanes; ++i) {
+    emit(op, reg, reg, vector + i);
+  }
+  return reg;
+}
+
+// n marks awaits in synchronous code, which the VM resumes as soon as they
+// can continue, like ode_block_on does.
+uint16_t BytecodeCompiler::compileAwait(const AST::AwaitNode &node,
+                                        std::optional<uint16_t> dst) {
+  const auto &call = static_cast<const AST::FuncCallNode &>(*node.expr());
+  bool blocking = !function_->isAsync;
+
+  std::optional<uint16_t> callee = userFunction(call.name().value);
+  if (!callee && call.name().value == "sleep") {
+    uint16_t millis = compileExpr(argsOf(call)[0]);
+    emit(Op::Sleep, millis, 0, 0, blocking);
+    return allocate(0);
+  }
+
+  if (!callee) {
+    throw Error(std::format("undefined function '{}'", call.name().value));
+  }
+  uint16_t args = compileArgs(call, *callee);
+  uint16_t reg =
+      dst ? *dst : allocate(program_.functions[*callee].resultCells);
+  emit(Op::Await, reg, *callee, args, blocking);
+  return reg;
+}
@@ -0,0 +1,399 @@
+#include "Interpreter/VM.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "ode_runtime.h"
+
+// GCC and Clang jump straight from one handler to the next through a table
+// of label addresses, so every handler gets a branch of its own to predict.
+// Other compilers go back through the switch.
+#if defined(__GNUC__)
+#define ODE_THREADED_DISPATCH 1
+#endif
+
+VM::VM(Bytecode::Program program) : program_(std::move(program)) {}
+
+void VM::setNativeCode(NativeCode *native) {
+  native_ = native;
+  functionHeat_.assign(program_.functions.size(), {});
+  loopHeat_.assign(program_.loops.size(), {});
+}
+
+int32_t VM::run() {
+  main_ = createFiber(*program_.main, nullptr);
+  ready_.push_back(main_);
+
+  for (;;) {
+    fireTimers();
+    if (!ready_.empty()) {
+      Fiber *fiber = ready_.front();
+      ready_.pop_front();
+      execute(*fiber);
+    } else if (!timers_.empty()) {
+      std::this_thread::sleep_until(timers_.top().deadline);
+    } else {
+      return status_;
+    }
+  }
+}
+
+VM::Fiber *VM::createFiber(uint16_t function, const Cell *args) {
+  const Bytecode::Function &callee = program_.functions[function];
+  auto fiber = std::make_unique<Fiber>();
+  fiber->registers.resize(callee.registerCount);
+  if (callee.paramCells > 0) {
+    std::copy_n(args, callee.paramCells, fiber->registers.data());
+  }
+  fiber->frames.push_back({function, 0, 0, 0});
+
+  Fiber *handle = fiber.get();
+  fibers_.emplace(handle, std::move(fiber));
+  return handle;
+}
+
+// Synchronous code waits inside ode_block_on or ode_sleep, which return as
+// soon as what they wait for is done, before any other queued task runs.
+void VM::wake(Fiber *fiber) {
+  if (fiber->blocking) {
+    ready_.push_front(fiber);
+  } else {
+    ready_.push_back(fiber);
+  }
+}
+
+void VM::fireTimers() {
+  auto now = std::chrono::steady_clock::now();
+  while (!timers_.empty() && timers_.top().deadline <= now) {
+    Fiber *fiber = timers_.top().fiber;
+    timers_.pop();
+    wake(fiber);
+  }
+}
+
+void VM::finish(Fiber &fiber, const Cell *result) {
+  unsigned cells =
+      program_.functions[fiber.frames.back().function].resultCells;
+  if (Fiber *awaiter = fiber.awaiter) {
+    Cell *slot = awaiter->registers.data() + awaiter->frames.back().base +
+                 fiber.awaitResult;
+    std::copy_n(result, cells, slot);
+    wake(awaiter);
+  } else if (&fiber == main_) {
+    status_ = cells > 0 ? result->i : 0;
+  }
+  fibers_.erase(&fiber);
+}
+
+VM::NativeCode::Entry VM::warm(Heat &heat, bool loop, uint16_t index) {
+  if (heat.entry) {
+    return heat.entry;
+  }
+  if (heat.settled || ++heat.count < HOT_THRESHOLD) {
+    return nullptr;
+  }
+  if (!compileRequested_) {
+    native_->compile();
+    compileRequested_ = true;
+  }
+  if (!native_->ready()) {
+    return nullptr;
+  }
+  heat.settled = true;
+  heat.entry = loop ? native_->loop(index) : native_->function(index);
+  return heat.entry;
+}
+
+void VM::fail(const Frame &frame, const std::string &message) {
+  throw Error(std::format("{} in '{}'", message,
+                          program_.functions[frame.function].name));
+}
+
+void VM::execute(Fiber &fiber) {
+  using Instruction = Bytecode::Instruction;
+  using Op = Bytecode::Op;
+
+  Frame *frame;
+  const Bytecode::Function *function;
+  const Instruction *code;
+  const Instruction *ip;
+  Cell *r;
+  // Where the result is when the frame returns.
+  uint16_t resultBase = 0;
+
+  // Loads the innermost frame after a call, return or resume. Calls may
+  // grow the register stack, which moves it.
+  auto enter = [&] {
+    frame = &fiber.frames.back();
+    function = &program_.functions[frame->function];
+    code = function->code.data();
+    ip = code + frame->pc;
+    r = fiber.registers.data() + frame->base;
+  };
+  // Remembers where to resume before the fiber starts waiting.
+  auto suspend = [&] { frame->pc = static_cast<uint32_t>(ip + 1 - code); };
+
+  enter();
+
+#ifdef ODE_THREADED_DISPATCH
+  static const void *const handlers[] = {
+#define ODE_OPCODE_LABEL(name) &&op_##name,
+      ODE_OPCODES(ODE_OPCODE_LABEL)
+#undef ODE_OPCODE_LABEL
+  };
+#define DISPATCH() goto *handlers[static_cast<uint8_t>(ip->op)]
+#define HANDLER(name) op_##name
+#else
+#define DISPATCH() goto dispatch
+#define HANDLER(name) case Op::name
+#endif
+#define NEXT()                                                                 \
+  do {                                                                         \
+    ++ip;                                                                      \
+    DISPATCH();                                                                \
+  } while (0)
+
+// i32 arithmetic wraps, as in the native code.
+#define INT_OP(name, expr)                                                     \
+  HANDLER(name) : {                                                            \
+    uint32_t x = static_cast<uint32_t>(r[ip->b].i);                            \
+    uint32_t y = static_cast<uint32_t>(r[ip->c].i);                            \
+    r[ip->a].i = static_cast<int32_t>(expr);                                   \
+    NEXT();                                                                    \
+  }
+#define INT_CMP(name, op)                                                      \
+  HANDLER(name) : {                                                            \
+    r[ip->a].i = r[ip->b].i op r[ip->c].i;                                     \
+    NEXT();                                                                    \
+  }
+#define FLOAT_OP(name, expr)                                                   \
+  HANDLER(name) : {                                                            \
+    float x = r[ip->b].f;                                                      \
+    float y = r[ip->c].f;                                                      \
+    r[ip->a].f = (expr);                                                       \
+    NEXT();                                                                    \
+  }
+#define FLOAT_CMP(name, expr)                                                  \
+  HANDLER(name) : {                                                            \
+    float x = r[ip->b].f;                                                      \
+    float y = r[ip->c].f;                                                      \
+    r[ip->a].i = (expr);                                                       \
+    NEXT();                                                                    \
+  }
+
+  DISPATCH();
+#ifndef ODE_THREADED_DISPATCH
+dispatch:
+  switch (ip->op) {
+#endif
+
+  HANDLER(Move) : {
+    r[ip->a] = r[ip->b];
+    NEXT();
+  }
+  HANDLER(LoadImm) : {
+    r[ip->a].i = static_cast<int32_t>(ip->imm());
+    NEXT();
+  }
+
+  INT_OP(AddI, x + y)
+  INT_OP(SubI, x - y)
+  INT_OP(MulI, x * y)
+  HANDLER(DivI) : {
+    int32_t x = r[ip->b].i;
+    int32_t y = r[ip->c].i;
+    if (y == 0) {
+      fail(*frame, "division by zero");
+    }
+    if (x == INT32_MIN && y == -1) {
+      fail(*frame, "division overflow");
+    }
+    r[ip->a].i = x / y;
+    NEXT();
+  }
+  HANDLER(NegI) : {
+    r[ip->a].i =
+        static_cast<int32_t>(0u - static_cast<uint32_t>(r[ip->b].i));
+    NEXT();
+  }
+  INT_OP(MinI, std::min(static_cast<int32_t>(x), static_cast<int32_t>(y)))
+  INT_OP(MaxI, std::max(static_cast<int32_t>(x), static_cast<int32_t>(y)))
+
+  FLOAT_OP(AddF, x + y)
+  FLOAT_OP(SubF, x - y)
+  FLOAT_OP(MulF, x * y)
+  FLOAT_OP(DivF, x / y)
+  HANDLER(NegF) : {
+    r[ip->a].f = -r[ip->b].f;
+    NEXT();
+  }
+  // llvm.minnum and llvm.maxnum: a NaN operand yields the other one.
+  FLOAT_OP(MinF, std::fmin(x, y))
+  FLOAT_OP(MaxF, std::fmax(x, y))
+
+  INT_CMP(EqI, ==)
+  INT_CMP(NeI, !=)
+  INT_CMP(LtI, <)
+  INT_CMP(LeI, <=)
+  INT_CMP(GtI, >)
+  INT_CMP(GeI, >=)
+
+  // Ordered comparisons: any NaN operand makes them false.
+  FLOAT_CMP(EqF, x == y)
+  FLOAT_CMP(NeF, x < y || x > y)
+  FLOAT_CMP(LtF, x < y)
+  FLOAT_CMP(LeF, x <= y)
+  FLOAT_CMP(GtF, x > y)
+  FLOAT_CMP(GeF, x >= y)
+
+  HANDLER(Not) : {
+    r[ip->a].i = !r[ip->b].i;
+    NEXT();
+  }
+
+  HANDLER(Jump) : {
+    ip = code + ip->imm();
+    DISPATCH();
+  }
+  // A native loop entry finishes the whole call, so the frame returns.
+  HANDLER(Loop) : {
+    if (native_) {
+      if (NativeCode::Entry entry = warm(loopHeat_[ip->a], true, ip->a)) {
+        entry(r, r);
+        resultBase = 0;
+        goto leave;
+      }
+    }
+    ip = code + ip->imm();
+    DISPATCH();
+  }
+  HANDLER(JumpIfFalse) : {
+    ip = r[ip->a].i ? ip + 1 : code + ip->imm();
+    DISPATCH();
+  }
+  HANDLER(JumpIfTrue) : {
+    ip = r[ip->a].i ? code + ip->imm() : ip + 1;
+    DISPATCH();
+  }
+
+  // Lane counts are powers of two, and an index out of range wraps around,
+  // as in compiled code.
+  HANDLER(Extract) : {
+    uint32_t lane = static_cast<uint32_t>(r[ip->c].i) & (ip->n - 1u);
+    r[ip->a] = r[ip->b + lane];
+    NEXT();
+  }
+  HANDLER(Insert) : {
+    uint32_t lane = static_cast<uint32_t>(r[ip->b].i) & (ip->n - 1u);
+    r[ip->a + lane] = r[ip->c];
+    NEXT();
+  }
+
+  HANDLER(Call) : {
+    if (native_) {
+      if (NativeCode::Entry entry = warm(functionHeat_[ip->b], false, ip->b)) {
+        entry(r + ip->c, r + ip->a);
+        NEXT();
+      }
+    }
+    if (fiber.frames.size() == MAX_FRAMES) {
+      fail(*frame, "stack overflow");
+    }
+    const Bytecode::Function &callee = program_.functions[ip->b];
+    size_t base = frame->base + function->registerCount;
+    size_t args = frame->base + ip->c;
+    frame->pc = static_cast<uint32_t>(ip + 1 - code);
+    fiber.frames.push_back({ip->b, base, 0, ip->a});
+    fiber.registers.resize(base + callee.registerCount);
+    std::copy_n(fiber.registers.data() + args, callee.paramCells,
+                fiber.registers.data() + base);
+    enter();
+    DISPATCH();
+  }
+  HANDLER(TailCall) : {
+    if (native_) {
+      if (NativeCode::Entry entry = warm(functionHeat_[ip->b], false, ip->b)) {
+        entry(r + ip->c, r);
+        resultBase = 0;
+        goto leave;
+      }
+    }
+    const Bytecode::Function &callee = program_.functions[ip->b];
+    std::memmove(r, r + ip->c, callee.paramCells * sizeof(Cell));
+    frame->function = ip->b;
+    frame->pc = 0;
+    fiber.registers.resize(frame->base + callee.registerCount);
+    enter();
+    DISPATCH();
+  }
+  HANDLER(Return) : {
+    resultBase = ip->a;
+    goto leave;
+  }
+
+  HANDLER(PrintI) : {
+    ode_print_i32(r[ip->a].i);
+    NEXT();
+  }
+  HANDLER(PrintF) : {
+    ode_print_f32(r[ip->a].f);
+    NEXT();
+  }
+  HANDLER(PrintB) : {
+    ode_print_bool(r[ip->a].i != 0);
+    NEXT();
+  }
+
+  // Tasks start from the back of the queue, like ode_coro_schedule.
+  HANDLER(Await) : {
+    Fiber *task = createFiber(ip->b, r + ip->c);
+    task->awaiter = &fiber;
+    task->awaitResult = ip->a;
+    fiber.blocking = ip->n != 0;
+    ready_.push_back(task);
+    suspend();
+    return;
+  }
+  HANDLER(Spawn) : {
+    ready_.push_back(createFiber(ip->b, r + ip->c));
+    NEXT();
+  }
+  HANDLER(Sleep) : {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(std::max(r[ip->a].i, 0));
+    timers_.push({deadline, timerSequence_++, &fiber});
+    fiber.blocking = ip->n != 0;
+    suspend();
+    return;
+  }
+
+leave: {
+  if (fiber.frames.size() == 1) {
+    finish(fiber, r + resultBase);
+    return;
+  }
+  size_t base = frame->base;
+  size_t result = base + resultBase;
+  uint16_t slot = frame->result;
+  fiber.frames.pop_back();
+  std::copy_n(fiber.registers.data() + result, function->resultCells,
+              fiber.registers.data() + fiber.frames.back().base + slot);
+  fiber.registers.resize(base);
+  enter();
+  DISPATCH();
+}
+
+#ifndef ODE_THREADED_DISPATCH
+  }
+#endif
+
+#undef FLOAT_CMP
+#undef FLOAT_OP
+#undef INT_CMP
+#undef INT_OP
+#undef NEXT
+#undef HANDLER
+#undef DISPATCH
+}
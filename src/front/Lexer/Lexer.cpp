@@ -13,6 +13,7 @@ std::vector<Token> Lexer::tokenize() {
     if (scanner.isAtEnd())
       break;
 
+    SourceLocation location = scanner.location();
     std::optional<Token> token;
 
     if (auto t = builder.tryIdentifier()) {
@@ -26,6 +27,7 @@ std::vector<Token> Lexer::tokenize() {
     }
 
     if (token) {
+      token->location = location;
       lastType = token->type;
       tokens.push_back(std::move(*token));
     }
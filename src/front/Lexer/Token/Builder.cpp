@@ -41,9 +41,12 @@ std::optional<Token> Token::Builder::tryNumber(Token::Type lastType) {
 
   size_t start = scanner_.position();
 
+  // A '.' only continues the number when a digit follows, so that ranges
+  // such as 0..n lex as NUMBER DOTDOT IDENT.
   while (!scanner_.isAtEnd() &&
          (std::isdigit(static_cast<unsigned char>(scanner_.peek())) ||
-          scanner_.peek() == '.')) {
+          (scanner_.peek() == '.' &&
+           std::isdigit(static_cast<unsigned char>(scanner_.peek(1)))))) {
     scanner_.consume();
   }
 
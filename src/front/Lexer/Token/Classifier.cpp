@@ -3,24 +3,33 @@
 
 const Token::TokenTypeMap &Token::Classifier::getTokenMap() {
   static const Token::TokenTypeMap tokens = {
-      {"let", Token::Type::Let},         {"while", Token::Type::While},
-      {"fn", Token::Type::Fn},           {"if", Token::Type::If},
-      {"else", Token::Type::Else},       {"return", Token::Type::Return},
-      {"print", Token::Type::Print},     {"true", Token::Type::Boolean},
-      {"false", Token::Type::Boolean},   {"i32", Token::Type::Type},
-      {"f32", Token::Type::Type},        {"bool", Token::Type::Type},
-      {"void", Token::Type::Type},       {"char", Token::Type::Type},
-      {"=", Token::Type::Assign},        {"==", Token::Type::Equal},
-      {"!=", Token::Type::NotEqual},     {"<", Token::Type::Less},
-      {"<=", Token::Type::LessEqual},    {">", Token::Type::Greater},
-      {">=", Token::Type::GreaterEqual}, {"+", Token::Type::Plus},
-      {"-", Token::Type::Minus},         {"*", Token::Type::Multiply},
-      {"/", Token::Type::Divide},        {"||", Token::Type::Or},
-      {"&&", Token::Type::And},          {"(", Token::Type::LParen},
-      {")", Token::Type::RParen},        {"{", Token::Type::LBrace},
-      {"}", Token::Type::RBrace},        {";", Token::Type::Semicolon},
-      {",", Token::Type::Comma},         {":", Token::Type::Colon},
-      {"\"", Token::Type::DoubleQuotes}, {"!", Token::Type::Not}};
+      {"let", Token::Type::Let},           {"while", Token::Type::While},
+      {"fn", Token::Type::Fn},             {"if", Token::Type::If},
+      {"else", Token::Type::Else},         {"return", Token::Type::Return},
+      {"print", Token::Type::Print},       {"tail", Token::Type::Tail},
+      {"parallel", Token::Type::Parallel}, {"for", Token::Type::For},
+      {"in", Token::Type::In},             {"reduce", Token::Type::Reduce},
+      {"async", Token::Type::Async},       {"await", Token::Type::Await},
+      {"spawn", Token::Type::Spawn},       {"struct", Token::Type::Struct},
+      {"import", Token::Type::Import},     {"const", Token::Type::Const},
+      {"true", Token::Type::Boolean},      {"false", Token::Type::Boolean},
+      {"i32", Token::Type::Type},          {"f32", Token::Type::Type},
+      {"bool", Token::Type::Type},         {"void", Token::Type::Type},
+      {"char", Token::Type::Type},         {"v4f32", Token::Type::Type},
+      {"v8f32", Token::Type::Type},        {"v4i32", Token::Type::Type},
+      {"v8i32", Token::Type::Type},        {"=", Token::Type::Assign},
+      {"==", Token::Type::Equal},          {"!=", Token::Type::NotEqual},
+      {"<", Token::Type::Less},            {"<=", Token::Type::LessEqual},
+      {">", Token::Type::Greater},         {">=", Token::Type::GreaterEqual},
+      {"+", Token::Type::Plus},            {"-", Token::Type::Minus},
+      {"*", Token::Type::Multiply},        {"/", Token::Type::Divide},
+      {"||", Token::Type::Or},             {"&&", Token::Type::And},
+      {"(", Token::Type::LParen},          {")", Token::Type::RParen},
+      {"{", Token::Type::LBrace},          {"}", Token::Type::RBrace},
+      {";", Token::Type::Semicolon},       {",", Token::Type::Comma},
+      {":", Token::Type::Colon},           {"..", Token::Type::DotDot},
+      {".", Token::Type::Dot},             {"@", Token::Type::At},
+      {"\"", Token::Type::DoubleQuotes},   {"!", Token::Type::Not}};
 
   return tokens;
 }
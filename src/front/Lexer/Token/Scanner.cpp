@@ -7,12 +7,26 @@ char Token::Scanner::peek(size_t offset) const {
 }
 
 char Token::Scanner::consume() {
-  return pos_ < source_.length() ? source_[pos_++] : '\0';
+  if (pos_ >= source_.length()) {
+    return '\0';
+  }
+  char c = source_[pos_];
+  advance();
+  return c;
 }
 
 void Token::Scanner::skipWhitespace() {
   while (pos_ < source_.length() &&
          std::isspace(static_cast<unsigned char>(source_[pos_]))) {
-    ++pos_;
+    advance();
+  }
+}
+
+void Token::Scanner::advance() {
+  if (source_[pos_++] == '\n') {
+    ++line_;
+    column_ = 1;
+  } else {
+    ++column_;
   }
 }
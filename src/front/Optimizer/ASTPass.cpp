@@ -0,0 +1,125 @@
+#include "Optimizer/ASTPass.hpp"
+#include "Optimizer/Passes.hpp"
+
+#include <cmath>
+#include <format>
+
+void ASTPass::forEachChild(AST::Node &node, const SlotCallback &callback) {
+  auto visitSlot = [&callback](AST::NodePtr &slot) {
+    if (slot) {
+      callback(slot);
+    }
+  };
+
+  if (auto *program = dynamic_cast<AST::ProgramNode *>(&node)) {
+    for (auto &stmt : program->statements()) {
+      visitSlot(stmt);
+    }
+  } else if (auto *block = dynamic_cast<AST::BlockNode *>(&node)) {
+    for (auto &stmt : block->statements()) {
+      visitSlot(stmt);
+    }
+  } else if (auto *varDecl = dynamic_cast<AST::VarDeclNode *>(&node)) {
+    visitSlot(varDecl->exprSlot());
+  } else if (auto *assign = dynamic_cast<AST::AssignNode *>(&node)) {
+    visitSlot(assign->exprSlot());
+  } else if (auto *ifStmt = dynamic_cast<AST::IfStmtNode *>(&node)) {
+    visitSlot(ifStmt->conditionSlot());
+    visitSlot(ifStmt->thenBlockSlot());
+    visitSlot(ifStmt->elseBlockSlot());
+  } else if (auto *whileStmt = dynamic_cast<AST::WhileStmtNode *>(&node)) {
+    visitSlot(whileStmt->conditionSlot());
+    visitSlot(whileStmt->bodySlot());
+  } else if (auto *loop = dynamic_cast<AST::ParallelForNode *>(&node)) {
+    visitSlot(loop->beginSlot());
+    visitSlot(loop->endSlot());
+    visitSlot(loop->bodySlot());
+  } else if (auto *func = dynamic_cast<AST::FuncDeclNode *>(&node)) {
+    visitSlot(func->bodySlot());
+  } else if (auto *call = dynamic_cast<AST::FuncCallNode *>(&node)) {
+    visitSlot(call->argsSlot());
+  } else if (auto *ret = dynamic_cast<AST::ReturnStmtNode *>(&node)) {
+    visitSlot(ret->exprSlot());
+  } else if (auto *print = dynamic_cast<AST::PrintStmtNode *>(&node)) {
+    visitSlot(print->exprSlot());
+  } else if (auto *spawn = dynamic_cast<AST::SpawnStmtNode *>(&node)) {
+    visitSlot(spawn->callSlot());
+  } else if (auto *exprStmt = dynamic_cast<AST::ExprStmtNode *>(&node)) {
+    visitSlot(exprStmt->exprSlot());
+  } else if (auto *binOp = dynamic_cast<AST::BinaryOpNode *>(&node)) {
+    visitSlot(binOp->leftSlot());
+    visitSlot(binOp->rightSlot());
+  } else if (auto *unaryOp = dynamic_cast<AST::UnaryOpNode *>(&node)) {
+    visitSlot(unaryOp->operandSlot());
+  } else if (auto *await = dynamic_cast<AST::AwaitNode *>(&node)) {
+    visitSlot(await->exprSlot());
+  } else if (auto *access = dynamic_cast<AST::FieldAccessNode *>(&node)) {
+    visitSlot(access->objectSlot());
+  } else if (auto *args = dynamic_cast<AST::ArgListNode *>(&node)) {
+    for (auto &arg : args->args()) {
+      visitSlot(arg);
+    }
+  }
+}
+
+bool ASTPass::isLiteral(const AST::Node *node) {
+  return dynamic_cast<const AST::NumberNode *>(node) ||
+         dynamic_cast<const AST::BooleanNode *>(node);
+}
+
+AST::NodePtr ASTPass::cloneLiteral(const AST::Node *node) {
+  if (auto *num = dynamic_cast<const AST::NumberNode *>(node)) {
+    return std::make_unique<AST::NumberNode>(num->value());
+  }
+  if (auto *boolean = dynamic_cast<const AST::BooleanNode *>(node)) {
+    return std::make_unique<AST::BooleanNode>(boolean->value());
+  }
+  return nullptr;
+}
+
+std::optional<std::string> ASTPass::formatFloat(float value) {
+  if (!std::isfinite(value)) {
+    return std::nullopt;
+  }
+
+  // Number literals are typed by the presence of a '.', so the folded text
+  // must keep one; exponent forms have no literal syntax and stay unfolded.
+  std::string text = std::format("{}", value);
+  if (text.find('e') != std::string::npos) {
+    return std::nullopt;
+  }
+  if (text.find('.') == std::string::npos) {
+    text += ".0";
+  }
+  return text;
+}
+
+void ASTPassManager::addPass(std::unique_ptr<ASTPass> pass) {
+  passes_.push_back(std::move(pass));
+}
+
+void ASTPassManager::run(AST::Node &root) {
+  auto *program = dynamic_cast<AST::ProgramNode *>(&root);
+  if (!program) {
+    return;
+  }
+
+  for (int i = 0; i < MAX_ITERATIONS; ++i) {
+    bool changed = false;
+    for (auto &pass : passes_) {
+      changed |= pass->run(*program);
+    }
+    if (!changed) {
+      break;
+    }
+  }
+}
+
+ASTPassManager ASTPassManager::createDefault() {
+  ASTPassManager manager;
+  manager.addPass(std::make_unique<ConstantFoldingPass>());
+  manager.addPass(std::make_unique<ConstantPropagationPass>());
+  manager.addPass(std::make_unique<ConstEvaluationPass>());
+  manager.addPass(std::make_unique<DeadBranchEliminationPass>());
+  return manager;
+}
@@ -0,0 +1,104 @@
+#include "Optimizer/Passes.hpp"
+
+#include <bit>
+#include <format>
+
+bool ConstEvaluationPass::run(AST::ProgramNode &program) {
+  changed_ = false;
+
+  // The analyzer only accepts const fn at the top level.
+  functions_.clear();
+  for (const auto &stmt : program.statements()) {
+    auto *func = dynamic_cast<const AST::FuncDeclNode *>(stmt.get());
+    if (func && func->isConst()) {
+      functions_[func->name().value] = func;
+    }
+  }
+  if (functions_.empty()) {
+    return false;
+  }
+
+  forEachChild(program, [this](AST::NodePtr &slot) { evaluate(slot); });
+  return changed_;
+}
+
+// Floats are keyed by their bits, so that 0.0 and -0.0 stay apart.
+std::string
+ConstEvaluationPass::callKey(const std::string &name,
+                             const std::vector<ConstEvaluator::Value> &args) {
+  std::string key = name;
+  for (const auto &arg : args) {
+    switch (arg.kind) {
+    case ConstEvaluator::Value::Kind::I32:
+      key += std::format(" i{}", arg.i32);
+      break;
+    case ConstEvaluator::Value::Kind::F32:
+      key += std::format(" f{:x}", std::bit_cast<uint32_t>(arg.f32));
+      break;
+    case ConstEvaluator::Value::Kind::Bool:
+      key += arg.boolean ? " true" : " false";
+      break;
+    }
+  }
+  return key;
+}
+
+// Arguments are evaluated first, so nested calls such as f(g(1)) fold from
+// the inside out in a single run.
+void ConstEvaluationPass::evaluate(AST::NodePtr &slot) {
+  forEachChild(*slot, [this](AST::NodePtr &child) { evaluate(child); });
+
+  auto *call = dynamic_cast<AST::FuncCallNode *>(slot.get());
+  if (!call || !functions_.contains(call->name().value)) {
+    return;
+  }
+
+  std::vector<ConstEvaluator::Value> args;
+  if (auto *argList = dynamic_cast<const AST::ArgListNode *>(call->args())) {
+    for (const auto &arg : argList->args()) {
+      std::optional<ConstEvaluator::Value> value =
+          ConstEvaluator::readLiteral(arg.get());
+      if (!value) {
+        return;
+      }
+      args.push_back(*value);
+    }
+  }
+
+  std::string key = callKey(call->name().value, args);
+  auto cached = results_.find(key);
+  if (cached == results_.end()) {
+    ConstEvaluator evaluator(functions_);
+    cached =
+        results_.emplace(key, evaluator.call(call->name().value, args)).first;
+  }
+  const std::optional<ConstEvaluator::Value> &result = cached->second;
+  if (!result) {
+    return;
+  }
+
+  AST::NodePtr literal;
+  switch (result->kind) {
+  case ConstEvaluator::Value::Kind::I32:
+    literal = std::make_unique<AST::NumberNode>(
+        Token{Token::Type::Number, std::to_string(result->i32)});
+    break;
+  case ConstEvaluator::Value::Kind::F32:
+    if (std::optional<std::string> text = formatFloat(result->f32)) {
+      literal = std::make_unique<AST::NumberNode>(
+          Token{Token::Type::Number, std::move(*text)});
+    }
+    break;
+  case ConstEvaluator::Value::Kind::Bool:
+    literal = std::make_unique<AST::BooleanNode>(
+        Token{Token::Type::Boolean, result->boolean ? "true" : "false"});
+    break;
+  }
+  if (!literal) {
+    return;
+  }
+
+  literal->setLocation(slot->location());
+  slot = std::move(literal);
+  changed_ = true;
+}
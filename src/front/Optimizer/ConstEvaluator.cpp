@@ -0,0 +1,298 @@
+#include "Optimizer/ConstEvaluator.hpp"
+
+#include <climits>
+#include <utility>
+
+using Value = ConstEvaluator::Value;
+using Kind = Value::Kind;
+
+std::optional<Value> ConstEvaluator::readLiteral(const AST::Node *node) {
+  if (auto *num = dynamic_cast<const AST::NumberNode *>(node)) {
+    const std::string &text = num->value().value;
+    if (text.find('.') != std::string::npos) {
+      return Value{Kind::F32, 0, std::stof(text)};
+    }
+    return Value{Kind::I32, static_cast<int32_t>(std::stoll(text))};
+  }
+  if (auto *boolean = dynamic_cast<const AST::BooleanNode *>(node)) {
+    return Value{Kind::Bool, 0, 0.0f, boolean->value().value == "true"};
+  }
+  return std::nullopt;
+}
+
+static Kind kindOf(const AST::Node *typeNode) {
+  const std::string &name =
+      static_cast<const AST::TypeNode *>(typeNode)->type().value;
+  if (name == "i32") {
+    return Kind::I32;
+  }
+  return name == "f32" ? Kind::F32 : Kind::Bool;
+}
+
+std::optional<Value> ConstEvaluator::call(const std::string &name,
+                                          const std::vector<Value> &args) {
+  steps_ = 0;
+  depth_ = 0;
+  scopes_.clear();
+  result_.reset();
+  try {
+    return invoke(name, args);
+  } catch (const Unevaluable &) {
+    return std::nullopt;
+  }
+}
+
+void ConstEvaluator::step() {
+  if (++steps_ > MAX_STEPS) {
+    throw Unevaluable{};
+  }
+}
+
+// Argument and result kinds are checked here because the analyzer does not
+// check them against the signature yet.
+Value ConstEvaluator::invoke(const std::string &name,
+                             const std::vector<Value> &args) {
+  auto it = functions_.find(name);
+  if (it == functions_.end() || depth_ == MAX_DEPTH) {
+    throw Unevaluable{};
+  }
+  const AST::FuncDeclNode &func = *it->second;
+  const auto &params =
+      static_cast<const AST::ParamListNode *>(func.params())->params();
+  if (params.size() != args.size()) {
+    throw Unevaluable{};
+  }
+
+  Scope frame;
+  for (size_t i = 0; i < args.size(); ++i) {
+    if (args[i].kind != kindOf(params[i].type.get())) {
+      throw Unevaluable{};
+    }
+    frame[params[i].name.value] = args[i];
+  }
+
+  std::vector<Scope> callerScopes = std::exchange(scopes_, {std::move(frame)});
+  ++depth_;
+  bool returned = exec(func.body());
+  --depth_;
+  scopes_ = std::move(callerScopes);
+
+  // Falling off the end of a function leaves its result undefined.
+  if (!returned || result_->kind != kindOf(func.returnType())) {
+    throw Unevaluable{};
+  }
+  return *std::exchange(result_, std::nullopt);
+}
+
+Value *ConstEvaluator::lookup(const std::string &name) {
+  for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+    auto it = scope->find(name);
+    if (it != scope->end()) {
+      return &it->second;
+    }
+  }
+  throw Unevaluable{};
+}
+
+bool ConstEvaluator::exec(const AST::Node *node) {
+  step();
+
+  if (auto *block = dynamic_cast<const AST::BlockNode *>(node)) {
+    scopes_.emplace_back();
+    bool returned = false;
+    for (const auto &stmt : block->statements()) {
+      if ((returned = exec(stmt.get()))) {
+        break;
+      }
+    }
+    scopes_.pop_back();
+    return returned;
+  }
+  if (auto *varDecl = dynamic_cast<const AST::VarDeclNode *>(node)) {
+    scopes_.back()[varDecl->name().value] = eval(varDecl->expr());
+    return false;
+  }
+  if (auto *assign = dynamic_cast<const AST::AssignNode *>(node)) {
+    if (!assign->fields().empty()) {
+      throw Unevaluable{};
+    }
+    Value value = eval(assign->expr());
+    *lookup(assign->name().value) = value;
+    return false;
+  }
+  if (auto *ifStmt = dynamic_cast<const AST::IfStmtNode *>(node)) {
+    if (eval(ifStmt->condition()).boolean) {
+      return exec(ifStmt->thenBlock());
+    }
+    return ifStmt->hasElse() && exec(ifStmt->elseBlock());
+  }
+  if (auto *whileStmt = dynamic_cast<const AST::WhileStmtNode *>(node)) {
+    while (eval(whileStmt->condition()).boolean) {
+      if (exec(whileStmt->body())) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (auto *ret = dynamic_cast<const AST::ReturnStmtNode *>(node)) {
+    if (!ret->expr()) {
+      throw Unevaluable{};
+    }
+    result_ = eval(ret->expr());
+    return true;
+  }
+  if (auto *exprStmt = dynamic_cast<const AST::ExprStmtNode *>(node)) {
+    eval(exprStmt->expr());
+    return false;
+  }
+  throw Unevaluable{};
+}
+
+Value ConstEvaluator::eval(const AST::Node *node) {
+  step();
+
+  if (std::optional<Value> literal = readLiteral(node)) {
+    return *literal;
+  }
+  if (auto *ident = dynamic_cast<const AST::IdentifierNode *>(node)) {
+    return *lookup(ident->name().value);
+  }
+  if (auto *binOp = dynamic_cast<const AST::BinaryOpNode *>(node)) {
+    return evalBinaryOp(*binOp);
+  }
+  if (auto *unaryOp = dynamic_cast<const AST::UnaryOpNode *>(node)) {
+    return evalUnaryOp(*unaryOp);
+  }
+  if (auto *call = dynamic_cast<const AST::FuncCallNode *>(node)) {
+    std::vector<Value> args;
+    if (auto *argList = dynamic_cast<const AST::ArgListNode *>(call->args())) {
+      for (const auto &arg : argList->args()) {
+        args.push_back(eval(arg.get()));
+      }
+    }
+    return invoke(call->name().value, args);
+  }
+  throw Unevaluable{};
+}
+
+// Matches the code IRGenerator emits for each operator: i32 arithmetic
+// wraps, and comparisons of f32 are ordered, so any NaN operand makes them
+// false.
+Value ConstEvaluator::evalBinaryOp(const AST::BinaryOpNode &node) {
+  Token::Type op = node.op().type;
+
+  Value left = eval(node.left());
+  if (op == Token::Type::And || op == Token::Type::Or) {
+    if (left.boolean == (op == Token::Type::Or)) {
+      return left;
+    }
+    return eval(node.right());
+  }
+  Value right = eval(node.right());
+  if (left.kind != right.kind) {
+    throw Unevaluable{};
+  }
+
+  auto makeBool = [](bool value) {
+    return Value{Kind::Bool, 0, 0.0f, value};
+  };
+
+  if (left.kind == Kind::Bool) {
+    switch (op) {
+    case Token::Type::Equal:
+      return makeBool(left.boolean == right.boolean);
+    case Token::Type::NotEqual:
+      return makeBool(left.boolean != right.boolean);
+    default:
+      throw Unevaluable{};
+    }
+  }
+
+  if (left.kind == Kind::I32) {
+    int32_t l = left.i32;
+    int32_t r = right.i32;
+    uint32_t ul = static_cast<uint32_t>(l);
+    uint32_t ur = static_cast<uint32_t>(r);
+    auto makeI32 = [](uint32_t value) {
+      return Value{Kind::I32, static_cast<int32_t>(value)};
+    };
+    switch (op) {
+    case Token::Type::Plus:
+      return makeI32(ul + ur);
+    case Token::Type::Minus:
+      return makeI32(ul - ur);
+    case Token::Type::Multiply:
+      return makeI32(ul * ur);
+    case Token::Type::Divide:
+      // These trap at run time.
+      if (r == 0 || (l == INT32_MIN && r == -1)) {
+        throw Unevaluable{};
+      }
+      return Value{Kind::I32, l / r};
+    case Token::Type::Equal:
+      return makeBool(l == r);
+    case Token::Type::NotEqual:
+      return makeBool(l != r);
+    case Token::Type::Greater:
+      return makeBool(l > r);
+    case Token::Type::GreaterEqual:
+      return makeBool(l >= r);
+    case Token::Type::Less:
+      return makeBool(l < r);
+    case Token::Type::LessEqual:
+      return makeBool(l <= r);
+    default:
+      throw Unevaluable{};
+    }
+  }
+
+  float l = left.f32;
+  float r = right.f32;
+  auto makeF32 = [](float value) { return Value{Kind::F32, 0, value}; };
+  switch (op) {
+  case Token::Type::Plus:
+    return makeF32(l + r);
+  case Token::Type::Minus:
+    return makeF32(l - r);
+  case Token::Type::Multiply:
+    return makeF32(l * r);
+  case Token::Type::Divide:
+    return makeF32(l / r);
+  case Token::Type::Equal:
+    return makeBool(l == r);
+  case Token::Type::NotEqual:
+    return makeBool(l < r || l > r);
+  case Token::Type::Greater:
+    return makeBool(l > r);
+  case Token::Type::GreaterEqual:
+    return makeBool(l >= r);
+  case Token::Type::Less:
+    return makeBool(l < r);
+  case Token::Type::LessEqual:
+    return makeBool(l <= r);
+  default:
+    throw Unevaluable{};
+  }
+}
+
+Value ConstEvaluator::evalUnaryOp(const AST::UnaryOpNode &node) {
+  Value operand = eval(node.operand());
+  switch (node.op().type) {
+  case Token::Type::Minus:
+    if (operand.kind == Kind::I32) {
+      return Value{Kind::I32, static_cast<int32_t>(
+                                  0u - static_cast<uint32_t>(operand.i32))};
+    }
+    if (operand.kind == Kind::F32) {
+      return Value{Kind::F32, 0, -operand.f32};
+    }
+    throw Unevaluable{};
+  case Token::Type::Not:
+    if (operand.kind == Kind::Bool) {
+      return Value{Kind::Bool, 0, 0.0f, !operand.boolean};
+    }
+    throw Unevaluable{};
+  default:
+    throw Unevaluable{};
+  }
+}
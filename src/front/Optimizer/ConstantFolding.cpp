@@ -0,0 +1,215 @@
+#include "Optimizer/Passes.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <format>
+
+struct Literal {
+  enum class Kind { I32, F32, Bool };
+
+  Kind kind;
+  int32_t i32 = 0;
+  float f32 = 0.0f;
+  bool boolean = false;
+};
+
+static std::optional<Literal> readLiteral(const AST::Node *node) {
+  if (auto *num = dynamic_cast<const AST::NumberNode *>(node)) {
+    const std::string &text = num->value().value;
+    if (text.find('.') != std::string::npos) {
+      return Literal{Literal::Kind::F32, 0, std::stof(text), false};
+    }
+    return Literal{Literal::Kind::I32, static_cast<int32_t>(std::stoll(text)),
+                   0.0f, false};
+  }
+  if (auto *boolean = dynamic_cast<const AST::BooleanNode *>(node)) {
+    return Literal{Literal::Kind::Bool, 0, 0.0f,
+                   boolean->value().value == "true"};
+  }
+  return std::nullopt;
+}
+
+static AST::NodePtr makeBool(bool value) {
+  return std::make_unique<AST::BooleanNode>(
+      Token{Token::Type::Boolean, value ? "true" : "false"});
+}
+
+static AST::NodePtr makeI32(int32_t value) {
+  return std::make_unique<AST::NumberNode>(
+      Token{Token::Type::Number, std::to_string(value)});
+}
+
+bool ConstantFoldingPass::run(AST::ProgramNode &program) {
+  changed_ = false;
+  forEachChild(program, [this](AST::NodePtr &slot) { fold(slot); });
+  return changed_;
+}
+
+void ConstantFoldingPass::fold(AST::NodePtr &slot) {
+  forEachChild(*slot, [this](AST::NodePtr &child) { fold(child); });
+
+  AST::NodePtr folded;
+  if (auto *binOp = dynamic_cast<AST::BinaryOpNode *>(slot.get())) {
+    folded = foldBinaryOp(*binOp);
+  } else if (auto *unaryOp = dynamic_cast<AST::UnaryOpNode *>(slot.get())) {
+    folded = foldUnaryOp(*unaryOp);
+  }
+
+  if (folded) {
+    folded->setLocation(slot->location());
+    slot = std::move(folded);
+    changed_ = true;
+  }
+}
+
+AST::NodePtr ConstantFoldingPass::foldBinaryOp(AST::BinaryOpNode &node) {
+  auto left = readLiteral(node.left());
+  auto right = readLiteral(node.right());
+  Token::Type op = node.op().type;
+
+  // '&&' and '||' short-circuit, so a known left operand either decides the
+  // result on its own or reduces the expression to the right operand.
+  if (left && left->kind == Literal::Kind::Bool &&
+      (op == Token::Type::And || op == Token::Type::Or)) {
+    bool decides = (op == Token::Type::And) != left->boolean;
+    if (decides) {
+      return makeBool(left->boolean);
+    }
+    return std::move(node.rightSlot());
+  }
+
+  if (!left || !right || left->kind != right->kind) {
+    return nullptr;
+  }
+
+  switch (left->kind) {
+  case Literal::Kind::Bool: {
+    bool l = left->boolean;
+    bool r = right->boolean;
+    switch (op) {
+    case Token::Type::And:
+      return makeBool(l && r);
+    case Token::Type::Or:
+      return makeBool(l || r);
+    case Token::Type::Equal:
+      return makeBool(l == r);
+    case Token::Type::NotEqual:
+      return makeBool(l != r);
+    default:
+      return nullptr;
+    }
+  }
+
+  case Literal::Kind::I32: {
+    int32_t l = left->i32;
+    int32_t r = right->i32;
+    // i32 arithmetic wraps, so fold through uint32_t to keep it defined.
+    uint32_t ul = static_cast<uint32_t>(l);
+    uint32_t ur = static_cast<uint32_t>(r);
+    switch (op) {
+    case Token::Type::Plus:
+      return makeI32(static_cast<int32_t>(ul + ur));
+    case Token::Type::Minus:
+      return makeI32(static_cast<int32_t>(ul - ur));
+    case Token::Type::Multiply:
+      return makeI32(static_cast<int32_t>(ul * ur));
+    case Token::Type::Divide:
+      // Leave trapping divisions for the runtime to report.
+      if (r == 0 || (l == INT32_MIN && r == -1)) {
+        return nullptr;
+      }
+      return makeI32(l / r);
+    case Token::Type::Equal:
+      return makeBool(l == r);
+    case Token::Type::NotEqual:
+      return makeBool(l != r);
+    case Token::Type::Greater:
+      return makeBool(l > r);
+    case Token::Type::GreaterEqual:
+      return makeBool(l >= r);
+    case Token::Type::Less:
+      return makeBool(l < r);
+    case Token::Type::LessEqual:
+      return makeBool(l <= r);
+    default:
+      return nullptr;
+    }
+  }
+
+  case Literal::Kind::F32: {
+    float l = left->f32;
+    float r = right->f32;
+    float result;
+    switch (op) {
+    case Token::Type::Plus:
+      result = l + r;
+      break;
+    case Token::Type::Minus:
+      result = l - r;
+      break;
+    case Token::Type::Multiply:
+      result = l * r;
+      break;
+    case Token::Type::Divide:
+      result = l / r;
+      break;
+    case Token::Type::Equal:
+      return makeBool(l == r);
+    case Token::Type::NotEqual:
+      return makeBool(l != r);
+    case Token::Type::Greater:
+      return makeBool(l > r);
+    case Token::Type::GreaterEqual:
+      return makeBool(l >= r);
+    case Token::Type::Less:
+      return makeBool(l < r);
+    case Token::Type::LessEqual:
+      return makeBool(l <= r);
+    default:
+      return nullptr;
+    }
+
+    auto text = formatFloat(result);
+    if (!text) {
+      return nullptr;
+    }
+    return std::make_unique<AST::NumberNode>(
+        Token{Token::Type::Number, std::move(*text)});
+  }
+  }
+
+  return nullptr;
+}
+
+AST::NodePtr ConstantFoldingPass::foldUnaryOp(const AST::UnaryOpNode &node) {
+  auto operand = readLiteral(node.operand());
+  if (!operand) {
+    return nullptr;
+  }
+
+  switch (node.op().type) {
+  case Token::Type::Minus:
+    if (operand->kind == Literal::Kind::I32) {
+      return makeI32(
+          static_cast<int32_t>(0u - static_cast<uint32_t>(operand->i32)));
+    }
+    if (operand->kind == Literal::Kind::F32) {
+      auto text = formatFloat(-operand->f32);
+      if (!text) {
+        return nullptr;
+      }
+      return std::make_unique<AST::NumberNode>(
+          Token{Token::Type::Number, std::move(*text)});
+    }
+    return nullptr;
+
+  case Token::Type::Not:
+    if (operand->kind == Literal::Kind::Bool) {
+      return makeBool(!operand->boolean);
+    }
+    return nullptr;
+
+  default:
+    return nullptr;
+  }
+}
@@ -0,0 +1,164 @@
+#include "Optimizer/Passes.hpp"
+
+bool ConstantPropagationPass::run(AST::ProgramNode &program) {
+  changed_ = false;
+  reassigned_.clear();
+
+  scopes_.assign(1, {});
+  collectAssignments(program);
+
+  scopes_.assign(1, {});
+  rewriteStatements(program.statements());
+
+  scopes_.clear();
+  return changed_;
+}
+
+const AST::VarDeclNode *
+ConstantPropagationPass::resolve(const std::string &name) const {
+  for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+    auto found = it->find(name);
+    if (found != it->end()) {
+      return found->second;
+    }
+  }
+  return nullptr;
+}
+
+bool ConstantPropagationPass::isPropagatable(
+    const AST::VarDeclNode *decl) const {
+  return decl && !reassigned_.contains(decl) && isLiteral(decl->expr());
+}
+
+// Resolves every assignment to the declaration it writes, honouring
+// shadowing, so that only bindings that are never reassigned get propagated.
+void ConstantPropagationPass::collectAssignments(AST::Node &node) {
+  if (auto *block = dynamic_cast<AST::BlockNode *>(&node)) {
+    scopes_.emplace_back();
+    for (auto &stmt : block->statements()) {
+      collectAssignments(*stmt);
+    }
+    scopes_.pop_back();
+    return;
+  }
+
+  if (auto *func = dynamic_cast<AST::FuncDeclNode *>(&node)) {
+    scopes_.emplace_back();
+    const auto *params =
+        dynamic_cast<const AST::ParamListNode *>(func->params());
+    if (params) {
+      for (const auto &param : params->params()) {
+        scopes_.back()[param.name.value] = nullptr;
+      }
+    }
+    collectAssignments(*func->bodySlot());
+    scopes_.pop_back();
+    return;
+  }
+
+  if (auto *loop = dynamic_cast<AST::ParallelForNode *>(&node)) {
+    // A reduction assigns its variable once the loop has finished.
+    for (const auto &reduction : loop->reductions()) {
+      if (const AST::VarDeclNode *decl = resolve(reduction.name.value)) {
+        reassigned_.insert(decl);
+      }
+    }
+    collectAssignments(*loop->beginSlot());
+    collectAssignments(*loop->endSlot());
+    scopes_.emplace_back();
+    scopes_.back()[loop->var().value] = nullptr;
+    collectAssignments(*loop->bodySlot());
+    scopes_.pop_back();
+    return;
+  }
+
+  if (auto *varDecl = dynamic_cast<AST::VarDeclNode *>(&node)) {
+    collectAssignments(*varDecl->exprSlot());
+    scopes_.back()[varDecl->name().value] = varDecl;
+    return;
+  }
+
+  if (auto *assign = dynamic_cast<AST::AssignNode *>(&node)) {
+    if (const AST::VarDeclNode *decl = resolve(assign->name().value)) {
+      reassigned_.insert(decl);
+    }
+    collectAssignments(*assign->exprSlot());
+    return;
+  }
+
+  forEachChild(node, [this](AST::NodePtr &slot) { collectAssignments(*slot); });
+}
+
+void ConstantPropagationPass::rewrite(AST::NodePtr &slot) {
+  if (auto *ident = dynamic_cast<AST::IdentifierNode *>(slot.get())) {
+    const AST::VarDeclNode *decl = resolve(ident->name().value);
+    if (isPropagatable(decl)) {
+      SourceLocation location = slot->location();
+      slot = cloneLiteral(decl->expr());
+      slot->setLocation(location);
+      changed_ = true;
+    }
+    return;
+  }
+
+  if (auto *block = dynamic_cast<AST::BlockNode *>(slot.get())) {
+    scopes_.emplace_back();
+    rewriteStatements(block->statements());
+    scopes_.pop_back();
+    return;
+  }
+
+  if (auto *func = dynamic_cast<AST::FuncDeclNode *>(slot.get())) {
+    rewriteFunction(*func);
+    return;
+  }
+
+  if (auto *loop = dynamic_cast<AST::ParallelForNode *>(slot.get())) {
+    rewrite(loop->beginSlot());
+    rewrite(loop->endSlot());
+    scopes_.emplace_back();
+    scopes_.back()[loop->var().value] = nullptr;
+    rewrite(loop->bodySlot());
+    scopes_.pop_back();
+    return;
+  }
+
+  forEachChild(*slot, [this](AST::NodePtr &child) { rewrite(child); });
+}
+
+void ConstantPropagationPass::rewriteFunction(AST::FuncDeclNode &func) {
+  scopes_.emplace_back();
+  const auto *params = dynamic_cast<const AST::ParamListNode *>(func.params());
+  if (params) {
+    for (const auto &param : params->params()) {
+      scopes_.back()[param.name.value] = nullptr;
+    }
+  }
+  rewrite(func.bodySlot());
+  scopes_.pop_back();
+}
+
+void ConstantPropagationPass::rewriteStatements(
+    std::vector<AST::NodePtr> &statements) {
+  std::vector<AST::NodePtr> kept;
+  kept.reserve(statements.size());
+
+  for (auto &stmt : statements) {
+    if (auto *varDecl = dynamic_cast<AST::VarDeclNode *>(stmt.get())) {
+      rewrite(varDecl->exprSlot());
+      scopes_.back()[varDecl->name().value] = varDecl;
+
+      // Every later use of the binding is replaced by its value, so the
+      // declaration itself has nothing left to do.
+      if (isPropagatable(varDecl)) {
+        changed_ = true;
+        continue;
+      }
+    } else {
+      rewrite(stmt);
+    }
+    kept.push_back(std::move(stmt));
+  }
+
+  statements = std::move(kept);
+}
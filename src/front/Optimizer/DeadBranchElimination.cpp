@@ -0,0 +1,65 @@
+#include "Optimizer/Passes.hpp"
+
+static const AST::BooleanNode *constantCondition(const AST::Node *node) {
+  return dynamic_cast<const AST::BooleanNode *>(node);
+}
+
+bool DeadBranchEliminationPass::run(AST::ProgramNode &program) {
+  changed_ = false;
+  visitNode(program);
+  return changed_;
+}
+
+void DeadBranchEliminationPass::visitNode(AST::Node &node) {
+  forEachChild(node, [this](AST::NodePtr &slot) { visitNode(*slot); });
+
+  if (auto *program = dynamic_cast<AST::ProgramNode *>(&node)) {
+    pruneStatements(program->statements());
+  } else if (auto *block = dynamic_cast<AST::BlockNode *>(&node)) {
+    pruneStatements(block->statements());
+  }
+}
+
+void DeadBranchEliminationPass::pruneStatements(
+    std::vector<AST::NodePtr> &statements) {
+  std::vector<AST::NodePtr> kept;
+  kept.reserve(statements.size());
+
+  for (auto &stmt : statements) {
+    if (auto *ifStmt = dynamic_cast<AST::IfStmtNode *>(stmt.get())) {
+      if (auto *cond = constantCondition(ifStmt->condition())) {
+        changed_ = true;
+        // The taken branch stays a block of its own to keep its scope.
+        AST::NodePtr &taken = cond->value().value == "true"
+                                  ? ifStmt->thenBlockSlot()
+                                  : ifStmt->elseBlockSlot();
+        if (taken) {
+          kept.push_back(std::move(taken));
+        }
+        continue;
+      }
+    }
+
+    if (auto *whileStmt = dynamic_cast<AST::WhileStmtNode *>(stmt.get())) {
+      if (auto *cond = constantCondition(whileStmt->condition())) {
+        if (cond->value().value == "false") {
+          changed_ = true;
+          continue;
+        }
+      }
+    }
+
+    bool returns = dynamic_cast<AST::ReturnStmtNode *>(stmt.get()) != nullptr;
+    kept.push_back(std::move(stmt));
+
+    // Nothing after a return in the same block can run.
+    if (returns) {
+      if (kept.size() < statements.size()) {
+        changed_ = true;
+      }
+      break;
+    }
+  }
+
+  statements = std::move(kept);
+}
@@ -6,13 +6,18 @@ void AST::VarDeclNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::AssignNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::IfStmtNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::WhileStmtNode::accept(AST::Visitor &v) const { v.visit(*this); }
+void AST::ParallelForNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::FuncDeclNode::accept(AST::Visitor &v) const { v.visit(*this); }
+void AST::StructDeclNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::FuncCallNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::ReturnStmtNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::PrintStmtNode::accept(AST::Visitor &v) const { v.visit(*this); }
+void AST::SpawnStmtNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::ExprStmtNode::accept(AST::Visitor &v) const { v.visit(*this); }
+void AST::FieldAccessNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::BinaryOpNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::UnaryOpNode::accept(AST::Visitor &v) const { v.visit(*this); }
+void AST::AwaitNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::NumberNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::BooleanNode::accept(AST::Visitor &v) const { v.visit(*this); }
 void AST::IdentifierNode::accept(AST::Visitor &v) const { v.visit(*this); }
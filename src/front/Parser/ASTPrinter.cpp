@@ -3,6 +3,9 @@
 void ASTPrinter::visit(const AST::ProgramNode &node) {
   printIndent("Program");
   indent();
+  for (const auto &module : node.imports()) {
+    printIndent("Import: " + module.value);
+  }
   for (const auto &stmt : node.statements()) {
     stmt->accept(*this);
   }
@@ -29,7 +32,11 @@ void ASTPrinter::visit(const AST::VarDeclNode &node) {
 }
 
 void ASTPrinter::visit(const AST::AssignNode &node) {
-  printIndent("Assign: " + node.name().value);
+  std::string target = node.name().value;
+  for (const auto &field : node.fields()) {
+    target += "." + field.value;
+  }
+  printIndent("Assign: " + target);
   indent();
   node.expr()->accept(*this);
   unindent();
@@ -72,9 +79,41 @@ void ASTPrinter::visit(const AST::WhileStmtNode &node) {
   unindent();
 }
 
+void ASTPrinter::visit(const AST::ParallelForNode &node) {
+  printIndent("ParallelFor: " + node.var().value);
+  indent();
+  printIndent("Begin:");
+  indent();
+  node.begin()->accept(*this);
+  unindent();
+
+  printIndent("End:");
+  indent();
+  node.end()->accept(*this);
+  unindent();
+
+  for (const auto &reduction : node.reductions()) {
+    printIndent("Reduce: " + reduction.op.value + " " + reduction.name.value);
+  }
+
+  printIndent("Body:");
+  indent();
+  node.body()->accept(*this);
+  unindent();
+  unindent();
+}
+
 void ASTPrinter::visit(const AST::FuncDeclNode &node) {
-  printIndent("FuncDecl: " + node.name().value);
+  const char *label = node.isAsync()   ? "FuncDecl (async): "
+                      : node.isConst() ? "FuncDecl (const): "
+                                       : "FuncDecl: ";
+  printIndent(label + node.name().value);
   indent();
+  for (const auto &attribute : node.attributes()) {
+    printIndent("Attribute: " + attribute.name.value +
+                (attribute.argument ? "(" + attribute.argument->value + ")"
+                                    : ""));
+  }
   if (node.returnType()) {
     printIndent("ReturnType:");
     indent();
@@ -96,6 +135,23 @@ void ASTPrinter::visit(const AST::FuncDeclNode &node) {
   unindent();
 }
 
+void ASTPrinter::visit(const AST::StructDeclNode &node) {
+  printIndent("StructDecl: " + node.name().value);
+  indent();
+  for (const auto &attribute : node.attributes()) {
+    printIndent("Attribute: " + attribute.name.value +
+                (attribute.argument ? "(" + attribute.argument->value + ")"
+                                    : ""));
+  }
+  for (const auto &field : node.fields()) {
+    printIndent("Field: " + field.name.value);
+    indent();
+    field.type->accept(*this);
+    unindent();
+  }
+  unindent();
+}
+
 void ASTPrinter::visit(const AST::FuncCallNode &node) {
   printIndent("FuncCall: " + node.name().value);
   indent();
@@ -105,7 +161,7 @@ void ASTPrinter::visit(const AST::FuncCallNode &node) {
 }
 
 void ASTPrinter::visit(const AST::ReturnStmtNode &node) {
-  printIndent("ReturnStmt");
+  printIndent(node.isTail() ? "ReturnStmt (tail)" : "ReturnStmt");
   if (node.expr()) {
     indent();
     node.expr()->accept(*this);
@@ -120,6 +176,13 @@ void ASTPrinter::visit(const AST::PrintStmtNode &node) {
   unindent();
 }
 
+void ASTPrinter::visit(const AST::SpawnStmtNode &node) {
+  printIndent("SpawnStmt");
+  indent();
+  node.call()->accept(*this);
+  unindent();
+}
+
 void ASTPrinter::visit(const AST::ExprStmtNode &node) {
   printIndent("ExprStmt");
   indent();
@@ -142,6 +205,20 @@ void ASTPrinter::visit(const AST::UnaryOpNode &node) {
   unindent();
 }
 
+void ASTPrinter::visit(const AST::AwaitNode &node) {
+  printIndent("Await");
+  indent();
+  node.expr()->accept(*this);
+  unindent();
+}
+
+void ASTPrinter::visit(const AST::FieldAccessNode &node) {
+  printIndent("FieldAccess: " + node.field().value);
+  indent();
+  node.object()->accept(*this);
+  unindent();
+}
+
 void ASTPrinter::visit(const AST::NumberNode &node) {
   printIndent("Number: " + node.value().value);
 }
@@ -0,0 +1,152 @@
+#include "Parser/ASTStatistics.hpp"
+
+size_t ASTStatistics::nodeCount() const {
+  size_t count = 0;
+  for (const auto &[name, kind] : kinds_) {
+    count += kind.count;
+  }
+  return count;
+}
+
+size_t ASTStatistics::nodeBytes() const {
+  size_t bytes = 0;
+  for (const auto &[name, kind] : kinds_) {
+    bytes += kind.bytes;
+  }
+  return bytes;
+}
+
+void ASTStatistics::visit(const AST::ProgramNode &node) {
+  record("Program", sizeof(node));
+  for (const auto &stmt : node.statements()) {
+    visitChild(stmt.get());
+  }
+}
+
+void ASTStatistics::visit(const AST::BlockNode &node) {
+  record("Block", sizeof(node));
+  for (const auto &stmt : node.statements()) {
+    visitChild(stmt.get());
+  }
+}
+
+void ASTStatistics::visit(const AST::VarDeclNode &node) {
+  record("VarDecl", sizeof(node));
+  visitChild(node.type());
+  visitChild(node.expr());
+}
+
+void ASTStatistics::visit(const AST::AssignNode &node) {
+  record("Assign", sizeof(node));
+  visitChild(node.expr());
+}
+
+void ASTStatistics::visit(const AST::IfStmtNode &node) {
+  record("IfStmt", sizeof(node));
+  visitChild(node.condition());
+  visitChild(node.thenBlock());
+  visitChild(node.elseBlock());
+}
+
+void ASTStatistics::visit(const AST::WhileStmtNode &node) {
+  record("WhileStmt", sizeof(node));
+  visitChild(node.condition());
+  visitChild(node.body());
+}
+
+void ASTStatistics::visit(const AST::ParallelForNode &node) {
+  record("ParallelFor", sizeof(node));
+  visitChild(node.begin());
+  visitChild(node.end());
+  visitChild(node.body());
+}
+
+void ASTStatistics::visit(const AST::FuncDeclNode &node) {
+  record("FuncDecl", sizeof(node));
+  visitChild(node.params());
+  visitChild(node.returnType());
+  visitChild(node.body());
+}
+
+void ASTStatistics::visit(const AST::StructDeclNode &node) {
+  record("StructDecl", sizeof(node));
+  for (const auto &field : node.fields()) {
+    visitChild(field.type.get());
+  }
+}
+
+void ASTStatistics::visit(const AST::FuncCallNode &node) {
+  record("FuncCall", sizeof(node));
+  visitChild(node.args());
+}
+
+void ASTStatistics::visit(const AST::ReturnStmtNode &node) {
+  record("ReturnStmt", sizeof(node));
+  visitChild(node.expr());
+}
+
+void ASTStatistics::visit(const AST::PrintStmtNode &node) {
+  record("PrintStmt", sizeof(node));
+  visitChild(node.expr());
+}
+
+void ASTStatistics::visit(const AST::SpawnStmtNode &node) {
+  record("SpawnStmt", sizeof(node));
+  visitChild(node.call());
+}
+
+void ASTStatistics::visit(const AST::ExprStmtNode &node) {
+  record("ExprStmt", sizeof(node));
+  visitChild(node.expr());
+}
+
+void ASTStatistics::visit(const AST::BinaryOpNode &node) {
+  record("BinaryOp", sizeof(node));
+  visitChild(node.left());
+  visitChild(node.right());
+}
+
+void ASTStatistics::visit(const AST::UnaryOpNode &node) {
+  record("UnaryOp", sizeof(node));
+  visitChild(node.operand());
+}
+
+void ASTStatistics::visit(const AST::AwaitNode &node) {
+  record("Await", sizeof(node));
+  visitChild(node.expr());
+}
+
+void ASTStatistics::visit(const AST::FieldAccessNode &node) {
+  record("FieldAccess", sizeof(node));
+  visitChild(node.object());
+}
+
+void ASTStatistics::visit(const AST::NumberNode &node) {
+  record("Number", sizeof(node));
+}
+
+void ASTStatistics::visit(const AST::BooleanNode &node) {
+  record("Boolean", sizeof(node));
+}
+
+void ASTStatistics::visit(const AST::IdentifierNode &node) {
+  record("Identifier", sizeof(node));
+}
+
+void ASTStatistics::visit(const AST::TypeNode &node) {
+  record("Type", sizeof(node));
+}
+
+void ASTStatistics::visit(const AST::ParamListNode &node) {
+  record("ParamList", sizeof(node));
+  for (const auto &param : node.params()) {
+    visitChild(param.type.get());
+  }
+}
+
+void ASTStatistics::visit(const AST::ArgListNode &node) {
+  record("ArgList", sizeof(node));
+  for (const auto &arg : node.args()) {
+    visitChild(arg.get());
+  }
+}
@@ -11,6 +11,7 @@ AST::NodePtr Parser::parseLogicOr() {
     auto right = parseLogicAnd();
     left = std::make_unique<AST::BinaryOpNode>(op, std::move(left),
                                                std::move(right));
+    left->setLocation(op.location);
   }
 
   return left;
@@ -25,6 +26,7 @@ AST::NodePtr Parser::parseLogicAnd() {
     auto right = parseEquality();
     left = std::make_unique<AST::BinaryOpNode>(op, std::move(left),
                                                std::move(right));
+    left->setLocation(op.location);
   }
 
   return left;
@@ -40,6 +42,7 @@ AST::NodePtr Parser::parseEquality() {
     auto right = parseComparison();
     left = std::make_unique<AST::BinaryOpNode>(op, std::move(left),
                                                std::move(right));
+    left->setLocation(op.location);
   }
 
   return left;
@@ -57,6 +60,7 @@ AST::NodePtr Parser::parseComparison() {
     auto right = parseTerm();
     left = std::make_unique<AST::BinaryOpNode>(op, std::move(left),
                                                std::move(right));
+    left->setLocation(op.location);
   }
 
   return left;
@@ -72,6 +76,7 @@ AST::NodePtr Parser::parseTerm() {
     auto right = parseFactor();
     left = std::make_unique<AST::BinaryOpNode>(op, std::move(left),
                                                std::move(right));
+    left->setLocation(op.location);
   }
 
   return left;
@@ -86,6 +91,7 @@ AST::NodePtr Parser::parseFactor() {
     auto right = parseUnary();
     left = std::make_unique<AST::BinaryOpNode>(op, std::move(left),
                                                std::move(right));
+    left->setLocation(op.location);
   }
   return left;
 }
@@ -102,10 +108,33 @@ AST::NodePtr Parser::parseUnary() {
       throw Error("expression after unary operator", current());
     }
 
-    return std::make_unique<AST::UnaryOpNode>(op, std::move(operand));
+    auto unary = std::make_unique<AST::UnaryOpNode>(op, std::move(operand));
+    unary->setLocation(op.location);
+    return unary;
   }
 
-  return parsePrimary();
+  if (current().type == Token::Type::Await) {
+    Token await = current();
+    advance();
+    auto node = std::make_unique<AST::AwaitNode>(parseUnary());
+    node->setLocation(await.location);
+    return node;
+  }
+
+  return parsePostfix();
+}
+
+AST::NodePtr Parser::parsePostfix() {
+  auto expr = parsePrimary();
+
+  while (current().type == Token::Type::Dot) {
+    advance();
+    Token field = consume(Token::Type::Identifier, "field name");
+    expr = std::make_unique<AST::FieldAccessNode>(std::move(expr), field);
+    expr->setLocation(field.location);
+  }
+
+  return expr;
 }
 
 AST::NodePtr Parser::parsePrimary() {
@@ -120,18 +149,29 @@ AST::NodePtr Parser::parsePrimary() {
   }
   case Token::Type::Number: {
     advance();
-    return std::make_unique<AST::NumberNode>(curr);
+    auto number = std::make_unique<AST::NumberNode>(curr);
+    number->setLocation(curr.location);
+    return number;
   }
   case Token::Type::Boolean: {
     advance();
-    return std::make_unique<AST::BooleanNode>(curr);
+    auto boolean = std::make_unique<AST::BooleanNode>(curr);
+    boolean->setLocation(curr.location);
+    return boolean;
   }
   case Token::Type::Identifier: {
     if (peek().type == Token::Type::LParen) {
       return parseFuncCall();
     }
     advance();
-    return std::make_unique<AST::IdentifierNode>(curr);
+    auto ident = std::make_unique<AST::IdentifierNode>(curr);
+    ident->setLocation(curr.location);
+    return ident;
+  }
+  case Token::Type::Type: {
+    // Vector constructors such as v4f32(1.0) are spelled as calls to the
+    // type name.
+    return parseFuncCall();
   }
   default:
     throw Error("number, boolean, identifier, or '('", curr);
@@ -1,6 +1,11 @@
 #include "Parser/Parser.hpp"
 
-AST::NodePtr Parser::parseFuncDecl() {
+AST::NodePtr Parser::parseFuncDecl(std::vector<AST::Attribute> attributes) {
+  bool async = current().type == Token::Type::Async;
+  bool constant = current().type == Token::Type::Const;
+  if (async || constant) {
+    advance();
+  }
   consume(Token::Type::Fn, "fn");
   Token name = consume(Token::Type::Identifier, "identifier");
   auto params = parseParamList();
@@ -8,8 +13,10 @@ AST::NodePtr Parser::parseFuncDecl() {
   auto returnType = parseType();
   auto body = parseBlock();
 
-  return std::make_unique<AST::FuncDeclNode>(
-      name, std::move(returnType), std::move(params), std::move(body));
+  return std::make_unique<AST::FuncDeclNode>(name, std::move(returnType),
+                                             std::move(params),
+                                             std::move(body), async, constant,
+                                             std::move(attributes));
 }
 
 AST::NodePtr Parser::parseFuncCall() {
@@ -19,7 +26,9 @@ AST::NodePtr Parser::parseFuncCall() {
   auto args = parseArgList();
   consume(Token::Type::RParen, ")");
 
-  return std::make_unique<AST::FuncCallNode>(name, std::move(args));
+  auto call = std::make_unique<AST::FuncCallNode>(name, std::move(args));
+  call->setLocation(name.location);
+  return call;
 }
 
 AST::NodePtr Parser::parseParamList() {
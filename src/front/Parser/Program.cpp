@@ -4,8 +4,19 @@ AST::NodePtr Parser::parseProgram() {
   auto program = std::make_unique<AST::ProgramNode>();
 
   while (current().type != Token::Type::End) {
-    program->addStatement(parseStatement());
+    if (current().type == Token::Type::Import) {
+      program->addImport(parseImport());
+    } else {
+      program->addStatement(parseStatement());
+    }
   }
 
   return program;
 }
+
+Token Parser::parseImport() {
+  consume(Token::Type::Import, "import");
+  Token module = consume(Token::Type::Identifier, "module name");
+  consume(Token::Type::Semicolon, ";");
+  return module;
+}
@@ -1,29 +1,59 @@
 #include "Parser/Parser.hpp"
 
 AST::NodePtr Parser::parseStatement() {
+  SourceLocation location = current().location;
+  AST::NodePtr stmt;
+
   switch (current().type) {
   case Token::Type::Let:
-    return parseVarDecl();
+    stmt = parseVarDecl();
+    break;
   case Token::Type::Identifier:
-    if (peek().type == Token::Type::Assign) {
-      return parseAssign();
-    }
-    return parseExprStmt();
+    stmt = isAssignment() ? parseAssign() : parseExprStmt();
+    break;
   case Token::Type::LBrace:
-    return parseBlock();
+    stmt = parseBlock();
+    break;
   case Token::Type::If:
-    return parseIfStmt();
+    stmt = parseIfStmt();
+    break;
   case Token::Type::While:
-    return parseWhileStmt();
+    stmt = parseWhileStmt();
+    break;
+  case Token::Type::Parallel:
+    stmt = parseParallelFor();
+    break;
   case Token::Type::Fn:
-    return parseFuncDecl();
+  case Token::Type::Async:
+  case Token::Type::Const:
+    stmt = parseFuncDecl();
+    break;
+  case Token::Type::Struct:
+    stmt = parseStructDecl();
+    break;
+  case Token::Type::At: {
+    std::vector<AST::Attribute> attributes = parseAttributes();
+    stmt = current().type == Token::Type::Struct
+               ? parseStructDecl(std::move(attributes))
+               : parseFuncDecl(std::move(attributes));
+    break;
+  }
   case Token::Type::Return:
-    return parseReturnStmt();
+    stmt = parseReturnStmt();
+    break;
   case Token::Type::Print:
-    return parsePrintStmt();
+    stmt = parsePrintStmt();
+    break;
+  case Token::Type::Spawn:
+    stmt = parseSpawnStmt();
+    break;
   default:
-    return parseExprStmt();
+    stmt = parseExprStmt();
+    break;
   }
+
+  stmt->setLocation(location);
+  return stmt;
 }
 
 AST::NodePtr Parser::parseVarDecl() {
@@ -39,13 +69,30 @@ AST::NodePtr Parser::parseVarDecl() {
                                             std::move(expr));
 }
 
+// IDENT ('.' IDENT)* '=' starts an assignment; anything else starting with an
+// identifier is an expression statement.
+bool Parser::isAssignment() const {
+  size_t offset = 1;
+  while (peek(offset).type == Token::Type::Dot &&
+         peek(offset + 1).type == Token::Type::Identifier) {
+    offset += 2;
+  }
+  return peek(offset).type == Token::Type::Assign;
+}
+
 AST::NodePtr Parser::parseAssign() {
   Token name = consume(Token::Type::Identifier, "identifier");
+  std::vector<Token> fields;
+  while (current().type == Token::Type::Dot) {
+    advance();
+    fields.push_back(consume(Token::Type::Identifier, "field name"));
+  }
   consume(Token::Type::Assign, "=");
   auto expr = parseExpr();
   consume(Token::Type::Semicolon, ";");
 
-  return std::make_unique<AST::AssignNode>(name, std::move(expr));
+  return std::make_unique<AST::AssignNode>(name, std::move(expr),
+                                           std::move(fields));
 }
 
 AST::NodePtr Parser::parseExprStmt() {
@@ -55,9 +102,10 @@ AST::NodePtr Parser::parseExprStmt() {
 }
 
 AST::NodePtr Parser::parseBlock() {
-  consume(Token::Type::LBrace, "{");
+  Token open = consume(Token::Type::LBrace, "{");
 
   auto block = std::make_unique<AST::BlockNode>();
+  block->setLocation(open.location);
 
   while (current().type != Token::Type::RBrace &&
          current().type != Token::Type::End) {
@@ -96,11 +144,55 @@ AST::NodePtr Parser::parseWhileStmt() {
                                               std::move(body));
 }
 
+AST::NodePtr Parser::parseParallelFor() {
+  consume(Token::Type::Parallel, "parallel");
+  consume(Token::Type::For, "for");
+  Token var = consume(Token::Type::Identifier, "loop variable");
+  consume(Token::Type::In, "in");
+  auto begin = parseExpr();
+  consume(Token::Type::DotDot, "..");
+  auto end = parseExpr();
+
+  std::vector<AST::ParallelForNode::Reduction> reductions;
+  if (current().type == Token::Type::Reduce) {
+    advance();
+    consume(Token::Type::LParen, "(");
+    while (true) {
+      Token op = current();
+      bool isMinMax = op.type == Token::Type::Identifier &&
+                      (op.value == "min" || op.value == "max");
+      if (op.type != Token::Type::Plus && op.type != Token::Type::Multiply &&
+          !isMinMax) {
+        throw Error("reduction operator '+', '*', 'min' or 'max'", op);
+      }
+      advance();
+      consume(Token::Type::Colon, ":");
+      Token name = consume(Token::Type::Identifier, "reduction variable");
+      reductions.push_back({op, name});
+
+      if (current().type != Token::Type::Comma)
+        break;
+      advance();
+    }
+    consume(Token::Type::RParen, ")");
+  }
+
+  auto body = parseBlock();
+
+  return std::make_unique<AST::ParallelForNode>(
+      var, std::move(begin), std::move(end), std::move(reductions),
+      std::move(body));
+}
+
 AST::NodePtr Parser::parseReturnStmt() {
   consume(Token::Type::Return, "return");
+  bool tail = current().type == Token::Type::Tail;
+  if (tail) {
+    advance();
+  }
   auto expr = parseExpr();
   consume(Token::Type::Semicolon, ";");
-  return std::make_unique<AST::ReturnStmtNode>(std::move(expr));
+  return std::make_unique<AST::ReturnStmtNode>(std::move(expr), tail);
 }
 
 AST::NodePtr Parser::parsePrintStmt() {
@@ -109,3 +201,14 @@ AST::NodePtr Parser::parsePrintStmt() {
   consume(Token::Type::Semicolon, ";");
   return std::make_unique<AST::PrintStmtNode>(std::move(expr));
 }
+
+AST::NodePtr Parser::parseSpawnStmt() {
+  consume(Token::Type::Spawn, "spawn");
+  if (current().type != Token::Type::Identifier ||
+      peek().type != Token::Type::LParen) {
+    throw Error("function call after 'spawn'", current());
+  }
+  auto call = parseFuncCall();
+  consume(Token::Type::Semicolon, ";");
+  return std::make_unique<AST::SpawnStmtNode>(std::move(call));
+}
@@ -1,6 +1,54 @@
 #include "Parser/Parser.hpp"
 
 AST::NodePtr Parser::parseType() {
+  // Struct types are named by an identifier.
+  if (current().type == Token::Type::Identifier) {
+    Token type = current();
+    advance();
+    return std::make_unique<AST::TypeNode>(type);
+  }
+
   Token type = consume(Token::Type::Type, "type");
   return std::make_unique<AST::TypeNode>(type);
 }
+
+// The analyzer checks which attributes a declaration takes and what their
+// arguments mean.
+std::vector<AST::Attribute> Parser::parseAttributes() {
+  std::vector<AST::Attribute> attributes;
+  while (current().type == Token::Type::At) {
+    advance();
+    Token name = consume(Token::Type::Identifier, "attribute name");
+    std::optional<Token> argument;
+    if (current().type == Token::Type::LParen) {
+      advance();
+      argument = current().type == Token::Type::Identifier
+                     ? consume(Token::Type::Identifier, "identifier")
+                     : consume(Token::Type::Number, "number");
+      consume(Token::Type::RParen, ")");
+    }
+    attributes.push_back({name, argument});
+  }
+  return attributes;
+}
+
+AST::NodePtr Parser::parseStructDecl(std::vector<AST::Attribute> attributes) {
+  consume(Token::Type::Struct, "struct");
+  Token name = consume(Token::Type::Identifier, "identifier");
+  consume(Token::Type::LBrace, "{");
+
+  std::vector<AST::StructDeclNode::Field> fields;
+  while (current().type != Token::Type::RBrace) {
+    Token fieldName = consume(Token::Type::Identifier, "field name");
+    consume(Token::Type::Colon, ":");
+    fields.push_back({fieldName, parseType()});
+    if (current().type != Token::Type::Comma) {
+      break;
+    }
+    advance();
+  }
+  consume(Token::Type::RBrace, "}");
+
+  return std::make_unique<AST::StructDeclNode>(name, std::move(fields),
+                                               std::move(attributes));
+}
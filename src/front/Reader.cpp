@@ -21,7 +21,7 @@ void Reader::forEachLine(std::function<void(std::string)> callBack) {
       line = line.substr(0, commentPos);
     }
 
-    line.erase(0, line.find_first_not_of(" \t\n\r"));
+    // Leading whitespace is kept so that token columns match the file.
     line.erase(line.find_last_not_of(" \t\n\r") + 1);
     callBack(line);
   }
@@ -30,9 +30,14 @@ void Reader::forEachLine(std::function<void(std::string)> callBack) {
 std::string Reader::readAll() {
   std::string fullText;
 
-  forEachLine([&fullText](auto line) { fullText += line; });
+  forEachLine([&fullText](auto line) {
+    fullText += line;
+    fullText += '\n';
+  });
 
   return fullText;
 }
 
 std::string Reader::getFileName() const { return filePath.stem().string(); }
+
+const std::filesystem::path &Reader::getFilePath() const { return filePath; }
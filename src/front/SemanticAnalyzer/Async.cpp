@@ -0,0 +1,86 @@
+#include "SemanticAnalyzer.hpp"
+
+// sleep is only a builtin while no user function of that name is visible.
+bool SemanticAnalyzer::isSleepCall(const AST::FuncCallNode &node) const {
+  return node.name().value == "sleep" && !symbols_.lookup("sleep");
+}
+
+void SemanticAnalyzer::checkArgs(const AST::FuncCallNode &node) {
+  if (auto *args = dynamic_cast<const AST::ArgListNode *>(node.args())) {
+    for (const auto &arg : args->args()) {
+      checkExpr(arg.get());
+    }
+  }
+}
+
+// await and spawn hand work to the task executor, which runs on a single
+// thread and so cannot be driven from inside a parallel loop body.
+void SemanticAnalyzer::useExecutor(const char *construct) {
+  checkConstContext(construct);
+  if (!parallelRegions_.empty()) {
+    throw Error(std::format("'{}' inside parallel for", construct),
+                "the task executor is single-threaded");
+  }
+  if (!currentFunction_.name.empty()) {
+    functions_[currentFunction_.name].hasSideEffects = true;
+  }
+}
+
+const Symbol *SemanticAnalyzer::checkAsyncCall(const AST::Node *node,
+                                               const char *construct) {
+  auto *call = dynamic_cast<const AST::FuncCallNode *>(node);
+  if (!call) {
+    throw Error(std::format("'{}' expects a call to an async function",
+                            construct));
+  }
+
+  const std::string &name = call->name().value;
+  const Symbol *sym = symbols_.lookup(name);
+  if (!sym) {
+    throw Error(std::format("undefined function '{}'", name));
+  }
+  if (!sym->isAsync()) {
+    throw Error(std::format("'{}' is not an async function", name),
+                std::format("only async functions can be used with '{}'",
+                            construct));
+  }
+
+  checkArgs(*call);
+  recordCall(name);
+  return sym;
+}
+
+Type SemanticAnalyzer::checkAwait(const AST::AwaitNode &node) {
+  useExecutor("await");
+
+  Type result;
+  auto *call = dynamic_cast<const AST::FuncCallNode *>(node.expr());
+  if (call && isSleepCall(*call)) {
+    auto *args = dynamic_cast<const AST::ArgListNode *>(call->args());
+    if (!args || args->args().size() != 1 ||
+        checkExpr(args->args()[0].get()) != Type::I32) {
+      throw Error("'sleep' expects a single 'i32' argument",
+                  "the argument is a duration in milliseconds");
+    }
+    result = Type::Void;
+  } else {
+    result = checkAsyncCall(node.expr(), "await")->type();
+  }
+
+  // Awaiting from synchronous code runs the executor until the task is done,
+  // and the executor may resume any task in the program on the way.
+  if (!currentFunction_.name.empty() && !currentFunction_.isAsync) {
+    recordCall("ode_block_on");
+  }
+
+  return result;
+}
+
+void SemanticAnalyzer::visit(const AST::SpawnStmtNode &node) {
+  useExecutor("spawn");
+  checkAsyncCall(node.call(), "spawn");
+}
+
+void SemanticAnalyzer::visit(const AST::AwaitNode &node) {
+  throw Error("AwaitNode should not be visited directly - use checkExpr()");
+}
@@ -0,0 +1,135 @@
+#include "SemanticAnalyzer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+static constexpr std::array<std::string_view, 7> BUILTIN_NAMES = {
+    "extract",    "insert",     "shuffle",   "reduce_add",
+    "reduce_mul", "reduce_min", "reduce_max"};
+
+bool SemanticAnalyzer::isBuiltinName(const std::string &name) {
+  return std::ranges::find(BUILTIN_NAMES, name) != BUILTIN_NAMES.end();
+}
+
+bool SemanticAnalyzer::isBuiltinCall(const AST::FuncCallNode &node) const {
+  if (node.name().type == Token::Type::Type) {
+    return true;
+  }
+  return isBuiltinName(node.name().value) &&
+         !symbols_.lookup(node.name().value);
+}
+
+// Indices written as literals are range-checked here. Lanes selected at run
+// time may be out of range, in which case the result is unspecified.
+static void checkLaneIndex(const std::string &builtin, const AST::Node *index,
+                           unsigned limit, bool requireLiteral) {
+  const auto *literal = dynamic_cast<const AST::NumberNode *>(index);
+  if (!literal) {
+    if (requireLiteral) {
+      throw SemanticAnalyzer::Error(
+          std::format("'{}' lane indices must be integer literals", builtin));
+    }
+    return;
+  }
+
+  long long value = std::stoll(literal->value().value);
+  if (value >= static_cast<long long>(limit)) {
+    throw SemanticAnalyzer::Error(
+        std::format("lane index out of range in '{}'", builtin),
+        std::format("{} is not below {}", value, limit));
+  }
+}
+
+Type SemanticAnalyzer::checkBuiltinCall(const AST::FuncCallNode &node) {
+  const std::string &name = node.name().value;
+
+  std::vector<const AST::Node *> args;
+  if (auto *argList = dynamic_cast<const AST::ArgListNode *>(node.args())) {
+    for (const auto &arg : argList->args()) {
+      args.push_back(arg.get());
+    }
+  }
+
+  std::vector<Type> types;
+  for (const auto *arg : args) {
+    types.push_back(checkExpr(arg));
+  }
+
+  auto expectArgCount = [&](size_t count) {
+    if (args.size() != count) {
+      throw Error(std::format("wrong number of arguments to '{}'", name),
+                  std::format("expected {} but got {}", count, args.size()));
+    }
+  };
+  auto expectType = [&](size_t i, Type expected) {
+    if (types[i] != expected) {
+      throw Error(std::format("argument {} of '{}' has the wrong type", i + 1,
+                              name),
+                  std::format("expected '{}' but got '{}'",
+                              typeToString(expected), typeToString(types[i])));
+    }
+  };
+  auto expectVector = [&](size_t i) {
+    if (!isVectorType(types[i])) {
+      throw Error(std::format("argument {} of '{}' must be a vector", i + 1,
+                              name),
+                  std::format("got '{}'", typeToString(types[i])));
+    }
+    return types[i];
+  };
+
+  if (node.name().type == Token::Type::Type) {
+    Type vector = typeFromName(name);
+    if (!isVectorType(vector)) {
+      throw Error(std::format("'{}' is not a vector type", name));
+    }
+    // A single value is broadcast to every lane.
+    if (args.size() != 1 && args.size() != laneCount(vector)) {
+      throw Error(std::format("wrong number of lanes for '{}'", name),
+                  std::format("expected 1 or {} but got {}", laneCount(vector),
+                              args.size()));
+    }
+    for (size_t i = 0; i < args.size(); ++i) {
+      expectType(i, elementType(vector));
+    }
+    return vector;
+  }
+
+  if (name == "extract") {
+    expectArgCount(2);
+    Type vector = expectVector(0);
+    expectType(1, Type::I32);
+    checkLaneIndex(name, args[1], laneCount(vector), false);
+    return elementType(vector);
+  }
+
+  if (name == "insert") {
+    expectArgCount(3);
+    Type vector = expectVector(0);
+    expectType(1, Type::I32);
+    checkLaneIndex(name, args[1], laneCount(vector), false);
+    expectType(2, elementType(vector));
+    return vector;
+  }
+
+  if (name == "shuffle") {
+    // shuffle(a, b, i0, ..., iN) picks lane ik from the concatenation of a
+    // and b, so indices range over twice the lane count.
+    if (args.empty()) {
+      expectArgCount(2);
+    }
+    Type vector = expectVector(0);
+    expectArgCount(2 + laneCount(vector));
+    expectType(1, vector);
+    for (size_t i = 2; i < args.size(); ++i) {
+      expectType(i, Type::I32);
+      checkLaneIndex(name, args[i], 2 * laneCount(vector), true);
+    }
+    return vector;
+  }
+
+  // reduce_add, reduce_mul, reduce_min, reduce_max
+  expectArgCount(1);
+  return elementType(expectVector(0));
+}
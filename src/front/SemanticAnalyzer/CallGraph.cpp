@@ -0,0 +1,159 @@
+#include "SemanticAnalyzer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+const FunctionInfo *
+SemanticAnalyzer::functionInfo(const std::string &name) const {
+  auto it = functions_.find(name);
+  return it != functions_.end() ? &it->second : nullptr;
+}
+
+void SemanticAnalyzer::recordCall(const std::string &callee) {
+  if (currentFunction_.name.empty()) {
+    return;
+  }
+  functions_[currentFunction_.name].callees.push_back(callee);
+}
+
+// Marks the functions that sit on a cycle of the call graph, using an
+// iterative Tarjan walk so deep call chains cannot exhaust the stack.
+static std::vector<bool>
+findCycles(const std::vector<std::vector<size_t>> &edges) {
+  size_t count = edges.size();
+  std::vector<int> order(count, -1);
+  std::vector<int> low(count, 0);
+  std::vector<bool> onStack(count, false);
+  std::vector<bool> inCycle(count, false);
+  std::vector<size_t> stack;
+  int counter = 0;
+
+  for (size_t root = 0; root < count; ++root) {
+    if (order[root] != -1) {
+      continue;
+    }
+
+    std::vector<std::pair<size_t, size_t>> work;
+    auto enter = [&](size_t node) {
+      order[node] = low[node] = counter++;
+      stack.push_back(node);
+      onStack[node] = true;
+      work.push_back({node, 0});
+    };
+    enter(root);
+
+    while (!work.empty()) {
+      size_t node = work.back().first;
+      size_t &nextEdge = work.back().second;
+
+      if (nextEdge < edges[node].size()) {
+        size_t target = edges[node][nextEdge++];
+        if (target == node) {
+          inCycle[node] = true;
+        }
+        if (order[target] == -1) {
+          enter(target);
+        } else if (onStack[target]) {
+          low[node] = std::min(low[node], order[target]);
+        }
+        continue;
+      }
+
+      work.pop_back();
+      if (!work.empty()) {
+        size_t parent = work.back().first;
+        low[parent] = std::min(low[parent], low[node]);
+      }
+
+      if (low[node] == order[node]) {
+        std::vector<size_t> component;
+        size_t member;
+        do {
+          member = stack.back();
+          stack.pop_back();
+          onStack[member] = false;
+          component.push_back(member);
+        } while (member != node);
+
+        if (component.size() > 1) {
+          for (size_t m : component) {
+            inCycle[m] = true;
+          }
+        }
+      }
+    }
+  }
+
+  return inCycle;
+}
+
+void SemanticAnalyzer::computeFunctionFacts() {
+  std::vector<FunctionInfo *> infos;
+  std::unordered_map<std::string, size_t> indices;
+  for (auto &[name, info] : functions_) {
+    indices[name] = infos.size();
+    infos.push_back(&info);
+  }
+
+  // Functions from other modules are opaque: they may have any effect and
+  // may call back into this module.
+  std::vector<std::vector<size_t>> edges(infos.size());
+  std::vector<bool> reachesExternal(infos.size(), false);
+  for (size_t i = 0; i < infos.size(); ++i) {
+    for (const auto &callee : infos[i]->callees) {
+      auto it = indices.find(callee);
+      if (it == indices.end()) {
+        reachesExternal[i] = true;
+      } else {
+        edges[i].push_back(it->second);
+      }
+    }
+  }
+
+  std::vector<bool> inCycle = findCycles(edges);
+
+  for (size_t i = 0; i < infos.size(); ++i) {
+    infos[i]->pure = !infos[i]->hasSideEffects && !reachesExternal[i];
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < infos.size(); ++i) {
+      for (size_t callee : edges[i]) {
+        if (infos[i]->pure && !infos[callee]->pure) {
+          infos[i]->pure = false;
+          changed = true;
+        }
+        if (!reachesExternal[i] && reachesExternal[callee]) {
+          reachesExternal[i] = true;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < infos.size(); ++i) {
+    infos[i]->recursive = inCycle[i] || reachesExternal[i];
+    infos[i]->willReturn = !infos[i]->hasLoops && !infos[i]->recursive;
+  }
+
+  // Without recursion the graph below a function is acyclic, so termination
+  // only has to be pushed up from the callees.
+  changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < infos.size(); ++i) {
+      if (!infos[i]->willReturn) {
+        continue;
+      }
+      for (size_t callee : edges[i]) {
+        if (!infos[callee]->willReturn) {
+          infos[i]->willReturn = false;
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#include "SemanticAnalyzer.hpp"
+
+// The compiler evaluates const fn bodies itself, so they are limited to the
+// values a literal can stand for and may not print or start tasks.
+static bool isConstType(Type type) {
+  return type == Type::I32 || type == Type::F32 || type == Type::Bool;
+}
+
+bool SemanticAnalyzer::inConstFunction() const {
+  return constFunctions_.contains(currentFunction_.name);
+}
+
+void SemanticAnalyzer::checkConstFunction(const AST::FuncDeclNode &node,
+                                          Type returnType,
+                                          const std::vector<Type> &params) {
+  const std::string &name = node.name().value;
+  if (symbols_.depth() > 1) {
+    throw Error(std::format("const fn '{}' must be declared at the top level",
+                            name));
+  }
+  if (name == "main") {
+    throw Error("main cannot be const");
+  }
+  if (!isConstType(returnType)) {
+    throw Error(
+        std::format("const fn '{}' must return 'i32', 'f32' or 'bool'", name),
+        std::format("got '{}'", typeToString(returnType)));
+  }
+  for (Type param : params) {
+    if (!isConstType(param)) {
+      throw Error(std::format("parameters of const fn '{}' must be 'i32', "
+                              "'f32' or 'bool'",
+                              name),
+                  std::format("got '{}'", typeToString(param)));
+    }
+  }
+  constFunctions_.insert(name);
+}
+
+void SemanticAnalyzer::checkConstContext(const char *construct) const {
+  if (inConstFunction()) {
+    throw Error(std::format("'{}' inside const fn '{}'", construct,
+                            currentFunction_.name),
+                "const functions are evaluated by the compiler");
+  }
+}
+
+// Struct constructors and builtins are calls too, and are rejected here with
+// everything else that is not a const fn.
+void SemanticAnalyzer::checkConstCall(const std::string &callee) const {
+  if (inConstFunction() && !constFunctions_.contains(callee)) {
+    throw Error(std::format("const fn '{}' cannot call '{}'",
+                            currentFunction_.name, callee),
+                "only const functions can be called from a const fn");
+  }
+}
+
+void SemanticAnalyzer::checkConstLocal(const std::string &name,
+                                       Type type) const {
+  if (inConstFunction() && !isConstType(type)) {
+    throw Error(std::format("'{}' in const fn '{}' must be 'i32', 'f32' or "
+                            "'bool'",
+                            name, currentFunction_.name),
+                std::format("got '{}'", typeToString(type)));
+  }
+}
@@ -1,6 +1,23 @@
 #include "SemanticAnalyzer.hpp"
 
 Type SemanticAnalyzer::checkExpr(const AST::Node *node) {
+  Type type = checkExprType(node);
+  if (recordTypes_) {
+    expressionTypes_[node] = type;
+  }
+  return type;
+}
+
+std::optional<Type>
+SemanticAnalyzer::expressionType(const AST::Node *node) const {
+  auto it = expressionTypes_.find(node);
+  if (it == expressionTypes_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+Type SemanticAnalyzer::checkExprType(const AST::Node *node) {
   if (auto *binOp = dynamic_cast<const AST::BinaryOpNode *>(node)) {
     return checkBinaryOp(*binOp);
   }
@@ -21,12 +38,32 @@ Type SemanticAnalyzer::checkExpr(const AST::Node *node) {
     return sym->type();
   }
   if (auto *call = dynamic_cast<const AST::FuncCallNode *>(node)) {
+    checkConstCall(call->name().value);
+    if (std::optional<Type> type = structType(call->name().value)) {
+      return checkStructConstruction(*call, *type);
+    }
+    if (isBuiltinCall(*call)) {
+      return checkBuiltinCall(*call);
+    }
     const Symbol *sym = symbols_.lookup(call->name().value);
     if (!sym) {
       throw Error(std::format("undefined function '{}'", call->name().value));
     }
+    if (sym->isAsync()) {
+      throw Error(std::format("call to async function '{}' must be awaited "
+                              "or spawned",
+                              call->name().value));
+    }
+    checkArgs(*call);
+    recordCall(call->name().value);
     return sym->type();
   }
+  if (auto *await = dynamic_cast<const AST::AwaitNode *>(node)) {
+    return checkAwait(*await);
+  }
+  if (auto *access = dynamic_cast<const AST::FieldAccessNode *>(node)) {
+    return fieldType(checkExpr(access->object()), access->field());
+  }
   throw Error("unknown expression node type");
 }
 
@@ -41,6 +78,9 @@ Type SemanticAnalyzer::checkUnaryOp(const AST::UnaryOpNode &node) {
     if (operandType == Type::Void) {
       throw Error("cannot apply unary minus to void");
     }
+    if (isStructType(operandType)) {
+      throw Error("cannot apply unary minus to struct value");
+    }
     return operandType;
 
   case Token::Type::Not:
@@ -76,6 +116,13 @@ Type SemanticAnalyzer::checkBinaryOp(const AST::BinaryOpNode &node) {
                   std::format("got '{}' and '{}'", typeToString(left),
                               typeToString(right)));
     }
+    if (isVectorType(left)) {
+      throw Error("cannot compare vector values",
+                  "compare extracted lanes instead");
+    }
+    if (isStructType(left)) {
+      throw Error("cannot compare struct values", "compare fields instead");
+    }
     return Type::Bool;
 
   case Token::Type::Greater:
@@ -90,6 +137,13 @@ Type SemanticAnalyzer::checkBinaryOp(const AST::BinaryOpNode &node) {
     if (left == Type::Bool || left == Type::Void) {
       throw Error("cannot compare boolean or void values");
     }
+    if (isVectorType(left)) {
+      throw Error("cannot compare vector values",
+                  "compare extracted lanes instead");
+    }
+    if (isStructType(left)) {
+      throw Error("cannot compare struct values", "compare fields instead");
+    }
     return Type::Bool;
 
   case Token::Type::Plus:
@@ -104,6 +158,9 @@ Type SemanticAnalyzer::checkBinaryOp(const AST::BinaryOpNode &node) {
     if (left == Type::Bool) {
       throw Error("cannot perform arithmetic on boolean values");
     }
+    if (isStructType(left)) {
+      throw Error("cannot perform arithmetic on struct values");
+    }
     return left;
 
   default:
@@ -128,7 +185,10 @@ Type SemanticAnalyzer::parseType(const AST::Node *node) {
     throw Error("expected type annotation");
   }
 
-  const std::string &typeStr = typeNode->type().value;
+  return typeFromName(typeNode->type().value);
+}
+
+Type SemanticAnalyzer::typeFromName(const std::string &typeStr) {
   if (typeStr == "i32")
     return Type::I32;
   if (typeStr == "f32")
@@ -137,11 +197,26 @@ Type SemanticAnalyzer::parseType(const AST::Node *node) {
     return Type::Bool;
   if (typeStr == "void")
     return Type::Void;
+  if (typeStr == "v4f32")
+    return Type::V4F32;
+  if (typeStr == "v8f32")
+    return Type::V8F32;
+  if (typeStr == "v4i32")
+    return Type::V4I32;
+  if (typeStr == "v8i32")
+    return Type::V8I32;
 
   throw Error(std::format("unknown type '{}'", typeStr));
 }
 
-std::string SemanticAnalyzer::typeToString(Type t) {
+std::string SemanticAnalyzer::typeToString(Type t) const {
+  if (isStructType(t)) {
+    return structInfo(t).name;
+  }
+  return typeName(t);
+}
+
+std::string SemanticAnalyzer::typeName(Type t) {
   switch (t) {
   case Type::I32:
     return "i32";
@@ -151,6 +226,14 @@ std::string SemanticAnalyzer::typeToString(Type t) {
     return "bool";
   case Type::Void:
     return "void";
+  case Type::V4F32:
+    return "v4f32";
+  case Type::V8F32:
+    return "v8f32";
+  case Type::V4I32:
+    return "v4i32";
+  case Type::V8I32:
+    return "v8i32";
   }
   return "unknown";
 }
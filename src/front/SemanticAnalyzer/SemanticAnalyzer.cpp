@@ -1,15 +1,79 @@
 #include "SemanticAnalyzer.hpp"
 
+#include <algorithm>
+#include <utility>
+
 void SemanticAnalyzer::analyze(AST::Node &root) { root.accept(*this); }
 
+void SemanticAnalyzer::declareExternal(const FunctionSignature &signature) {
+  symbols_.declare(signature.name, Symbol::Kind::Function,
+                   signature.returnType, signature.params, signature.isAsync);
+}
+
+static bool namesStruct(const AST::Node *type) {
+  auto *typeNode = dynamic_cast<const AST::TypeNode *>(type);
+  return typeNode && typeNode->type().type == Token::Type::Identifier;
+}
+
+// Structs are local to the file that declares them, so functions taking or
+// returning one cannot be called from other files.
+static bool usesStructTypes(const AST::FuncDeclNode &func) {
+  if (namesStruct(func.returnType())) {
+    return true;
+  }
+  if (const auto *params =
+          dynamic_cast<const AST::ParamListNode *>(func.params())) {
+    for (const auto &param : params->params()) {
+      if (namesStruct(param.type.get())) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+std::vector<FunctionSignature>
+SemanticAnalyzer::collectSignatures(const AST::Node &root) {
+  std::vector<FunctionSignature> signatures;
+
+  const auto *program = dynamic_cast<const AST::ProgramNode *>(&root);
+  if (!program) {
+    return signatures;
+  }
+
+  for (const auto &stmt : program->statements()) {
+    const auto *func = dynamic_cast<const AST::FuncDeclNode *>(stmt.get());
+    if (!func || usesStructTypes(*func)) {
+      continue;
+    }
+
+    FunctionSignature signature{func->name().value,
+                                parseType(func->returnType()),
+                                {},
+                                func->isAsync()};
+    const auto *params =
+        dynamic_cast<const AST::ParamListNode *>(func->params());
+    if (params) {
+      for (const auto &param : params->params()) {
+        signature.params.push_back(parseType(param.type.get()));
+      }
+    }
+    signatures.push_back(std::move(signature));
+  }
+
+  return signatures;
+}
+
 void SemanticAnalyzer::visit(const AST::ProgramNode &node) {
   for (const auto &stmt : node.statements()) {
     stmt->accept(*this);
   }
 
-  if (!symbols_.lookup("main")) {
+  if (requireMain_ && !symbols_.lookup("main")) {
     throw Error("No main function found");
   }
+
+  computeFunctionFacts();
 }
 
 void SemanticAnalyzer::visit(const AST::BlockNode &node) {
@@ -21,7 +85,8 @@ void SemanticAnalyzer::visit(const AST::BlockNode &node) {
 }
 
 void SemanticAnalyzer::visit(const AST::VarDeclNode &node) {
-  Type declaredType = parseType(node.type());
+  Type declaredType = resolveType(node.type());
+  checkConstLocal(node.name().value, declaredType);
   Type exprType = checkExpr(node.expr());
 
   if (declaredType != exprType) {
@@ -40,12 +105,20 @@ void SemanticAnalyzer::visit(const AST::AssignNode &node) {
     throw Error(std::format("undefined variable '{}'", node.name().value));
   }
 
+  checkParallelWrite(node.name().value);
+
+  std::string target = node.name().value;
+  Type targetType = sym->type();
+  for (const auto &field : node.fields()) {
+    targetType = fieldType(targetType, field);
+    target += "." + field.value;
+  }
+
   Type exprType = checkExpr(node.expr());
-  if (sym->type() != exprType) {
-    throw Error(
-        std::format("type mismatch in assignment to '{}'", node.name().value),
-        std::format("expected '{}' but got '{}'", typeToString(sym->type()),
-                    typeToString(exprType)));
+  if (targetType != exprType) {
+    throw Error(std::format("type mismatch in assignment to '{}'", target),
+                std::format("expected '{}' but got '{}'",
+                            typeToString(targetType), typeToString(exprType)));
   }
 }
 
@@ -69,27 +142,173 @@ void SemanticAnalyzer::visit(const AST::WhileStmtNode &node) {
                 std::format("got '{}'", typeToString(condType)));
   }
 
+  if (!currentFunction_.name.empty()) {
+    functions_[currentFunction_.name].hasLoops = true;
+  }
+
   node.body()->accept(*this);
 }
 
-void SemanticAnalyzer::visit(const AST::FuncDeclNode &node) {
-  Type returnType = parseType(node.returnType());
+void SemanticAnalyzer::visit(const AST::ParallelForNode &node) {
+  checkConstContext("parallel for");
+  for (const AST::Node *bound : {node.begin(), node.end()}) {
+    Type boundType = checkExpr(bound);
+    if (boundType != Type::I32) {
+      throw Error("parallel for bounds must be 'i32'",
+                  std::format("got '{}'", typeToString(boundType)));
+    }
+  }
 
-  symbols_.declare(node.name().value, Symbol::Kind::Function, returnType);
+  std::vector<std::string> reductions;
+  for (const auto &reduction : node.reductions()) {
+    const std::string &name = reduction.name.value;
+    const Symbol *sym = symbols_.lookup(name);
+    if (!sym || sym->kind() != Symbol::Kind::Variable) {
+      throw Error(std::format("undefined variable '{}'", name));
+    }
+    if (sym->type() != Type::I32 && sym->type() != Type::F32) {
+      throw Error(std::format("cannot reduce '{}'", name),
+                  std::format("expected 'i32' or 'f32' but got '{}'",
+                              typeToString(sym->type())));
+    }
+    if (name == node.var().value) {
+      throw Error(
+          std::format("reduction variable '{}' is hidden by the loop variable",
+                      name));
+    }
+    if (std::ranges::find(reductions, name) != reductions.end()) {
+      throw Error(std::format("'{}' is reduced more than once", name));
+    }
+    // The combined value is assigned after the loop, which may itself be
+    // inside another parallel body.
+    checkParallelWrite(name);
+    reductions.push_back(name);
+  }
+
+  // The iterations run on the runtime's thread pool.
+  if (!currentFunction_.name.empty()) {
+    FunctionInfo &info = functions_[currentFunction_.name];
+    info.hasLoops = true;
+    info.hasSideEffects = true;
+  }
 
   symbols_.enterScope();
+  symbols_.declare(node.var().value, Symbol::Kind::Variable, Type::I32);
+  parallelRegions_.push_back({symbols_.depth(), std::move(reductions)});
+
+  node.body()->accept(*this);
+
+  parallelRegions_.pop_back();
+  symbols_.exitScope();
+}
+
+// Iterations of a parallel for run concurrently, so everything declared
+// outside the body, including the loop variable, is read-only inside it.
+void SemanticAnalyzer::checkParallelWrite(const std::string &name) {
+  std::optional<size_t> scope = symbols_.scopeOf(name);
+  if (!scope) {
+    return;
+  }
+
+  for (const auto &region : parallelRegions_) {
+    if (*scope < region.scopeDepth &&
+        std::ranges::find(region.reductions, name) == region.reductions.end()) {
+      throw Error(
+          std::format("cannot assign to '{}' inside parallel for", name),
+          "variables from outside the loop are read-only unless reduced");
+    }
+  }
+}
+
+// The attributes override how arithmetic is compiled; see
+// Options::Arithmetic.
+void SemanticAnalyzer::checkFunctionAttributes(
+    const AST::FuncDeclNode &node) const {
+  for (const auto &attribute : node.attributes()) {
+    const std::string &attr = attribute.name.value;
+    std::string argument = attribute.argument ? attribute.argument->value : "";
+    if (attr == "fast_math" || attr == "no_fast_math") {
+      if (attribute.argument) {
+        throw Error(std::format("'@{}' takes no argument", attr));
+      }
+    } else if (attr == "overflow") {
+      if (argument != "wrap" && argument != "undefined") {
+        throw Error("'@overflow' expects 'wrap' or 'undefined'",
+                    std::format("got '{}'", argument));
+      }
+    } else if (attr == "fp_contract") {
+      if (argument != "off" && argument != "on" && argument != "fast") {
+        throw Error("'@fp_contract' expects 'off', 'on' or 'fast'",
+                    std::format("got '{}'", argument));
+      }
+    } else {
+      throw Error(std::format("unknown function attribute '@{}'", attr));
+    }
+  }
+}
+
+void SemanticAnalyzer::visit(const AST::FuncDeclNode &node) {
+  if (!parallelRegions_.empty()) {
+    throw Error("functions cannot be declared inside parallel for");
+  }
+  checkConstContext("fn");
+  checkFunctionAttributes(node);
+
+  Type returnType = resolveType(node.returnType());
 
+  std::vector<Type> paramTypes;
   const auto *params = dynamic_cast<const AST::ParamListNode *>(node.params());
   if (params) {
     for (const auto &param : params->params()) {
-      Type paramType = parseType(param.type.get());
-      symbols_.declare(param.name.value, Symbol::Kind::Variable, paramType);
+      paramTypes.push_back(resolveType(param.type.get()));
+    }
+  }
+
+  if (node.isAsync() && node.name().value == "main") {
+    throw Error("main cannot be async");
+  }
+  if (structNames_.contains(node.name().value)) {
+    throw Error(std::format("function '{}' has the name of a struct",
+                            node.name().value));
+  }
+  // Function facts and the generated code both go by name, so a nested
+  // function cannot shadow another one.
+  if (functions_.contains(node.name().value)) {
+    throw Error(std::format("function '{}' is already declared",
+                            node.name().value),
+                "nested functions share one namespace with all others");
+  }
+  if (node.isConst()) {
+    checkConstFunction(node, returnType, paramTypes);
+  }
+
+  symbols_.declare(node.name().value, Symbol::Kind::Function, returnType,
+                   paramTypes, node.isAsync());
+
+  FunctionSignature enclosingFunction =
+      std::exchange(currentFunction_, {node.name().value, returnType,
+                                       paramTypes, node.isAsync()});
+  functions_.try_emplace(currentFunction_.name);
+
+  // Async functions allocate their frame and talk to the task executor.
+  if (node.isAsync()) {
+    functions_[currentFunction_.name].hasSideEffects = true;
+  }
+
+  symbols_.enterScope();
+
+  if (params) {
+    for (size_t i = 0; i < paramTypes.size(); ++i) {
+      symbols_.declare(params->params()[i].name.value, Symbol::Kind::Variable,
+                       paramTypes[i]);
     }
   }
 
   node.body()->accept(*this);
   symbols_.exitScope();
 
+  currentFunction_ = std::move(enclosingFunction);
+
   Todo("function return type checking");
 }
 
@@ -103,16 +322,71 @@ void SemanticAnalyzer::visit(const AST::FuncCallNode &node) {
     throw Error(std::format("'{}' is not a function", node.name().value));
   }
 
+  recordCall(node.name().value);
+
   Todo("function argument type checking");
 }
 
 void SemanticAnalyzer::visit(const AST::ReturnStmtNode &node) {
+  if (!parallelRegions_.empty()) {
+    throw Error("'return' inside parallel for");
+  }
+
   checkExpr(node.expr());
+  if (node.isTail()) {
+    checkTailCall(node);
+  }
   Todo("return type validation against function signature");
 }
 
+// A guaranteed tail call reuses the caller's frame, which LLVM only allows
+// when caller and callee have the same prototype.
+void SemanticAnalyzer::checkTailCall(const AST::ReturnStmtNode &node) {
+  if (currentFunction_.name.empty()) {
+    throw Error("'return tail' outside of a function");
+  }
+  if (currentFunction_.isAsync) {
+    throw Error("'return tail' inside an async function",
+                "an async function returns by completing its task");
+  }
+
+  const auto *call = dynamic_cast<const AST::FuncCallNode *>(node.expr());
+  if (!call || isBuiltinCall(*call)) {
+    throw Error("'return tail' requires a function call");
+  }
+
+  // Struct construction shares the call syntax but has no frame to reuse.
+  const Symbol *callee = symbols_.lookup(call->name().value);
+  if (!callee || callee->kind() != Symbol::Kind::Function) {
+    throw Error(std::format("'return tail' requires a function call, but "
+                            "'{}' is not a function",
+                            call->name().value));
+  }
+  if (callee->type() != currentFunction_.returnType ||
+      callee->params() != currentFunction_.params) {
+    throw Error(std::format("cannot guarantee tail call from '{}' to '{}'",
+                            currentFunction_.name, call->name().value),
+                "both functions must have the same parameter and return types");
+  }
+}
+
 void SemanticAnalyzer::visit(const AST::PrintStmtNode &node) {
-  checkExpr(node.expr());
+  checkConstContext("print");
+  Type exprType = checkExpr(node.expr());
+  if (isVectorType(exprType)) {
+    throw Error("cannot print vector values",
+                std::format("extract the lanes of '{}' first",
+                            typeToString(exprType)));
+  }
+  if (isStructType(exprType)) {
+    throw Error("cannot print struct values",
+                std::format("print the fields of '{}' instead",
+                            typeToString(exprType)));
+  }
+
+  if (!currentFunction_.name.empty()) {
+    functions_[currentFunction_.name].hasSideEffects = true;
+  }
 }
 
 void SemanticAnalyzer::visit(const AST::ExprStmtNode &node) {
@@ -0,0 +1,193 @@
+#include "SemanticAnalyzer.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+Type SemanticAnalyzer::resolveType(const AST::Node *node) const {
+  auto *typeNode = dynamic_cast<const AST::TypeNode *>(node);
+  if (typeNode && typeNode->type().type == Token::Type::Identifier) {
+    std::optional<Type> type = structType(typeNode->type().value);
+    if (!type) {
+      throw Error(std::format("unknown type '{}'", typeNode->type().value));
+    }
+    return *type;
+  }
+  return parseType(node);
+}
+
+std::optional<Type>
+SemanticAnalyzer::structType(const std::string &name) const {
+  auto it = structNames_.find(name);
+  if (it == structNames_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+const StructInfo &SemanticAnalyzer::structInfo(Type type) const {
+  return structs_[static_cast<size_t>(type) -
+                  static_cast<size_t>(Type::FirstStruct)];
+}
+
+// Matches the ABI alignment of the corresponding LLVM types on the usual
+// 64-bit targets. Only the relative order matters here: field offsets
+// themselves come from the target's data layout.
+unsigned SemanticAnalyzer::alignmentOf(Type type) const {
+  if (isStructType(type)) {
+    const StructInfo &info = structInfo(type);
+    if (info.packed) {
+      return 1;
+    }
+    unsigned align = 1;
+    for (const auto &field : info.fields) {
+      align = std::max(align, alignmentOf(field.type));
+    }
+    return align;
+  }
+
+  switch (type) {
+  case Type::I32:
+  case Type::F32:
+    return 4;
+  case Type::V4F32:
+  case Type::V4I32:
+    return 16;
+  case Type::V8F32:
+  case Type::V8I32:
+    return 32;
+  default:
+    return 1;
+  }
+}
+
+void SemanticAnalyzer::visit(const AST::StructDeclNode &node) {
+  const std::string &name = node.name().value;
+  if (symbols_.depth() > 1) {
+    throw Error(std::format("struct '{}' must be declared at the top level",
+                            name));
+  }
+  if (structNames_.contains(name) || symbols_.lookup(name) ||
+      isBuiltinName(name)) {
+    throw Error(std::format("'{}' is already declared", name));
+  }
+  if (node.fields().empty()) {
+    throw Error(std::format("struct '{}' has no fields", name));
+  }
+
+  StructInfo info{name};
+  bool ordered = false;
+  for (const auto &attribute : node.attributes()) {
+    const std::string &attr = attribute.name.value;
+    if (attr == "packed" || attr == "ordered") {
+      if (attribute.argument) {
+        throw Error(std::format("'@{}' takes no argument", attr));
+      }
+      info.packed |= attr == "packed";
+      ordered |= attr == "ordered";
+    } else if (attr == "align") {
+      std::string digits = attribute.argument ? attribute.argument->value : "";
+      unsigned long align = 0;
+      if (!digits.empty() && digits.size() <= 4 &&
+          digits.find_first_not_of("0123456789") == std::string::npos) {
+        align = std::stoul(digits);
+      }
+      if (align == 0 || align > 4096 || (align & (align - 1)) != 0) {
+        throw Error("'@align' expects a power of two up to 4096",
+                    std::format("got '{}'", digits));
+      }
+      info.align = static_cast<unsigned>(align);
+    } else if (attr == "soa") {
+      throw Error("'@soa' is not supported",
+                  "it lays out arrays of structs, and Ode has no arrays");
+    } else {
+      throw Error(std::format("unknown struct attribute '@{}'", attr));
+    }
+  }
+
+  for (const auto &field : node.fields()) {
+    Type type = resolveType(field.type.get());
+    if (type == Type::Void) {
+      throw Error(std::format("field '{}' of '{}' cannot be void",
+                              field.name.value, name));
+    }
+    if (info.fieldIndex(field.name.value)) {
+      throw Error(std::format("duplicate field '{}' in struct '{}'",
+                              field.name.value, name));
+    }
+    info.fields.push_back({field.name.value, type});
+  }
+
+  // Sorting by decreasing alignment leaves padding only at the end when all
+  // alignments are powers of two. The sort is stable, so fields that need
+  // the same alignment keep their declaration order.
+  std::vector<unsigned> order(info.fields.size());
+  std::iota(order.begin(), order.end(), 0u);
+  if (!info.packed && !ordered) {
+    std::ranges::stable_sort(order, [&](unsigned a, unsigned b) {
+      return alignmentOf(info.fields[a].type) >
+             alignmentOf(info.fields[b].type);
+    });
+  }
+  info.slots.resize(order.size());
+  for (unsigned slot = 0; slot < order.size(); ++slot) {
+    info.slots[order[slot]] = slot;
+  }
+
+  structNames_[name] = static_cast<Type>(
+      static_cast<size_t>(Type::FirstStruct) + structs_.size());
+  structs_.push_back(std::move(info));
+}
+
+Type SemanticAnalyzer::fieldType(Type object, const Token &field) const {
+  if (!isStructType(object)) {
+    throw Error(std::format("cannot access field '{}' of '{}'", field.value,
+                            typeToString(object)),
+                "only structs have fields");
+  }
+
+  const StructInfo &info = structInfo(object);
+  std::optional<unsigned> index = info.fieldIndex(field.value);
+  if (!index) {
+    throw Error(
+        std::format("struct '{}' has no field '{}'", info.name, field.value));
+  }
+  return info.fields[*index].type;
+}
+
+// Name(a, b, ...) builds a struct from one value per field, in declaration
+// order.
+Type SemanticAnalyzer::checkStructConstruction(const AST::FuncCallNode &node,
+                                               Type type) {
+  const StructInfo &info = structInfo(type);
+
+  std::vector<const AST::Node *> args;
+  if (auto *argList = dynamic_cast<const AST::ArgListNode *>(node.args())) {
+    for (const auto &arg : argList->args()) {
+      args.push_back(arg.get());
+    }
+  }
+
+  if (args.size() != info.fields.size()) {
+    throw Error(std::format("wrong number of fields for '{}'", info.name),
+                std::format("expected {} but got {}", info.fields.size(),
+                            args.size()));
+  }
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    Type argType = checkExpr(args[i]);
+    if (argType != info.fields[i].type) {
+      throw Error(std::format("field '{}' of '{}' has the wrong type",
+                              info.fields[i].name, info.name),
+                  std::format("expected '{}' but got '{}'",
+                              typeToString(info.fields[i].type),
+                              typeToString(argType)));
+    }
+  }
+
+  return type;
+}
+
+void SemanticAnalyzer::visit(const AST::FieldAccessNode &node) {
+  throw Error(
+      "FieldAccessNode should not be visited directly - use checkExpr()");
+}
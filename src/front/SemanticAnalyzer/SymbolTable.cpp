@@ -1,7 +1,11 @@
 #include "SemanticAnalyzer.hpp"
 
-Symbol::Symbol(std::string name, Kind kind, Type type)
-    : name_(std::move(name)), kind_(kind), type_(type) {}
+#include <algorithm>
+
+Symbol::Symbol(std::string name, Kind kind, Type type,
+               std::vector<Type> params, bool isAsync)
+    : name_(std::move(name)), kind_(kind), type_(type),
+      params_(std::move(params)), isAsync_(isAsync) {}
 
 SymbolTable::SymbolTable() { enterScope(); }
 
@@ -14,14 +18,20 @@ void SymbolTable::exitScope() {
 }
 
 void SymbolTable::declare(const std::string &name, Symbol::Kind kind,
-                          Type type) {
+                          Type type, std::vector<Type> params, bool isAsync) {
   auto &current = scopes_.back();
   if (current.find(name) != current.end()) {
     throw SemanticAnalyzer::Error(
         std::format("symbol '{}' already declared in this scope", name));
   }
 
-  current.emplace(name, Symbol(name, kind, type));
+  current.emplace(name, Symbol(name, kind, type, std::move(params), isAsync));
+
+  if (peakSizes_.size() < scopes_.size()) {
+    peakSizes_.resize(scopes_.size());
+  }
+  size_t &peak = peakSizes_[scopes_.size() - 1];
+  peak = std::max(peak, current.size());
 }
 
 const Symbol *SymbolTable::lookup(const std::string &name) const {
@@ -33,3 +43,12 @@ const Symbol *SymbolTable::lookup(const std::string &name) const {
   }
   return nullptr;
 }
+
+std::optional<size_t> SymbolTable::scopeOf(const std::string &name) const {
+  for (size_t i = scopes_.size(); i > 0; --i) {
+    if (scopes_[i - 1].contains(name)) {
+      return i - 1;
+    }
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,151 @@
+// Writes a synthetic Ode program to stdout whose size grows along one or more
+// independent axes, for finding compiler phases that scale badly:
+//
+//   ode-stress --functions 1000 --statements 50 > big.ode
+//
+// The same options and seed always produce the same program.
+
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Shape {
+  unsigned functions = 10;
+  unsigned statements = 10;
+  unsigned nesting = 1;
+  unsigned exprDepth = 2;
+  unsigned identifiers = 4;
+  unsigned identifierLength = 8;
+  unsigned seed = 1;
+};
+
+class Generator {
+public:
+  explicit Generator(const Shape &shape) : shape_(shape), random_(shape.seed) {
+    for (unsigned i = 0; i < shape_.identifiers; ++i) {
+      std::string name = std::format("v{}_", i);
+      while (name.size() < shape_.identifierLength) {
+        name += static_cast<char>('a' + name.size() % 26);
+      }
+      names_.push_back(std::move(name));
+    }
+  }
+
+  void program(std::ostream &out) {
+    for (unsigned i = 0; i < shape_.functions; ++i) {
+      function(out, i);
+    }
+
+    out << "fn main(): i32 {\n  let total: i32 = 0;\n";
+    for (unsigned i = 0; i < shape_.functions; ++i) {
+      out << std::format("  total = total + f{}({});\n", i, i % 7);
+    }
+    out << "  print(total);\n  return 0;\n}\n";
+  }
+
+private:
+  const Shape &shape_;
+  std::mt19937 random_;
+  std::vector<std::string> names_;
+
+  const std::string &anyName() {
+    return names_[random_() % names_.size()];
+  }
+
+  // Operands nest to the right, so depth is also the parser's recursion
+  // depth.
+  std::string expr(unsigned depth) {
+    std::string leaf =
+        random_() % 2 ? anyName() : std::to_string(random_() % 100);
+    if (depth == 0) {
+      return leaf;
+    }
+    static constexpr std::string_view ops[] = {"+", "-", "*"};
+    std::string_view op = ops[random_() % 3];
+    return std::format("({} {} {})", leaf, op, expr(depth - 1));
+  }
+
+  void function(std::ostream &out, unsigned index) {
+    out << std::format("fn f{}(a: i32): i32 {{\n", index);
+    for (unsigned i = 0; i < names_.size(); ++i) {
+      out << std::format("  let {}: i32 = a + {};\n", names_[i], i);
+    }
+
+    // Every nesting level opens a block that holds a share of the
+    // statements, so nesting does not change the statement count.
+    std::string indent = "  ";
+    for (unsigned level = 0; level < shape_.nesting; ++level) {
+      out << std::format("{}if (a > {}) {{\n", indent, level);
+      indent += "  ";
+    }
+    for (unsigned i = 0; i < shape_.statements; ++i) {
+      out << std::format("{}{} = {};\n", indent, anyName(),
+                         expr(shape_.exprDepth));
+    }
+    for (unsigned level = 0; level < shape_.nesting; ++level) {
+      indent.resize(indent.size() - 2);
+      out << indent << "}\n";
+    }
+
+    out << std::format("  return {};\n}}\n\n", names_.front());
+  }
+};
+
+unsigned parseCount(std::string_view option, const char *value) {
+  if (!value) {
+    throw std::runtime_error(std::format("missing value after '{}'", option));
+  }
+  std::string digits(value);
+  if (digits.empty() || digits.size() > 9 ||
+      digits.find_first_not_of("0123456789") != std::string::npos) {
+    throw std::runtime_error(
+        std::format("'{}' expects a number but got '{}'", option, digits));
+  }
+  return static_cast<unsigned>(std::stoul(digits));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Shape shape;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string_view arg = argv[i];
+      unsigned *target = nullptr;
+      if (arg == "--functions") {
+        target = &shape.functions;
+      } else if (arg == "--statements") {
+        target = &shape.statements;
+      } else if (arg == "--nesting") {
+        target = &shape.nesting;
+      } else if (arg == "--expr-depth") {
+        target = &shape.exprDepth;
+      } else if (arg == "--identifiers") {
+        target = &shape.identifiers;
+      } else if (arg == "--identifier-length") {
+        target = &shape.identifierLength;
+      } else if (arg == "--seed") {
+        target = &shape.seed;
+      } else {
+        throw std::runtime_error(std::format("unknown option '{}'", arg));
+      }
+      *target = parseCount(arg, i + 1 < argc ? argv[++i] : nullptr);
+    }
+    if (shape.identifiers == 0) {
+      throw std::runtime_error("'--identifiers' must be at least 1");
+    }
+  } catch (const std::runtime_error &err) {
+    std::cerr << "ode-stress: " << err.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  Generator(shape).program(std::cout);
+  return EXIT_SUCCESS;
+}
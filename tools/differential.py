@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Checks that the interpreter and compiled code print the same output.
+
+Every program is run with --interp and, at each optimization level, built
+into an executable and run. The script fails when any run's standard output
+differs from the interpreter's, or when the compiler or a program crashes.
+Exit statuses are not compared, since several examples fall off the end of
+main without returning a value.
+
+    tools/differential.py --ode build/ode examples/*.ode
+"""
+
+import argparse
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+
+def run(command, **kwargs):
+    result = subprocess.run(command, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE, text=True,
+                            timeout=60, **kwargs)
+    if result.returncode < 0:
+        raise RuntimeError(f"{' '.join(map(str, command))} failed with "
+                           f"signal {-result.returncode}:\n"
+                           f"{result.stderr[-2000:]}")
+    return result
+
+
+def check(args, source, workdir):
+    failures = []
+    expected = run([args.ode, "--interp", source])
+    if expected.stderr:
+        return [f"{source}: --interp failed:\n{expected.stderr[-2000:]}"]
+
+    for opt in args.opt:
+        executable = Path(workdir) / f"{Path(source).stem}-O{opt}"
+        built = run([args.ode, f"-O{opt}", "-o", executable, source],
+                    cwd=workdir)
+        if built.returncode != 0:
+            failures.append(f"{source} -O{opt}: compilation failed:\n"
+                            f"{built.stderr[-2000:]}")
+            continue
+        actual = run([executable])
+        if actual.stdout != expected.stdout:
+            failures.append(f"{source} -O{opt}: output differs from --interp\n"
+                            f"  interpreter: {expected.stdout.split()}\n"
+                            f"  compiled:    {actual.stdout.split()}")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ode", default="build/ode")
+    parser.add_argument("--opt", type=int, choices=range(4), action="append",
+                        help="optimization level to compare (repeatable); "
+                             "all by default")
+    parser.add_argument("sources", nargs="*",
+                        help="programs to run; examples/*.ode by default")
+    args = parser.parse_args()
+    args.ode = str(Path(args.ode).resolve())
+    args.opt = args.opt or list(range(4))
+    sources = args.sources or sorted(
+        str(path) for path in Path(__file__).parent.parent.glob(
+            "examples/*.ode"))
+
+    failures = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for source in sources:
+            source = str(Path(source).resolve())
+            try:
+                found = check(args, source, workdir)
+            except (RuntimeError, subprocess.TimeoutExpired) as err:
+                found = [str(err)]
+            print(f"{'FAIL' if found else 'ok':>4} {source}")
+            failures += found
+
+    for failure in failures:
+        print(f"FAIL {failure}", file=sys.stderr)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
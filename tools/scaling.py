@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Checks that no compiler phase grows superlinearly with its input.
+
+For every axis of ode-stress the program size is doubled a few times. Each
+size is compiled with --time-report, and the growth exponent of every phase
+between consecutive sizes is log2(t2 / t1), which is about 1 for a linear
+phase. The script fails when a phase's exponent exceeds --max-exponent or
+when the compiler crashes, for example by overflowing its stack on deep
+nesting.
+
+    tools/scaling.py --ode build/ode --stress build/ode-stress
+"""
+
+import argparse
+import math
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+# Axis, the base shape it starts from, and its starting size.
+AXES = {
+    "functions": ({"statements": 20}, 250),
+    "statements": ({"functions": 4}, 1000),
+    "nesting": ({"functions": 4, "statements": 4}, 128),
+    "expr-depth": ({"functions": 4, "statements": 4}, 64),
+    "identifiers": ({"functions": 4, "statements": 200}, 500),
+    "identifier-length": ({"functions": 50, "statements": 50}, 256),
+}
+
+PHASE = re.compile(r"^(.*\S)\s+([\d.]+) ms$")
+
+# Phase names end in the name of the module they ran on.
+MODULE = "stress"
+
+
+def compile_once(args, shape, workdir):
+    source = Path(workdir) / f"{MODULE}.ode"
+    command = [args.stress]
+    for axis, value in shape.items():
+        command += [f"--{axis}", str(value)]
+    with open(source, "w") as out:
+        subprocess.run(command, stdout=out, check=True)
+
+    result = subprocess.run(
+        [args.ode, "--time-report", "--emit=obj", "-o", "-", f"-O{args.opt}",
+         str(source)],
+        cwd=workdir, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+        text=True)
+    if result.returncode != 0:
+        reason = (f"signal {-result.returncode}" if result.returncode < 0
+                  else f"exit code {result.returncode}")
+        raise RuntimeError(f"ode failed with {reason} on {shape}:\n"
+                           f"{result.stderr[-2000:]}")
+
+    times = {}
+    for line in result.stderr.splitlines():
+        match = PHASE.match(line)
+        if match:
+            name = match.group(1).removesuffix(f" {MODULE}")
+            times[name] = times.get(name, 0.0) + float(match.group(2))
+    return times
+
+
+def best_of(args, shape, workdir):
+    runs = [compile_once(args, shape, workdir) for _ in range(args.repeat)]
+    return {phase: min(run[phase] for run in runs) for phase in runs[0]}
+
+
+def check_axis(args, axis, workdir):
+    base, start = AXES[axis]
+    failures = []
+    previous = None
+    size = start * args.scale
+    for _ in range(args.steps):
+        shape = dict(base, **{axis: size})
+        times = best_of(args, shape, workdir)
+        row = "  ".join(f"{phase} {ms:.1f}" for phase, ms in times.items()
+                        if phase != "total")
+        print(f"{axis:>18} {size:>8}: {row}")
+
+        if previous:
+            for phase, ms in times.items():
+                # Phases this short are dominated by noise.
+                if previous.get(phase, 0) < args.min_ms:
+                    continue
+                exponent = math.log2(max(ms, 1e-9) / previous[phase])
+                if exponent > args.max_exponent:
+                    failures.append(f"{axis}: '{phase}' grew as n^"
+                                    f"{exponent:.2f} from {size // 2} "
+                                    f"to {size}")
+        previous = times
+        size *= 2
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ode", default="build/ode")
+    parser.add_argument("--stress", default="build/ode-stress")
+    parser.add_argument("--axis", choices=AXES, action="append",
+                        help="check only this axis (repeatable)")
+    parser.add_argument("--steps", type=int, default=4,
+                        help="number of sizes per axis, each double the last")
+    parser.add_argument("--scale", type=int, default=1,
+                        help="multiplies every starting size")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="compilations per size; the fastest is kept")
+    parser.add_argument("--opt", type=int, default=0, choices=range(4))
+    parser.add_argument("--max-exponent", type=float, default=1.5)
+    parser.add_argument("--min-ms", type=float, default=5.0)
+    args = parser.parse_args()
+
+    failures = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for axis in args.axis or AXES:
+            try:
+                failures += check_axis(args, axis, workdir)
+            except RuntimeError as err:
+                failures.append(str(err))
+
+    for failure in failures:
+        print(f"FAIL {failure}", file=sys.stderr)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())